@@ -18,19 +18,114 @@
 
 #include "camera_app.h"
 #include <stdint.h>
+#include "xil_cache.h"
+
+// Set to 1 to run the reference kernel next to the fast (NEON) one and
+// report every frame in which they disagree
+#define VERIFY_SW_KERNEL 0
+
+// Software ISP pipeline: the fused Bayer to 4:2:2 kernel, or the
+// individual stages with the RGB stages in between
+#define SW_PIPELINE_FUSED  0
+#define SW_PIPELINE_STAGED 1
+#define SW_PIPELINE SW_PIPELINE_FUSED
+
+// Staged pipeline only: draw a box around the middle quarter of the frame
+// (a framing guide) after the 4:2:2 stage. Off, the staged pipeline gives
+// the fused kernel's pixels.
+#define SW_OVERLAY 0
+
+// Software demosaic: bilinear (fastest, and the only one the fused kernel
+// does) or the gradient-corrected 5x5 kernel (sharper edges, much less
+// colour fringing, but 4.6-4.9 times the bilinear demosaic's time in the
+// host bench's scalar build; not yet timed on the Cortex-A9)
+#define SW_DEMOSAIC_BILINEAR 0
+#define SW_DEMOSAIC_MHC      1
+#define SW_DEMOSAIC SW_DEMOSAIC_BILINEAR
+
+// Automatic white balance from statistics gathered during the demosaic
+// pass; the gains take effect on the next frame
+#define SW_AWB_OFF         0
+#define SW_AWB_GRAY_WORLD  1
+#define SW_AWB_WHITE_PATCH 2
+#define SW_AWB SW_AWB_GRAY_WORLD
+
+// Automatic exposure and gain: the sensor's exposure time and gains are
+// adjusted from statistics gathered during the demosaic pass, and written
+// at the start of a frame period (see aec.h)
+#define SW_AEC 1
+
+// Preview mode: 2x2 bin the mosaic instead of demosaicking it, for a
+// half-size image (960x540 at 1080p) centred on a black screen. A quarter
+// of the pixels go through the stages after the binning, which leaves
+// room for heavier processing at the full frame rate. Overrides
+// SW_PIPELINE and SW_DEMOSAIC.
+#define SW_PREVIEW 0
+
+// Region-of-interest mode: the ISP pipeline runs only on the ROIs (the
+// middle quarter of the frame by default), so its CPU time scales with
+// their area. In place, the rest of the frame is shown as it came from
+// the sensor; with SW_ROI_COPY the frame goes to the output stores, the
+// rest of it copied by the PS DMA controller while the CPU works on the
+// ROIs (see roi.h).
+#define SW_ROI_OFF      0
+#define SW_ROI_IN_PLACE 1
+#define SW_ROI_COPY     2
+#define SW_ROI SW_ROI_OFF
+
+#if SW_PREVIEW && SW_ROI != SW_ROI_OFF
+#error "SW_PREVIEW and SW_ROI cannot be used together"
+#endif
+
+// Temporal noise reduction on the 4:2:2 output, against the previous
+// filtered frame (see tnr.h). The history is a frame store of its own
+// past the output stores; only the CPU reads or writes it. Off by
+// default: in the host bench it adds about half the fused stage's time
+// to every frame.
+#define SW_TNR 0
+#define SW_TNR_MEM_OFFSET 0x02000000
+
+#if SW_TNR && SW_ROI != SW_ROI_OFF
+#error "SW_TNR keeps a history of whole frames, not of ROIs"
+#endif
+
+// The preview and the ROI copy mode write to their own set of frame
+// stores, past the capture stores, and the MM2S channel reads those while
+// the loop runs
+#define SW_OUTPUT_STORES (SW_PREVIEW || SW_ROI == SW_ROI_COPY)
+#define SW_OUTPUT_MEM_OFFSET 0x01000000
+#define SW_OUTPUT_BLACK      0x8010          // Cb/Cr 128, Y 16
+
+// Tone curve every pipeline starts with (the fused kernel applies it
+// between its demosaic and CSC); it can be changed or uploaded over the
+// UART while running (see tone.h)
+#define SW_TONE_CURVE TONE_PRESET_LINEAR
 
-static uint16_t average_vert(int i, volatile Xuint16 * mem);
-static uint16_t average_hor(int i, volatile Xuint16 * mem);
-static uint16_t average_x(int i, volatile Xuint16 * mem);
-static uint8_t *color_lut;
-static void fill_color_lut();
 camera_config_t camera_config;
-
-enum color {
-	RED,
-	GREEN,
-	BLUE
-};
+static csc_coef_t csc_coef;
+static isp_pipeline_t isp_pipeline;
+static isp_wb_t isp_wb = { { 256, 256, 256 } };
+static tone_t tone;
+#if SW_OVERLAY
+static isp_overlay_t isp_overlay;
+#endif
+static frame_sync_t frame_sync;
+static tbuf_t triple_buffer;
+#if SW_AWB != SW_AWB_OFF
+static awb_t awb;
+#endif
+#if SW_AEC
+static aec_t aec;
+#endif
+#if SW_TNR
+static tnr_t tnr;
+#endif
+#if SW_ROI != SW_ROI_OFF
+static roi_set_t rois;
+#endif
+#if SW_ROI == SW_ROI_COPY
+static dma2d_t dma;
+#endif
 
 int HEIGHT;
 int WIDTH;
@@ -43,6 +138,9 @@ int main() {
 
 	camera_config_init(&camera_config);
 	fmc_imageon_enable(&camera_config);
+	intc_init(&camera_config.intc, camera_config.uDeviceId_IntC);
+	amp_init();
+	perf_init();
 	camera_loop(&camera_config);
 
 	return 0;
@@ -64,6 +162,8 @@ void camera_config_init(camera_config_t *config) {
     config->uDeviceId_VTC_ipipe = XPAR_V_TC_0_DEVICE_ID;
     config->uDeviceId_VTC_tpg   = XPAR_V_TC_1_DEVICE_ID;
 
+    config->uDeviceId_IntC = XPAR_SCUGIC_0_DEVICE_ID;
+
     config->uDeviceId_VDMA_HdmiFrameBuffer = XPAR_AXI_VDMA_0_DEVICE_ID;
     config->uBaseAddr_MEM_HdmiFrameBuffer = XPAR_DDR_MEM_BASEADDR + 0x10000000;
     config->uNumFrames_HdmiFrameBuffer = XPAR_AXIVDMA_0_NUM_FSTORES;
@@ -71,204 +171,296 @@ void camera_config_init(camera_config_t *config) {
     return;
 }
 
-// Main (SW) processing loop. Recommended to have an explicit exit condition
-void camera_loop(camera_config_t *config) {
-	printf("Made it camera_loop\r\n");
-	WIDTH =  config->hdmio_width;
-	HEIGHT = config->hdmio_height;
-	FRAME_LEN = WIDTH * HEIGHT;
-	color_lut = malloc(FRAME_LEN * sizeof(*color_lut));
-	if (color_lut == NULL)
-		xil_printf("\n\n\n\n\n\nYOU DON F'ED UP!!!!!!!!!!!!!!!!!!!!!!!!!!\n\n\n\n\n");
-	fill_color_lut();
-	Xuint32 parkptr;
-	Xuint32 vdma_S2MM_DMACR, vdma_MM2S_DMACR;
-	int i, j;
-
-
-	xil_printf("Entering main SW processing loop\r\n");
-
-
-	// Grab the DMA parkptr, and update it to ensure that when parked, the S2MM side is on frame 0, and the MM2S side on frame 1
-	parkptr = XAxiVdma_ReadReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_PARKPTR_OFFSET);
-	parkptr &= ~XAXIVDMA_PARKPTR_READREF_MASK;
-	parkptr &= ~XAXIVDMA_PARKPTR_WRTREF_MASK;
-	parkptr |= 0x1;
-	XAxiVdma_WriteReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_PARKPTR_OFFSET, parkptr);
-
-	// Grab the DMA Control Registers, and clear circular park mode.
-	vdma_MM2S_DMACR = XAxiVdma_ReadReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_TX_OFFSET+XAXIVDMA_CR_OFFSET);
-	XAxiVdma_WriteReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_TX_OFFSET+XAXIVDMA_CR_OFFSET, vdma_MM2S_DMACR & ~XAXIVDMA_CR_TAIL_EN_MASK);
-	vdma_S2MM_DMACR = XAxiVdma_ReadReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_RX_OFFSET+XAXIVDMA_CR_OFFSET);
-	XAxiVdma_WriteReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_RX_OFFSET+XAXIVDMA_CR_OFFSET, vdma_S2MM_DMACR & ~XAXIVDMA_CR_TAIL_EN_MASK);
-
-	// Pointers to the S2MM memory frame and M2SS memory frame
-	volatile Xuint16 *pS2MM_Mem = (Xuint16 *)XAxiVdma_ReadReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_S2MM_ADDR_OFFSET+XAXIVDMA_START_ADDR_OFFSET);
-	volatile Xuint16 *pMM2S_Mem = (Xuint16 *)XAxiVdma_ReadReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_MM2S_ADDR_OFFSET+XAXIVDMA_START_ADDR_OFFSET+4);
-
-	uint16_t R, G, B;
-	uint16_t Y, CB, CR;
-
-	printf("Made it before loop\r\n");
-	printf("Width: %d, Height: %d\n", WIDTH, HEIGHT);
-
-	// Run for 1000 frames before going back to HW mode
-	for (j = 0; j < 1000; j++) {
-		for (i = 0 ; i < WIDTH*HEIGHT; i++) {
-			//pMM2S_Mem[i] = pS2MM_Mem[1920*1080-i-1] % 255; // made it all very green!
-			//pMM2S_Mem[i] = pS2MM_Mem[1920*1080-i+j-1]; // makes the image slowly shift to the right and wrap around.
-			//pMM2S_Mem[i] = pS2MM_Mem[i];
-
-			switch (color_lut[i]) {
-				case RED:
-					R = pS2MM_Mem[i] & 0xFF;
-					G = average_vert(i, pS2MM_Mem);
-					B = average_x(i, pS2MM_Mem);
-					break;
-				case GREEN:
-					G = pS2MM_Mem[i] & 0xFF;
-					if ( (i+1 < FRAME_LEN) && (color_lut[i+1] == RED)) {
-						R = average_hor(i, pS2MM_Mem);
-						B = average_vert(i, pS2MM_Mem);
-					} else if ( (i-1 > 0) && (color_lut[i-1] == BLUE)){
-						R = average_vert(i, pS2MM_Mem);
-						B = average_hor(i, pS2MM_Mem);
-					}
-					break;
-				case BLUE:
-					R = average_x(i, pS2MM_Mem);
-					G = average_vert(i, pS2MM_Mem);
-					B = pS2MM_Mem[i] & 0xFF;
-					break;
-				default:
-					R = 0;
-					G = 0;
-					B = 0;
-					break;
-			}
-//			R = 82;
-//			G = 232;
-//			B = 255;
-
-			//printf("R: %d, G: %d, B: %d\r\n", R, G, B);
-
-			Y  = ( 0.183 * R + 0.614 * G + 0.062 * B) + 16;
-			CB = (-0.101 * R - 0.338 * G + 0.439 * B) + 128;
-			CR = ( 0.439 * R - 0.399 * G - 0.040 * B) + 128;
-
-			//printf("Y: %X, Cb: %X, Cr: %X\r\n", Y, CB, CR);
-
-//			Y = Y & 0xFF00;
-//			CB = CB & 0xFF00;
-//			CR = CR & 0xFF00;
-
-//			pMM2S_Mem[i] = pS2MM_Mem[i];
-
-			//Cr Y
-			if (i%2){
-				pMM2S_Mem[i] =  CR<<8 | Y;
-			}
-			//Cb Y
-			else {
-				pMM2S_Mem[i] =  CB<<8 | Y;
-			}
+// Build the software ISP pipeline
+static void camera_pipeline_init(camera_config_t *config) {
+	tone_init(&tone, SW_TONE_CURVE, &csc_coef);
+	tone_uart_init(&tone, &config->intc);
+
+	isp_init(&isp_pipeline);
+#if SW_AEC
+	// Sparse exposure statistics, also from the untouched Bayer lines
+	aec_init(&aec, &config->vita_receiver, config->vita_exposure, config->vita_again, config->vita_dgain);
+	isp_add_stage(&isp_pipeline, "aec stats", aec_stage_stats, &aec);
+	config->vita_aec = 1;
+#endif
+#if SW_AWB != SW_AWB_OFF
+	// Statistics first, while the Bayer lines are untouched. The fused
+	// paths get the gains as the CSC's input gains; the staged one
+	// has a white balance stage ahead of the gamma curve for them.
+	isp_add_stage(&isp_pipeline, "awb stats", awb_stage_stats, &awb);
+#if SW_PIPELINE == SW_PIPELINE_STAGED && !SW_PREVIEW
+	awb_init(&awb, (SW_AWB == SW_AWB_WHITE_PATCH) ? AWB_MODE_WHITE_PATCH : AWB_MODE_GRAY_WORLD,
+			&csc_coef, NULL, &isp_wb);
+#else
+	awb_init(&awb, (SW_AWB == SW_AWB_WHITE_PATCH) ? AWB_MODE_WHITE_PATCH : AWB_MODE_GRAY_WORLD,
+			&csc_coef, &csc_coef, NULL);
+#endif
+#endif
+#if SW_PREVIEW
+	isp_add_stage(&isp_pipeline, "bin 2x2", isp_stage_bin2, NULL);
+	isp_add_stage(&isp_pipeline, "tone", tone_stage, &tone);
+	isp_add_stage(&isp_pipeline, "csc", isp_stage_csc, &csc_coef);
+	isp_add_stage(&isp_pipeline, "4:2:2", isp_stage_422, NULL);
+#elif SW_PIPELINE == SW_PIPELINE_FUSED && SW_DEMOSAIC == SW_DEMOSAIC_MHC
+	isp_add_stage(&isp_pipeline, "demosaic 5x5", isp_stage_demosaic_mhc, NULL);
+	isp_add_stage(&isp_pipeline, "tone", tone_stage, &tone);
+	isp_add_stage(&isp_pipeline, "csc", isp_stage_csc, &csc_coef);
+	isp_add_stage(&isp_pipeline, "4:2:2", isp_stage_422, NULL);
+#elif SW_PIPELINE == SW_PIPELINE_FUSED
+#if VERIFY_SW_KERNEL
+	isp_add_stage(&isp_pipeline, "bayer2ycbcr/ref", tone_stage_bayer2ycbcr_verify, &tone);
+#else
+	isp_add_stage(&isp_pipeline, "bayer2ycbcr", tone_stage_bayer2ycbcr, &tone);
+#endif
+#else
+	// Unity gains until something better is plugged in
+#if SW_OVERLAY
+	isp_overlay.x = config->hdmio_width / 4 & ~1;
+	isp_overlay.y = config->hdmio_height / 4;
+	isp_overlay.w = config->hdmio_width / 2 & ~1;
+	isp_overlay.h = config->hdmio_height / 2;
+	isp_overlay.thickness = 4;
+	isp_overlay.Y = 235;
+	isp_overlay.Cb = 128;
+	isp_overlay.Cr = 128;
+#endif
+
+#if SW_DEMOSAIC == SW_DEMOSAIC_MHC
+	isp_add_stage(&isp_pipeline, "demosaic 5x5", isp_stage_demosaic_mhc, NULL);
+#else
+	isp_add_stage(&isp_pipeline, "demosaic", isp_stage_demosaic, NULL);
+#endif
+	isp_add_stage(&isp_pipeline, "white balance", isp_stage_white_balance, &isp_wb);
+	isp_add_stage(&isp_pipeline, "tone", tone_stage, &tone);
+	isp_add_stage(&isp_pipeline, "csc", isp_stage_csc, &csc_coef);
+	isp_add_stage(&isp_pipeline, "4:2:2", isp_stage_422, NULL);
+#if SW_OVERLAY
+	isp_add_stage(&isp_pipeline, "overlay", isp_stage_overlay, &isp_overlay);
+#endif
+#endif
+#if SW_TNR
+	// Last, on the finished 4:2:2 lines
+	tnr_init(&tnr, (Xuint16 *)(config->uBaseAddr_MEM_HdmiFrameBuffer + SW_TNR_MEM_OFFSET),
+			TNR_ALPHA_MIN, TNR_NOISE_LEVEL, TNR_MOTION_LEVEL);
+	isp_add_stage(&isp_pipeline, "tnr", tnr_stage, &tnr);
+#endif
+}
 
+#if SW_ROI != SW_ROI_OFF
+// The ROIs, and the DMA channel for the rest of the frame. Returns
+// XST_FAILURE if no ROI could be set up.
+static int camera_roi_init(camera_config_t *config) {
+#if SW_ROI == SW_ROI_COPY
+	if (dma2d_init(&dma, DMA2D_DEVICE_ID, DMA2D_CHANNEL) == XST_SUCCESS) {
+		roi_init(&rois, &dma);
+	} else {
+		xil_printf("No DMA channel, the CPU will copy the rest of the frame\r\n");
+		roi_init(&rois, NULL);
+	}
+#else
+	roi_init(&rois, NULL);
+#endif
 
+	return roi_add(&rois, WIDTH / 4 / ROI_ALIGN * ROI_ALIGN, HEIGHT / 4 & ~1,
+			WIDTH / 2 / ROI_ALIGN * ROI_ALIGN, HEIGHT / 2 & ~1, WIDTH, HEIGHT);
+}
+#endif
+
+#if SW_OUTPUT_STORES
+// Point the MM2S channel at the output stores, cleared to black; the
+// same store indices as the capture stores, so the triple buffer rotation
+// works unchanged
+static int camera_output_start(camera_config_t *config) {
+	Xuint32 addr = config->uBaseAddr_MEM_HdmiFrameBuffer + SW_OUTPUT_MEM_OFFSET;
+	Xuint16 *store;
+	int i, n;
+
+	for (i = 0; i < config->uNumFrames_HdmiFrameBuffer; i++) {
+		store = (Xuint16 *)(addr + i * FRAME_LEN * sizeof(Xuint16));
+		for (n = 0; n < FRAME_LEN; n++) {
+			store[n] = SW_OUTPUT_BLACK;
 		}
 	}
+	Xil_DCacheFlushRange(addr, config->uNumFrames_HdmiFrameBuffer * FRAME_LEN * sizeof(Xuint16));
 
+	return vfb_tx_setup(&config->vdma_hdmi, &config->vdmacfg_hdmi_read, config->hdmio_resolution,
+			config->hdmio_resolution, addr, config->uNumFrames_HdmiFrameBuffer);
+}
 
-	// Grab the DMA Control Registers, and re-enable circular park mode.
-	vdma_MM2S_DMACR = XAxiVdma_ReadReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_TX_OFFSET+XAXIVDMA_CR_OFFSET);
-	XAxiVdma_WriteReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_TX_OFFSET+XAXIVDMA_CR_OFFSET, vdma_MM2S_DMACR | XAXIVDMA_CR_TAIL_EN_MASK);
-	vdma_S2MM_DMACR = XAxiVdma_ReadReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_RX_OFFSET+XAXIVDMA_CR_OFFSET);
-	XAxiVdma_WriteReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_RX_OFFSET+XAXIVDMA_CR_OFFSET, vdma_S2MM_DMACR | XAXIVDMA_CR_TAIL_EN_MASK);
-
-
-	xil_printf("Main SW processing loop complete!\r\n");
-
+// Where the output for the frame in capture store index goes: the same
+// store of the output set. The binned preview is centred the way
+// vfb_tx_setup() centres a smaller video in its storage (storage_offset),
+// on a whole pixel pair.
+static Xuint16 *camera_output_frame(camera_config_t *config, int index) {
+#if SW_PREVIEW
+	Xuint32 offset = (HEIGHT - HEIGHT / 2) / 2 * WIDTH + ((WIDTH - WIDTH / 2) / 2 & ~1);
+#else
+	Xuint32 offset = 0;
+#endif
+
+	return (Xuint16 *)config->vdmacfg_hdmi_read.FrameStoreStartAddr[index] + offset;
+}
 
-	return;
+// Back to the capture stores for HW mode
+static void camera_output_stop(camera_config_t *config) {
+	vfb_tx_setup(&config->vdma_hdmi, &config->vdmacfg_hdmi_read, config->hdmio_resolution,
+			config->hdmio_resolution, config->uBaseAddr_MEM_HdmiFrameBuffer, config->uNumFrames_HdmiFrameBuffer);
 }
+#endif
 
-static uint16_t average_vert(int i, volatile Xuint16 * mem) {
-	int average = 0;
-	int count = 0;
-	// Not on the top bound
-	if (i > WIDTH){
-		count++;
-		average += mem[i - WIDTH] & 0xFF;
-	}
-	// Not on the bottom bound
-	if (i < FRAME_LEN - WIDTH) {
-		count++;
-		average += mem[i + WIDTH] & 0xFF;
+// Main (SW) processing loop. Recommended to have an explicit exit condition
+void camera_loop(camera_config_t *config) {
+	printf("Made it camera_loop\r\n");
+	WIDTH =  config->hdmio_width;
+	HEIGHT = config->hdmio_height;
+	FRAME_LEN = WIDTH * HEIGHT;
+	int mismatches;
+	Xuint16 *pFrame, *pOut;
+	perf_probe_t probe;
+
+	// The colour standard of csc.h, which the hardware pipeline's
+	// rgb2ycrcb core also runs with CSC_PROGRAM_CORE
+	if (csc_coef_from_standard(&csc_coef, CSC_STANDARD, CSC_INPUT_RANGE) != 0) {
+		xil_printf("Invalid CSC standard, using the default conversion\r\n");
+		csc_coef_default(&csc_coef);
 	}
 
-	average /= count;
-	return average;
-}
 
-static uint16_t average_hor(int i, volatile Xuint16 * mem) {
-	int average = 0;
-	int count = 0;
-	// Not on the left bound
-	if (i % WIDTH != 0) {
-		count++;
-		average += mem[i - 1] & 0xFF;
+	camera_pipeline_init(config);
+	if (isp_select_kernels(&isp_pipeline, config->hdmio_resolution, WIDTH) == XST_SUCCESS)
+		isp_time_kernels(&isp_pipeline);
+	else
+		xil_printf("No %s kernels, using the generic ones\r\n", vres_get_name(config->hdmio_resolution));
+#if SW_ROI != SW_ROI_OFF
+	if (camera_roi_init(config) != XST_SUCCESS) {
+		xil_printf("Could not set up the ROIs\r\n");
+		return;
 	}
-	//Not on the right bound
-	if ((i % WIDTH) != (WIDTH-1)) {
-		count++;
-		average += mem[i + 1] & 0xFF;
+#endif
+#if SW_OUTPUT_STORES
+	if (camera_output_start(config) != XST_SUCCESS) {
+		xil_printf("Could not set up the output frame stores\r\n");
+		return;
 	}
+#endif
+#if SW_PREVIEW
+	xil_printf("Preview: %d x %d, binned 2x2\r\n", WIDTH / 2, HEIGHT / 2);
+#endif
 
-	average /= count;
-	return average;
-}
+	xil_printf("Entering main SW processing loop\r\n");
 
-static uint16_t average_x(int i, volatile Xuint16 * mem) {
-	int average = 0;
-	int count = 0;
 
-	// Top Left
-	if (i > WIDTH && ((i % WIDTH) != 0)) {
-		count++;
-		average += mem[i - WIDTH -1] & 0xFF;
-	}
-	// Top Right
-	if (i > WIDTH && ((i % WIDTH) != (WIDTH-1))) {
-		count++;
-		average += mem[i - WIDTH +1] & 0xFF;
-	}
-	// Bottom Left
-	if (i < FRAME_LEN && ((i % WIDTH) != 0)) {
-		count++;
-		average += mem[i + WIDTH -1] & 0xFF;
-	}
-	// Bottom Right
-	if (i < FRAME_LEN && ((i % WIDTH) != (WIDTH-1))) {
-		count++;
-		average += mem[i + WIDTH +1] & 0xFF;
+	// Park the S2MM and MM2S channels on separate frame stores, and rotate
+	// the three stores between capture, conversion and display
+	if (tbuf_init(&triple_buffer, &config->vdma_hdmi, &config->vdmacfg_hdmi_write) != XST_SUCCESS) {
+		xil_printf("Could not park the VDMA channels\r\n");
+#if SW_OUTPUT_STORES
+		camera_output_stop(config);
+#endif
+		return;
 	}
 
-	average /= count;
-	return average;
-}
+	printf("Made it before loop\r\n");
+	printf("Width: %d, Height: %d\n", WIDTH, HEIGHT);
 
-static void fill_color_lut() {
-	uint32_t y, x;
-	for (y = 0; y < HEIGHT; y++) {
-		for(x = 0; x < WIDTH; x = x+2) {
-			if (y %2) {
-				color_lut[y*WIDTH + x] = GREEN;
-				color_lut[y*WIDTH + x+1] = BLUE;
-			} else {
-				color_lut[y*WIDTH + x] = RED;
-				color_lut[y*WIDTH + x+1] = GREEN;
-			}
+	// Process each frame the S2MM channel completes, once, until 1000
+	// frames have been processed, then go back to HW mode
+	if (fsync_init(&frame_sync, &config->intc, &config->vdma_hdmi) != XST_SUCCESS) {
+		xil_printf("Frame-done interrupt setup failed\r\n");
+		tbuf_stop(&triple_buffer);
+#if SW_OUTPUT_STORES
+		camera_output_stop(config);
+#endif
+		return;
+	}
+	amp_report_reset();
+	isp_reset_stats(&isp_pipeline);
+	fsync_start(&frame_sync);
+	while (frame_sync.processed < 1000) {
+		if (fsync_wait(&frame_sync) != XST_SUCCESS) {
+			xil_printf("No frame from the S2MM channel, leaving SW mode\r\n");
+			break;
+		}
+		perf_begin(&probe);
+#if SW_AEC
+		// Start of a frame period: the sensor settings staged after the
+		// last frame go out in one batch
+		if (aec_apply(&aec)) {
+			config->vita_exposure = aec.current.exposure;
+			config->vita_again = aec.current.again;
+			config->vita_dgain = aec.current.dgain;
 		}
+#endif
+		pFrame = tbuf_acquire(&triple_buffer);
+#if SW_OUTPUT_STORES
+		pOut = camera_output_frame(config, triple_buffer.work);
+#else
+		pOut = pFrame;
+#endif
+
+		// Run the ISP pipeline over the frame (in place, unless writing to
+		// the output stores), one RGGB quad row (two lines) at a time. Core
+		// 0 takes the top half and core 1 the bottom half; the call returns
+		// once both halves are back in DDR. In ROI mode each ROI is split
+		// that way in turn.
+#if SW_ROI != SW_ROI_OFF
+		mismatches = roi_frame(&rois, &isp_pipeline, pFrame, pOut, WIDTH, HEIGHT);
+#else
+		mismatches = amp_isp_frame(&isp_pipeline, pFrame, pOut, WIDTH, HEIGHT);
+#endif
+		if (mismatches)
+			xil_printf("Frame %d: %d words differ from the reference kernel\r\n", frame_sync.processed, mismatches);
+#if SW_TNR
+		tnr_frame_done(&tnr);
+#endif
+#if SW_AWB != SW_AWB_OFF
+		awb_update(&awb);
+#endif
+#if SW_AEC
+		aec_update(&aec);
+#endif
+		// A curve loaded during this frame is used from the next one on
+		tone_uart_poll(&tone);
+		tone_swap(&tone);
+
+		tbuf_present(&triple_buffer);
+		perf_end(&probe, PERF_CAMERA_LOOP, FRAME_LEN);
+		fsync_done(&frame_sync);
 	}
+	fsync_stop(&frame_sync);
+	fsync_report(&frame_sync);
+	amp_report();
+	isp_report(&isp_pipeline);
+#if SW_AWB != SW_AWB_OFF
+	awb_report(&awb);
+#endif
+#if SW_AEC
+	aec_report(&aec);
+	// The sensor keeps the last settings; nothing adjusts them in HW mode
+	config->vita_aec = 0;
+#endif
+	tone_report(&tone);
+#if SW_TNR
+	tnr_report(&tnr);
+#endif
+#if SW_ROI != SW_ROI_OFF
+	roi_report(&rois, WIDTH, HEIGHT);
+#endif
+#if SW_ROI == SW_ROI_COPY
+	dma2d_report(&dma);
+#endif
+	tbuf_report(&triple_buffer);
+	perf_summary();
+
+	// Re-enable circular park mode
+	tbuf_stop(&triple_buffer);
+#if SW_OUTPUT_STORES
+	camera_output_stop(config);
+#endif
+
+
+	xil_printf("Main SW processing loop complete!\r\n");
 
 
+	return;
 }
@@ -34,6 +34,28 @@
 #include "xvtc.h"
 #include "xaxivdma.h"
 #include "xtpg_app.h"
+#include "video_resolution.h"
+#include "demosaic.h"
+#include "csc.h"
+#include "bayer2ycbcr.h"
+#include "line_buffer.h"
+#include "amp.h"
+#include "isp.h"
+#include "frame_sync.h"
+#include "triple_buffer.h"
+#include "perf.h"
+#include "awb.h"
+#include "aec.h"
+#include "raw10.h"
+#include "tone.h"
+#include "tnr.h"
+#include "dma2d.h"
+#include "roi.h"
+#include "still.h"
+#include "capture_store.h"
+#include "dma_queue.h"
+#include "input.h"
+#include "zoom.h"
 
 
 // Constants for library code
@@ -60,6 +82,10 @@ struct struct_camera_config_t {
 	Xuint32 uBaseAddr_CRES;
 	Xuint32 uBaseAddr_RGBYCC;
 
+	// Interrupt controller
+	Xuint32 uDeviceId_IntC;
+	XScuGic intc;
+
 	// Frame Buffer memory addresses
 	Xuint32 uDeviceId_VDMA_HdmiFrameBuffer;
 	Xuint32 uBaseAddr_VDMA_HdmiFrameBuffer;
@@ -98,32 +124,6 @@ struct struct_camera_config_t {
 }; typedef struct struct_camera_config_t camera_config_t;
 
 
-// Video resolution macros and structure
-#define VIDEO_RESOLUTION_VGA       0
-#define VIDEO_RESOLUTION_NTSC      1
-#define VIDEO_RESOLUTION_SVGA      2
-#define VIDEO_RESOLUTION_XGA       3
-#define VIDEO_RESOLUTION_720P      4
-#define VIDEO_RESOLUTION_SXGA      5
-#define VIDEO_RESOLUTION_1080P     6
-#define VIDEO_RESOLUTION_UXGA      7
-#define NUM_VIDEO_RESOLUTIONS      8
-
-struct struct_vres_timing_t {
-	char *pName;
-	Xuint32 VActiveVideo;
-	Xuint32 VFrontPorch;
-	Xuint32 VSyncWidth;
-	Xuint32 VBackPorch;
-	Xuint32 VSyncPolarity;
-	Xuint32 HActiveVideo;
-	Xuint32 HFrontPorch;
-	Xuint32 HSyncWidth;
-	Xuint32 HBackPorch;
-	Xuint32 HSyncPolarity;
-}; typedef struct struct_vres_timing_t vres_timing_t;
-
-
 // Function prototypes (camera_app.c)
 void camera_config_init(camera_config_t *config);
 void camera_loop(camera_config_t *config);
@@ -138,13 +138,6 @@ void enable_ssc(camera_config_t *config);
 
 
 
-// Function prototypes (video_resolution.c)
-char * vres_get_name(Xuint32 resolutionId);
-Xuint32 vres_get_width(Xuint32 resolutionId);
-Xuint32 vres_get_height(Xuint32 resolutionId);
-Xuint32 vres_get_timing(Xuint32 resolutionId, vres_timing_t *pTiming);
-Xint32 vres_detect(Xuint32 width, Xuint32 height);
-
 // Function prototypes (video_generator.c)
 int vgen_init(XVtc *pVtc, u16 VtcDeviceID);
 int vgen_config(XVtc *pVtc, int ResolutionId, int bVerbose);
@@ -162,6 +155,7 @@ int vfb_rx_start( XAxiVdma *pAxiVdma );
 int vfb_rx_stop ( XAxiVdma *pAxiVdma );
 int vfb_tx_init( XAxiVdma *pAxiVdma, XAxiVdma_DmaSetup *pReadCfg , Xuint32 uVideoResolution, Xuint32 uStorageResolution, Xuint32 uMemAddr, Xuint32 uNumFrames );
 int vfb_tx_setup( XAxiVdma *pAxiVdma, XAxiVdma_DmaSetup *pReadCfg , Xuint32 uVideoResolution, Xuint32 uStorageResolution, Xuint32 uMemAddr, Xuint32 uNumFrames );
+int vfb_tx_window( XAxiVdma *pAxiVdma, XAxiVdma_DmaSetup *pReadCfg, Xuint32 uAddr, Xuint32 uStride, Xuint32 uNumFrames );
 int vfb_tx_start( XAxiVdma *pAxiVdma );
 int vfb_tx_stop ( XAxiVdma *pAxiVdma );
 int vfb_dump_registers( XAxiVdma *pAxiVdma);
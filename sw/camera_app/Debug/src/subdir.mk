@@ -4,41 +4,110 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../src/aec.c \
+../src/amp.c \
+../src/awb.c \
+../src/bayer2ycbcr.c \
 ../src/camera_app.c \
+../src/capture_store.c \
+../src/csc.c \
+../src/demosaic.c \
+../src/demosaic_bin.c \
+../src/demosaic_mhc.c \
+../src/dma2d.c \
+../src/dma_queue.c \
 ../src/fmc_imageon_utils.c \
+../src/frame_sync.c \
+../src/input.c \
+../src/isp.c \
+../src/line_buffer.c \
+../src/perf.c \
+../src/raw10.c \
+../src/roi.c \
+../src/still.c \
+../src/tnr.c \
+../src/tone.c \
+../src/triple_buffer.c \
 ../src/video_detector.c \
 ../src/video_frame_buffer.c \
 ../src/video_generator.c \
 ../src/video_resolution.c \
-../src/xtpg_app.c 
+../src/xtpg_app.c \
+../src/zoom.c 
 
 LD_SRCS += \
 ../src/lscript.ld 
 
 OBJS += \
+./src/aec.o \
+./src/amp.o \
+./src/awb.o \
+./src/bayer2ycbcr.o \
 ./src/camera_app.o \
+./src/capture_store.o \
+./src/csc.o \
+./src/demosaic.o \
+./src/demosaic_bin.o \
+./src/demosaic_mhc.o \
+./src/dma2d.o \
+./src/dma_queue.o \
 ./src/fmc_imageon_utils.o \
+./src/frame_sync.o \
+./src/input.o \
+./src/isp.o \
+./src/line_buffer.o \
+./src/perf.o \
+./src/raw10.o \
+./src/roi.o \
+./src/still.o \
+./src/tnr.o \
+./src/tone.o \
+./src/triple_buffer.o \
 ./src/video_detector.o \
 ./src/video_frame_buffer.o \
 ./src/video_generator.o \
 ./src/video_resolution.o \
-./src/xtpg_app.o 
+./src/xtpg_app.o \
+./src/zoom.o 
 
 C_DEPS += \
+./src/aec.d \
+./src/amp.d \
+./src/awb.d \
+./src/bayer2ycbcr.d \
 ./src/camera_app.d \
+./src/capture_store.d \
+./src/csc.d \
+./src/demosaic.d \
+./src/demosaic_bin.d \
+./src/demosaic_mhc.d \
+./src/dma2d.d \
+./src/dma_queue.d \
 ./src/fmc_imageon_utils.d \
+./src/frame_sync.d \
+./src/input.d \
+./src/isp.d \
+./src/line_buffer.d \
+./src/perf.d \
+./src/raw10.d \
+./src/roi.d \
+./src/still.d \
+./src/tnr.d \
+./src/tone.d \
+./src/triple_buffer.d \
 ./src/video_detector.d \
 ./src/video_frame_buffer.d \
 ./src/video_generator.d \
 ./src/video_resolution.d \
-./src/xtpg_app.d 
+./src/xtpg_app.d \
+./src/zoom.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
 src/%.o: ../src/%.c
 	@echo 'Building file: $<'
 	@echo 'Invoking: ARM gcc compiler'
-	arm-xilinx-eabi-gcc -Wall -O0 -g3 -c -fmessage-length=0 -I../../system_bsp/ps7_cortexa9_0/include -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
+	arm-xilinx-eabi-gcc -Wall -O2 -g3 -c -fmessage-length=0 -mfpu=neon -mfloat-abi=softfp -I../../system_bsp/ps7_cortexa9_0/include -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
 	@echo 'Finished building: $<'
 	@echo ' '
 
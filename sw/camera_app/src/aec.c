@@ -0,0 +1,261 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * aec.c - Sparse-grid exposure statistics stage, and the exposure/gain
+ * controller that turns them into VITA-2000 settings.
+ *****************************************************************************/
+
+#include <string.h>
+#include "xil_printf.h"
+#include "aec.h"
+
+// Analog gain of each vita_spi_again_values step, Q8
+static const Xuint32 aec_again_q8[AEC_AGAIN_STEPS] = {
+	256, 292, 341, 410, 512, 586, 683, 819, 1024, 1365, 2048
+};
+
+// Start from the settings the sensor was brought up with
+void aec_init(aec_t *aec, fmc_imageon_vita_receiver_t *vita, Xuint32 exposure, Xuint32 again, Xuint32 dgain)
+{
+	memset(aec, 0, sizeof(*aec));
+	aec->vita = vita;
+	aec->current.exposure = exposure;
+	aec->current.again = (again < AEC_AGAIN_STEPS) ? again : AEC_AGAIN_STEPS - 1;
+	aec->current.dgain = dgain;
+	aec->next = aec->current;
+}
+
+void aec_reset_stats(aec_t *aec)
+{
+	memset(aec->stats, 0, sizeof(aec->stats));
+}
+
+// Add the grid quads whose red pixel lies in [x_start, x_end) (x_start on
+// the grid) to the statistics
+void aec_stats_quad_range(aec_stats_t *stats, const Xuint16 *even, const Xuint16 *odd, int x_start, int x_end)
+{
+	int x, R, G1, G2, B, level;
+
+	for (x = x_start; x < x_end; x += 2 * AEC_COL_STEP) {
+		R = BAYER_PIXEL(even[x]);
+		G1 = BAYER_PIXEL(even[x+1]);
+		G2 = BAYER_PIXEL(odd[x]);
+		B = BAYER_PIXEL(odd[x+1]);
+
+		if (R >= AEC_CLIP_LEVEL || G1 >= AEC_CLIP_LEVEL || G2 >= AEC_CLIP_LEVEL || B >= AEC_CLIP_LEVEL)
+			stats->clipped++;
+
+		level = (R + G1 + G2 + B) >> 2;
+		stats->hist[level >> AEC_BIN_SHIFT]++;
+		stats->sum += level;
+		stats->samples++;
+	}
+}
+
+// Statistics stage, ctx is the aec_t
+int aec_stage_stats(void *ctx, isp_line_t *line)
+{
+	aec_t *aec = (aec_t *)ctx;
+
+	if ((line->y >> 1) % AEC_ROW_STEP == 0)
+		aec_stats_quad_range(&aec->stats[line->cpu], line->even, line->odd, 0, line->width);
+
+	return 0;
+}
+
+// Total exposure of a setting: exposure time times both gains, in
+// percent of the frame period, Q8
+Xuint32 aec_total(const aec_setting_t *setting)
+{
+	return setting->exposure * aec_again_q8[setting->again] * setting->dgain / AEC_DGAIN_UNITY;
+}
+
+// Reach a total exposure with as much exposure time, then as much analog
+// gain, as possible
+void aec_split(aec_setting_t *setting, Xuint32 total)
+{
+	Xuint32 exposure = total >> 8;
+	Xuint32 gain, dgain;
+	int again;
+
+	if (exposure < AEC_EXPOSURE_MIN)
+		exposure = AEC_EXPOSURE_MIN;
+	if (exposure > AEC_EXPOSURE_MAX)
+		exposure = AEC_EXPOSURE_MAX;
+
+	// Gain (Q8) still needed
+	gain = total / exposure;
+	for (again = AEC_AGAIN_STEPS - 1; again > 0 && aec_again_q8[again] > gain; again--)
+		;
+
+	dgain = gain * AEC_DGAIN_UNITY / aec_again_q8[again];
+	if (dgain < AEC_DGAIN_UNITY)
+		dgain = AEC_DGAIN_UNITY;
+	if (dgain > AEC_DGAIN_MAX)
+		dgain = AEC_DGAIN_MAX;
+
+	setting->exposure = exposure;
+	setting->again = again;
+	setting->dgain = dgain;
+}
+
+static Xuint32 aec_isqrt(Xuint32 v)
+{
+	Xuint32 root = 0, bit = 1 << 30;
+
+	while (bit > v)
+		bit >>= 2;
+	while (bit) {
+		if (v >= root + bit) {
+			v -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return root;
+}
+
+// Level below which permille/1000 of the quads lie, interpolated within
+// the bin
+Xuint32 aec_percentile(const aec_stats_t *stats, Xuint32 permille)
+{
+	Xuint32 rank = stats->samples * permille / 1000, count = 0;
+	int bin;
+
+	for (bin = 0; bin < AEC_HIST_BINS - 1; bin++) {
+		if (count + stats->hist[bin] > rank)
+			break;
+		count += stats->hist[bin];
+	}
+	if (stats->hist[bin] == 0)
+		return bin << AEC_BIN_SHIFT;
+	return (bin << AEC_BIN_SHIFT) + (((rank - count) << AEC_BIN_SHIFT) / stats->hist[bin]);
+}
+
+// After the frame barrier (core 0): merge the statistics and stage new
+// settings if the frame is off target (see aec.h)
+void aec_update(aec_t *aec)
+{
+	aec_stats_t *all = &aec->last;
+	Xuint32 median, highlight, ratio, step, off;
+	int cpu, i;
+
+	memset(all, 0, sizeof(*all));
+	for (cpu = 0; cpu < AMP_NUM_CPUS; cpu++) {
+		for (i = 0; i < AEC_HIST_BINS; i++) {
+			all->hist[i] += aec->stats[cpu].hist[i];
+		}
+		all->sum += aec->stats[cpu].sum;
+		all->samples += aec->stats[cpu].samples;
+		all->clipped += aec->stats[cpu].clipped;
+	}
+	aec_reset_stats(aec);
+
+	// Exposed with the settings before the last batch
+	if (aec->settle) {
+		aec->settle--;
+		aec->settling++;
+		return;
+	}
+	if (aec->pending || all->samples < AEC_MIN_SAMPLES) {
+		aec->held++;
+		return;
+	}
+
+	// Median to the target, unless that pushes the highlights too high
+	median = aec_percentile(all, 500);
+	highlight = aec_percentile(all, AEC_BRIGHT_PERMILLE);
+	ratio = (AEC_TARGET_LEVEL << 8) / (median ? median : 1);
+	if (ratio > (AEC_BRIGHT_LEVEL << 8) / (highlight ? highlight : 1))
+		ratio = (AEC_BRIGHT_LEVEL << 8) / (highlight ? highlight : 1);
+	if (all->clipped * 1000 > AEC_CLIP_PERMILLE * all->samples && ratio > AEC_CLIP_RATIO)
+		ratio = AEC_CLIP_RATIO;
+
+	// Hysteresis
+	off = ((ratio > 256) ? ratio - 256 : 256 - ratio) * 100 / 256;
+	if (!aec->adjusting && off > AEC_ENTER_PERCENT)
+		aec->adjusting = 1;
+	else if (aec->adjusting && off <= AEC_EXIT_PERCENT)
+		aec->adjusting = 0;
+	if (!aec->adjusting) {
+		aec->held++;
+		return;
+	}
+
+	// Half way, in log terms
+	step = aec_isqrt(ratio << 8);
+	if (step > AEC_MAX_RATIO)
+		step = AEC_MAX_RATIO;
+	if (step < 65536 / AEC_MAX_RATIO)
+		step = 65536 / AEC_MAX_RATIO;
+
+	aec_split(&aec->next, (Xuint32)(((u64)aec_total(&aec->current) * step) >> 8));
+	if (memcmp(&aec->next, &aec->current, sizeof(aec->next)) == 0) {
+		// At a limit of the controls
+		aec->held++;
+		return;
+	}
+	aec->pending = 1;
+	aec->updates++;
+}
+
+// At the start of a frame period: write the staged settings that changed
+// to the sensor. Returns 1 if a batch was applied.
+int aec_apply(aec_t *aec)
+{
+	u64 start;
+
+	if (!aec->pending)
+		return 0;
+
+	start = amp_time();
+	if (aec->vita) {
+		if (aec->next.exposure != aec->current.exposure) {
+			fmc_imageon_vita_receiver_set_exposure_time(aec->vita, aec->next.exposure, 0);
+			aec->writes++;
+		}
+		if (aec->next.again != aec->current.again) {
+			fmc_imageon_vita_receiver_set_analog_gain(aec->vita, aec->next.again, 0);
+			aec->writes++;
+		}
+		if (aec->next.dgain != aec->current.dgain) {
+			fmc_imageon_vita_receiver_set_digital_gain(aec->vita, aec->next.dgain, 0);
+			aec->writes++;
+		}
+	}
+
+	aec->current = aec->next;
+	aec->pending = 0;
+	aec->settle = AEC_SETTLE_FRAMES;
+	aec->batches++;
+	aec->apply_ticks += amp_time() - start;
+	return 1;
+}
+
+void aec_report(aec_t *aec)
+{
+	aec_stats_t *last = &aec->last;
+	Xuint32 again = aec_again_q8[aec->current.again];
+
+	xil_printf("AEC: %d updates, %d held, %d settling, %d batches (%d writes, %d us/batch)\r\n",
+			aec->updates, aec->held, aec->settling, aec->batches, aec->writes,
+			aec->batches ? (Xuint32)(aec->apply_ticks / aec->batches / (AMP_GTIMER_HZ / 1000000)) : 0);
+	xil_printf("  exposure %d%%, analog gain %d.%02d, digital gain %d.%02d\r\n",
+			aec->current.exposure, again / 256, again * 100 / 256 % 100,
+			aec->current.dgain / AEC_DGAIN_UNITY, aec->current.dgain * 100 / AEC_DGAIN_UNITY % 100);
+	if (last->samples == 0)
+		return;
+
+	xil_printf("  last frame: %d quads, median level %d (target %d), %d.%d%% at or below %d (limit %d), mean %d, %d clipped\r\n",
+			last->samples, aec_percentile(last, 500), AEC_TARGET_LEVEL,
+			AEC_BRIGHT_PERMILLE / 10, AEC_BRIGHT_PERMILLE % 10, aec_percentile(last, AEC_BRIGHT_PERMILLE),
+			AEC_BRIGHT_LEVEL, last->sum / last->samples, last->clipped);
+}
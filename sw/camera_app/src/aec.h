@@ -0,0 +1,123 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * aec.h - Automatic exposure and gain control for the VITA-2000 sensor,
+ * driven by statistics from the software ISP.
+ *
+ *
+ * NOTES:
+ * The statistics stage samples a sparse grid of RGGB quads (one quad in
+ * AEC_COL_STEP on one quad row in AEC_ROW_STEP, about 8000 quads at
+ * 1080p) while the Bayer lines are in cache for the demosaic. Each quad's
+ * mean level goes into a histogram and a sum, and a quad with any sample
+ * at AEC_CLIP_LEVEL counts as clipped. Each core has its own statistics.
+ *
+ * After the frame, aec_update() (core 0) meters it from the merged
+ * histogram: the median quad level is brought to AEC_TARGET_LEVEL, unless
+ * that would put the AEC_BRIGHT_PERMILLE percentile above
+ * AEC_BRIGHT_LEVEL, in which case the highlights set the exposure. A
+ * bright window in a dark room then holds the exposure down before it
+ * clips, where the mean, pulled down by the room, would have raised it.
+ * It adjusts with hysteresis: it starts when the frame is more than
+ * AEC_ENTER_PERCENT off target (or too much of it is clipped) and stops
+ * once it is within AEC_EXIT_PERCENT, so small changes in the scene do
+ * not make the exposure hunt. Each step moves half way to the target
+ * in log terms, by at most AEC_MAX_RATIO.
+ *
+ * The total exposure is spread over the sensor controls in order of
+ * noise: exposure time (a percentage of the frame period) up to
+ * AEC_EXPOSURE_MAX, then the analog gain steps, then digital gain. The new
+ * settings are only staged; aec_apply(), called at the start of a frame
+ * period, writes the ones that changed in one batch, so the SPI writes
+ * never land in the middle of the loop's work. The sensor takes a couple
+ * of frames to show new settings, so the statistics of the next
+ * AEC_SETTLE_FRAMES frames are ignored.
+ *****************************************************************************/
+
+#ifndef __AEC_H__
+#define __AEC_H__
+
+#include <stdint.h>
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "fmc_imageon_vita_receiver.h"
+#include "isp.h"
+
+// Sampling grid and histogram
+#define AEC_ROW_STEP          8                             // sample one quad row in this many
+#define AEC_COL_STEP          8                             // and one quad in this many along it
+#define AEC_HIST_BINS         64
+#define AEC_BIN_SHIFT         (BAYER_BITS - 6)              // quad level to bin
+
+// Levels are for 8-bit samples, scaled to BAYER_BITS
+#define AEC_TARGET_LEVEL      (96 << (BAYER_BITS - 8))      // median quad level aimed for
+#define AEC_BRIGHT_PERMILLE   980                           // this percentile of the quads
+#define AEC_BRIGHT_LEVEL      (224 << (BAYER_BITS - 8))     // is held at or below this
+#define AEC_CLIP_LEVEL        (250 << (BAYER_BITS - 8))     // a sample at or above this is clipped
+#define AEC_CLIP_PERMILLE     20                            // more clipped quads: expose down
+#define AEC_CLIP_RATIO        192                           // ... by this much (Q8) at least
+#define AEC_MIN_SAMPLES       256                           // fewer quads: keep the settings
+
+// Control loop
+#define AEC_ENTER_PERCENT     15
+#define AEC_EXIT_PERCENT      4
+#define AEC_MAX_RATIO         512                           // Q8, per update
+#define AEC_SETTLE_FRAMES     3
+
+// Sensor controls (see fmc_imageon_vita_receiver.c)
+#define AEC_EXPOSURE_MIN      1                             // % of the frame period
+#define AEC_EXPOSURE_MAX      90
+#define AEC_AGAIN_STEPS       11                            // vita_spi_again_values
+#define AEC_DGAIN_UNITY       128
+#define AEC_DGAIN_MAX         512                           // 4.0; more is mostly noise
+
+struct struct_aec_stats_t {
+	Xuint32 hist[AEC_HIST_BINS];    // quads by mean level
+	Xuint32 sum;                    // of the quad means
+	Xuint32 samples;
+	Xuint32 clipped;                // quads with a clipped sample
+} __attribute__((aligned(32))); typedef struct struct_aec_stats_t aec_stats_t;
+
+// One set of sensor settings
+struct struct_aec_setting_t {
+	Xuint32 exposure;               // % of the frame period
+	Xuint32 again;                  // analog gain step
+	Xuint32 dgain;                  // digital gain, AEC_DGAIN_UNITY = 1.0
+}; typedef struct struct_aec_setting_t aec_setting_t;
+
+struct struct_aec_t {
+	fmc_imageon_vita_receiver_t *vita;      // NULL: compute, never apply
+	aec_stats_t stats[AMP_NUM_CPUS];        // this frame, per core
+	aec_stats_t last;                       // the last frame, both cores
+	aec_setting_t current;                  // in the sensor
+	aec_setting_t next;                     // staged for aec_apply()
+	int pending;
+	int adjusting;                          // outside the hysteresis band
+	int settle;                             // frames left to ignore
+	Xuint32 updates;
+	Xuint32 held;                           // frames within the band, or too few quads
+	Xuint32 settling;                       // frames ignored after a batch
+	Xuint32 batches;
+	Xuint32 writes;                         // controls written (SPI, or trigger registers)
+	u64 apply_ticks;
+}; typedef struct struct_aec_t aec_t;
+
+// Function prototypes (aec.c)
+void aec_init(aec_t *aec, fmc_imageon_vita_receiver_t *vita, Xuint32 exposure, Xuint32 again, Xuint32 dgain);
+void aec_reset_stats(aec_t *aec);
+void aec_stats_quad_range(aec_stats_t *stats, const Xuint16 *even, const Xuint16 *odd, int x_start, int x_end);
+int aec_stage_stats(void *ctx, isp_line_t *line);
+Xuint32 aec_percentile(const aec_stats_t *stats, Xuint32 permille);
+Xuint32 aec_total(const aec_setting_t *setting);
+void aec_split(aec_setting_t *setting, Xuint32 total);
+void aec_update(aec_t *aec);
+int aec_apply(aec_t *aec);
+void aec_report(aec_t *aec);
+
+#endif // __AEC_H__
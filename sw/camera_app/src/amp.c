@@ -0,0 +1,384 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * amp.c - Dual-core frame processing. Core 0 owns the lines above the split
+ * and core 1 the lines below it. Every job is one frame: core 0 posts it,
+ * both cores work, and core 0 waits for core 1 before returning, so a
+ * frame is complete (and written back to DDR) when the call returns.
+ *****************************************************************************/
+
+#include <string.h>
+#include "xil_io.h"
+#include "xil_cache.h"
+#include "xil_cache_l.h"
+#include "xil_mmu.h"
+#include "xil_printf.h"
+#include "xstatus.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#include "amp.h"
+#include "isp.h"
+#include "capture_store.h"
+#include "zoom.h"
+
+#define amp_sev() __asm__ __volatile__ ("sev" : : : "memory")
+#define amp_wfe() __asm__ __volatile__ ("wfe" : : : "memory")
+
+// Entry point in amp_boot.S
+extern void amp_cpu1_boot(void);
+
+// One line buffer per core
+static line_buffer_t amp_lbuf[AMP_NUM_CPUS];
+
+// The apron lines either side of the split, saved (consecutively, width
+// words each) before an in-place frame starts (see lbuf_init())
+static Xuint16 amp_edge[2 * LBUF_MAX_APRON * DEMOSAIC_MAX_WIDTH] __attribute__((aligned(LBUF_CACHE_LINE)));
+
+static int amp_online = 0;
+
+int amp_cpu1_online(void)
+{
+	return amp_online;
+}
+
+int amp_cpu_id(void)
+{
+	return mfcp(XREG_CP15_MULTI_PROC_AFFINITY) & 0xF;
+}
+
+// 64-bit global timer count (re-read if the upper word rolled over)
+u64 amp_time(void)
+{
+	Xuint32 hi, lo;
+
+	do {
+		hi = Xil_In32(AMP_GTIMER_BASE + 0x4);
+		lo = Xil_In32(AMP_GTIMER_BASE + 0x0);
+	} while (hi != Xil_In32(AMP_GTIMER_BASE + 0x4));
+
+	return ((u64)hi << 32) | lo;
+}
+
+// Start and stop the PMU cycle counter on the calling core
+void amp_pmu_enable(void)
+{
+	mtcp(XREG_CP15_PERF_MONITOR_CTRL, mfcp(XREG_CP15_PERF_MONITOR_CTRL) | 0x1);
+	mtcp(XREG_CP15_COUNT_ENABLE_SET, 0x80000000);
+}
+
+// The PL310's by-address maintenance and cache sync registers are shared
+// by both cores, so only one drives them at a time. Both cores run with
+// ACTLR.SMP set (boot.S, amp_boot.S) and DDR is mapped shareable
+// write-back, so the SCU keeps this word coherent and ldrex/strex work on
+// it.
+static volatile Xuint32 amp_l2_busy __attribute__((aligned(LBUF_CACHE_LINE)));
+
+static void amp_l2_lock(void)
+{
+	Xuint32 tmp;
+
+	__asm__ __volatile__ (
+		"1:	ldrex	%0, [%1]\n"
+		"	teq	%0, #0\n"
+		"	strexeq	%0, %2, [%1]\n"
+		"	teqeq	%0, #0\n"
+		"	bne	1b\n"
+		: "=&r" (tmp)
+		: "r" (&amp_l2_busy), "r" (1)
+		: "cc", "memory");
+	dmb();
+}
+
+static void amp_l2_unlock(void)
+{
+	dmb();
+	amp_l2_busy = 0;
+}
+
+// As Xil_DCacheFlushRange(), with the L1 of this core cleaned first and
+// the L2 under amp_l2_lock()
+void amp_dcache_flush_range(const void *adr, int bytes)
+{
+	Xil_L1DCacheFlushRange((unsigned int)adr, bytes);
+	amp_l2_lock();
+	Xil_L2CacheFlushRange((unsigned int)adr, bytes);
+	amp_l2_unlock();
+}
+
+// As Xil_DCacheInvalidateRange(), L2 first so the L1 cannot refill from a
+// stale L2 line. Whole cache lines are dropped, dirty or not: the range
+// must not share one with data the CPU still has to write back.
+void amp_dcache_invalidate_range(const void *adr, int bytes)
+{
+	amp_l2_lock();
+	Xil_L2CacheInvalidateRange((unsigned int)adr, bytes);
+	amp_l2_unlock();
+	Xil_L1DCacheInvalidateRange((unsigned int)adr, bytes);
+}
+
+// Run the ISP pipeline on quad rows [y_start, y_end) of a Bayer frame
+static int amp_isp_rows(line_buffer_t *lbuf, isp_pipeline_t *pipe, const Xuint16 *src, Xuint16 *dst,
+		int width, int height, int stride, int y_start, int y_end)
+{
+	if (src == dst)
+		lbuf_init(lbuf, src, width, height, stride, y_start, y_end, pipe->apron, amp_edge, amp_edge + pipe->apron * width);
+	else
+		lbuf_init(lbuf, src, width, height, stride, y_start, y_end, pipe->apron, NULL, NULL);
+
+	return isp_run_rows(pipe, lbuf, dst, y_start, y_end);
+}
+
+// Copy lines [y_start, y_end) of a frame to one or two destinations. The
+// source is only invalidated: it is an S2MM frame, or a buffer whose
+// writer has cleaned it (as this leaves its destinations).
+static void amp_copy_rows(const Xuint16 *src, Xuint16 *dst, Xuint16 *dst2, int width, int y_start, int y_end)
+{
+	int offset = y_start * width;
+	int bytes = (y_end - y_start) * width * sizeof(Xuint16);
+
+	amp_dcache_invalidate_range(src + offset, bytes);
+	memcpy(dst + offset, src + offset, bytes);
+	amp_dcache_flush_range(dst + offset, bytes);
+	if (dst2) {
+		memcpy(dst2 + offset, dst + offset, bytes);
+		amp_dcache_flush_range(dst2 + offset, bytes);
+	}
+}
+
+// Run this core's share of the posted job; returns the mismatch count
+static int amp_run_job(int cpu)
+{
+	volatile amp_job_t *job = &amp_mailbox->job;
+	int y_start = (cpu == 0) ? 0 : job->y_start;
+	int y_end = (cpu == 0) ? job->y_start : job->height;
+
+	switch (job->type) {
+	case AMP_JOB_ISP:
+		return amp_isp_rows(&amp_lbuf[cpu], job->pipe, job->src, job->dst,
+				job->width, job->height, job->stride, y_start, y_end);
+	case AMP_JOB_COPY:
+		amp_copy_rows(job->src, job->dst, job->dst2, job->width, y_start, y_end);
+		return 0;
+	case AMP_JOB_DECODE:
+		cstore_decode_rows(job->capture, job->dst, job->width, y_start, y_end);
+		return 0;
+	case AMP_JOB_ZOOM:
+		zoom_render_rows(job->zoom, y_start, y_end);
+		return 0;
+	default:
+		return 0;
+	}
+}
+
+// Post a job, do core 0's share, and wait for core 1 (the frame barrier)
+static int amp_run(Xuint32 type, isp_pipeline_t *pipe, const Xuint16 *src, Xuint16 *dst, Xuint16 *dst2,
+		int width, int height, int stride)
+{
+	volatile amp_mailbox_t *mbox = amp_mailbox;
+	u64 t0, t1, t2;
+	int mismatches, split, l;
+
+	mbox->job.type = type;
+	mbox->job.pipe = pipe;
+	mbox->job.src = src;
+	mbox->job.dst = dst;
+	mbox->job.dst2 = dst2;
+	mbox->job.width = width;
+	mbox->job.height = height;
+	mbox->job.stride = stride;
+	// Split on a quad row so each core demosaics whole quads, or on a
+	// slice so each decompresses whole slices
+	split = (type == AMP_JOB_DECODE) ? CSTORE_SLICE_LINES : 2;
+	mbox->job.y_start = amp_online ? (height / 2) / split * split : height;
+	mbox->mismatches[1] = 0;
+
+	// In place, each core overwrites the apron lines the other one still
+	// needs
+	if (type == AMP_JOB_ISP && src == dst && amp_online) {
+		const Xuint16 *edge = src + (mbox->job.y_start - pipe->apron) * stride;
+		int bytes = width * sizeof(Xuint16);
+
+		for (l = 0; l < 2 * pipe->apron; l++) {
+			amp_dcache_flush_range(edge + l * stride, bytes);
+			memcpy(amp_edge + l * width, edge + l * stride, bytes);
+		}
+	}
+
+	if (amp_online) {
+		dsb();
+		mbox->job_seq++;
+		dsb();
+		amp_sev();
+	}
+
+	t0 = amp_time();
+	mismatches = amp_run_job(0);
+	t1 = amp_time();
+
+	if (amp_online) {
+		while (mbox->done_seq != mbox->job_seq) {
+			amp_wfe();
+		}
+	}
+	t2 = amp_time();
+
+	mbox->busy_ticks[0] += t1 - t0;
+	mbox->wait_ticks += t2 - t1;
+	mbox->mismatches[0] = mismatches;
+	mbox->jobs++;
+
+	return mismatches + mbox->mismatches[1];
+}
+
+// Run the ISP pipeline over a whole Bayer frame on both cores; src and
+// dst may be the same frame, except with a binning pipeline. Returns the
+// sum of the stages' problem counts (0 unless a verifying stage is in the
+// pipeline).
+int amp_isp_frame(isp_pipeline_t *pipe, const Xuint16 *src, Xuint16 *dst, int width, int height)
+{
+	int errors = amp_run(AMP_JOB_ISP, pipe, src, dst, NULL, width, height, width);
+
+	pipe->pixels = (width / pipe->bin) * (height / pipe->bin);
+	pipe->frames++;
+	return errors;
+}
+
+// Copy a whole frame on both cores, into dst and (if not NULL) dst2. src
+// must not be dirty in the cache (see amp_copy_rows()).
+void amp_copy_frame(const Xuint16 *src, Xuint16 *dst, Xuint16 *dst2, int width, int height)
+{
+	amp_run(AMP_JOB_COPY, NULL, src, dst, dst2, width, height, width);
+}
+
+// Decompress a 4:2:2 capture (capture_store.h) into a frame on both cores
+void amp_decode_frame(const cstore_entry_t *capture, Xuint16 *dst, int width, int height)
+{
+	amp_mailbox->job.capture = capture;
+	amp_run(AMP_JOB_DECODE, NULL, NULL, dst, NULL, width, height, width);
+}
+
+// Render a zoom canvas (zoom.h) on both cores
+void amp_zoom_render(const zoom_t *zoom)
+{
+	amp_mailbox->job.zoom = zoom;
+	amp_run(AMP_JOB_ZOOM, NULL, NULL, zoom->canvas, NULL, zoom->cw, zoom->ch, zoom->canvas_width);
+}
+
+// As amp_isp_frame(), on a width x height rectangle of a frame stride
+// words wide (src and dst point at its top-left pixel). The pipeline's
+// frame and pixel counts are left to the caller, which may run several
+// rectangles per frame.
+int amp_isp_region(isp_pipeline_t *pipe, const Xuint16 *src, Xuint16 *dst, int width, int height, int stride)
+{
+	return amp_run(AMP_JOB_ISP, pipe, src, dst, NULL, width, height, stride);
+}
+
+void amp_report_reset(void)
+{
+	volatile amp_mailbox_t *mbox = amp_mailbox;
+	int cpu;
+
+	for (cpu = 0; cpu < AMP_NUM_CPUS; cpu++) {
+		mbox->busy_ticks[cpu] = 0;
+	}
+	mbox->wait_ticks = 0;
+	mbox->jobs = 0;
+}
+
+// Average time per job (frame, or region) on each core, in microseconds
+void amp_report(void)
+{
+	volatile amp_mailbox_t *mbox = amp_mailbox;
+	Xuint32 jobs = mbox->jobs;
+	Xuint32 us_per_tick_den = AMP_GTIMER_HZ / 1000000;
+	int cpu;
+
+	if (jobs == 0)
+		return;
+
+	xil_printf("AMP report: %d jobs, core 1 %s\r\n", jobs, amp_online ? "online" : "offline");
+	for (cpu = 0; cpu < AMP_NUM_CPUS; cpu++) {
+		xil_printf("  core %d: %d us/job busy\r\n", cpu, (Xuint32)(mbox->busy_ticks[cpu] / jobs / us_per_tick_den));
+	}
+	xil_printf("  core 0: %d us/job waiting for core 1\r\n", (Xuint32)(mbox->wait_ticks / jobs / us_per_tick_den));
+}
+
+// Bring up core 1 and wait for it to check in. Returns XST_FAILURE (and
+// leaves every job on core 0) if it does not.
+int amp_init(void)
+{
+	volatile amp_mailbox_t *mbox = amp_mailbox;
+	Xuint32 ctrl;
+	u64 start;
+
+	// Mailbox page: strongly ordered, so it bypasses both L1s
+	Xil_SetTlbAttributes(AMP_MAILBOX_ADDR, AMP_OCM_TLB_ATTR);
+
+	// Both cores time themselves on the global timer, and count cycles
+	// on their own PMU
+	ctrl = Xil_In32(AMP_GTIMER_BASE + 0x8);
+	Xil_Out32(AMP_GTIMER_BASE + 0x8, ctrl | 0x1);
+	amp_pmu_enable();
+
+	mbox->cpu1_state = 0;
+	mbox->job_seq = 0;
+	mbox->done_seq = 0;
+	mbox->job.type = AMP_JOB_NONE;
+	amp_report_reset();
+
+	// Flush the image so core 1 fetches it (and MMUTable) from DDR
+	Xil_DCacheFlush();
+
+	Xil_Out32(AMP_CPU1_START_ADDR, (Xuint32)amp_cpu1_boot);
+	dsb();
+	amp_sev();
+
+	start = amp_time();
+	while (mbox->cpu1_state != AMP_CPU1_READY) {
+		if (amp_time() - start > AMP_BOOT_TIMEOUT) {
+			xil_printf("Core 1 did not start, processing on core 0 only\r\n");
+			amp_online = 0;
+			return XST_FAILURE;
+		}
+	}
+
+	xil_printf("Core 1 online\r\n");
+	amp_online = 1;
+	return XST_SUCCESS;
+}
+
+// Core 1 worker loop, called from amp_boot.S
+void amp_cpu1_main(void)
+{
+	volatile amp_mailbox_t *mbox = amp_mailbox;
+	Xuint32 seq = mbox->job_seq;
+	u64 t0;
+
+	amp_pmu_enable();
+	mbox->cpu1_state = AMP_CPU1_READY;
+	dsb();
+	amp_sev();
+
+	while (1) {
+		while (mbox->job_seq == seq) {
+			amp_wfe();
+		}
+		seq = mbox->job_seq;
+
+		t0 = amp_time();
+		mbox->mismatches[1] = amp_run_job(1);
+		mbox->busy_ticks[1] += amp_time() - t0;
+
+		// Output lines are already flushed; publish completion
+		dsb();
+		mbox->done_seq = seq;
+		dsb();
+		amp_sev();
+	}
+}
@@ -0,0 +1,115 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * amp.h - Runs half of every software frame on the second Cortex-A9.
+ *
+ *
+ * NOTES:
+ * Core 0 posts a job (the whole frame) in a mailbox in OCM, works on the
+ * top half itself and waits at the end of the frame until core 1 has
+ * finished the bottom half. The OCM page is remapped as strongly ordered
+ * so neither core ever sees a stale mailbox. If core 1 does not come up,
+ * every job runs on core 0 alone.
+ *
+ * Both cores share the PL310 L2 cache controller. Range maintenance goes
+ * through amp_dcache_flush_range() and amp_dcache_invalidate_range(),
+ * which take turns on the L2 with the other core.
+ *****************************************************************************/
+
+#ifndef __AMP_H__
+#define __AMP_H__
+
+#include <xparameters.h>
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#include "line_buffer.h"
+
+#define AMP_NUM_CPUS 2
+
+// Mailbox at the bottom of the high OCM, and the word the boot ROM polls
+// for core 1's start address
+#define AMP_MAILBOX_ADDR   0xFFFF0000
+#define AMP_CPU1_START_ADDR 0xFFFFFFF0
+
+// S=b1 TEX=b100 AP=b11, Domain=b1111, C=b0, B=b0
+#define AMP_OCM_TLB_ATTR   0x14de2
+
+#define AMP_CPU1_READY     0xA3A3C0DE
+
+// Cortex-A9 global timer, shared by both cores, runs at half the CPU clock
+#define AMP_GTIMER_BASE    0xF8F00200
+#define AMP_GTIMER_HZ      (XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ / 2)
+
+// Core 1 boot timeout, in global timer ticks
+#define AMP_BOOT_TIMEOUT   (AMP_GTIMER_HZ / 10)
+
+// Job types
+#define AMP_JOB_NONE        0
+#define AMP_JOB_ISP         1
+#define AMP_JOB_COPY        2
+#define AMP_JOB_DECODE      3
+#define AMP_JOB_ZOOM        4
+
+struct struct_isp_pipeline_t;
+struct struct_cstore_entry_t;
+struct struct_zoom_t;
+
+struct struct_amp_job_t {
+	Xuint32 type;
+	struct struct_isp_pipeline_t *pipe;
+	const struct struct_cstore_entry_t *capture;   // AMP_JOB_DECODE
+	const struct struct_zoom_t *zoom;              // AMP_JOB_ZOOM
+	const Xuint16 *src;
+	Xuint16 *dst;
+	Xuint16 *dst2;            // optional second destination (AMP_JOB_COPY)
+	Xuint32 width;
+	Xuint32 height;
+	Xuint32 stride;           // words per line (AMP_JOB_ISP)
+	Xuint32 y_start;          // first line for core 1
+}; typedef struct struct_amp_job_t amp_job_t;
+
+struct struct_amp_mailbox_t {
+	Xuint32 cpu1_state;
+	Xuint32 job_seq;          // bumped by core 0 to post a job
+	Xuint32 done_seq;         // set to job_seq by core 1 when it is done
+	amp_job_t job;
+	Xuint32 mismatches[AMP_NUM_CPUS];
+	u64 busy_ticks[AMP_NUM_CPUS];   // time spent working, per core
+	u64 wait_ticks;                 // core 0 time spent at the barrier
+	Xuint32 jobs;                   // frames, or regions (amp_isp_region())
+}; typedef struct struct_amp_mailbox_t amp_mailbox_t;
+
+#define amp_mailbox ((volatile amp_mailbox_t *)AMP_MAILBOX_ADDR)
+
+// This core's PMU cycle counter (see amp_pmu_enable())
+static inline Xuint32 amp_cycles(void)
+{
+	return mfcp(XREG_CP15_PERF_CYCLE_COUNTER);
+}
+
+// Function prototypes (amp.c)
+int amp_init(void);
+int amp_cpu1_online(void);
+int amp_cpu_id(void);
+u64 amp_time(void);
+void amp_pmu_enable(void);
+void amp_dcache_flush_range(const void *adr, int bytes);
+void amp_dcache_invalidate_range(const void *adr, int bytes);
+int amp_isp_frame(struct struct_isp_pipeline_t *pipe, const Xuint16 *src, Xuint16 *dst, int width, int height);
+void amp_copy_frame(const Xuint16 *src, Xuint16 *dst, Xuint16 *dst2, int width, int height);
+void amp_decode_frame(const struct struct_cstore_entry_t *capture, Xuint16 *dst, int width, int height);
+void amp_zoom_render(const struct struct_zoom_t *zoom);
+int amp_isp_region(struct struct_isp_pipeline_t *pipe, const Xuint16 *src, Xuint16 *dst, int width, int height, int stride);
+void amp_report(void);
+void amp_report_reset(void);
+void amp_cpu1_main(void);
+
+#endif // __AMP_H__
@@ -0,0 +1,260 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * awb.c - White balance statistics stage (scalar and NEON) and the gray
+ * world / white patch controller that turns them into gains.
+ *****************************************************************************/
+
+#include <string.h>
+#include "xil_printf.h"
+#include "awb.h"
+
+#if DEMOSAIC_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+// Start from unity gains (the balanced conversion is the base one) and
+// empty statistics
+void awb_init(awb_t *awb, int mode, const csc_coef_t *base, csc_coef_t *coef, isp_wb_t *wb)
+{
+	int c;
+
+	awb->mode = mode;
+	awb->base = *base;
+	awb->coef = coef;
+	awb->wb = wb;
+	for (c = 0; c < 3; c++) {
+		awb->gain[c] = AWB_GAIN_UNITY;
+	}
+	if (awb->coef)
+		*awb->coef = awb->base;
+	if (awb->wb)
+		memcpy(awb->wb->gain, awb->gain, sizeof(awb->gain));
+
+	awb->updates = 0;
+	awb->held = 0;
+	awb->white_patch = 0;
+	memset(&awb->last, 0, sizeof(awb->last));
+	awb_reset_stats(awb);
+}
+
+void awb_reset_stats(awb_t *awb)
+{
+	memset(awb->stats, 0, sizeof(awb->stats));
+}
+
+// Quads [x_start, x_end) / 2 of the quad row on lines even (R G) and odd
+// (G B); x_start and x_end even
+void awb_stats_quad_range_ref(awb_stats_t *stats, const Xuint16 *even, const Xuint16 *odd, int x_start, int x_end)
+{
+	int x, R, G1, G2, B, G;
+	int clip_r, clip_g, clip_b;
+
+	for (x = x_start; x < x_end; x += 2) {
+		R = BAYER_PIXEL(even[x]);
+		G1 = BAYER_PIXEL(even[x+1]);
+		G2 = BAYER_PIXEL(odd[x]);
+		B = BAYER_PIXEL(odd[x+1]);
+
+		clip_r = R >= AWB_CLIP_LEVEL;
+		clip_g = G1 >= AWB_CLIP_LEVEL || G2 >= AWB_CLIP_LEVEL;
+		clip_b = B >= AWB_CLIP_LEVEL;
+		if (clip_r || clip_g || clip_b) {
+			stats->clipped[0] += clip_r;
+			stats->clipped[1] += clip_g;
+			stats->clipped[2] += clip_b;
+			continue;
+		}
+
+		G = G1 + G2;
+		stats->sum[0] += R;
+		stats->sum[1] += G;
+		stats->sum[2] += B;
+		stats->quads++;
+		if (G >= 2 * AWB_BRIGHT_LEVEL) {
+			stats->bright_sum[0] += R;
+			stats->bright_sum[1] += G;
+			stats->bright_sum[2] += B;
+			stats->bright_quads++;
+		}
+	}
+}
+
+void awb_stats_quad_row_ref(awb_stats_t *stats, const Xuint16 *even, const Xuint16 *odd, int width)
+{
+	awb_stats_quad_range_ref(stats, even, odd, 0, width);
+}
+
+#if DEMOSAIC_HAVE_NEON
+
+static inline Xuint32 awb_sum_lanes(uint32x4_t v)
+{
+	return vgetq_lane_u32(v, 0) + vgetq_lane_u32(v, 1) + vgetq_lane_u32(v, 2) + vgetq_lane_u32(v, 3);
+}
+
+// Eight quads per iteration. Compare masks are all ones (-1), so
+// subtracting one counts it. The 16-bit counters see at most one count
+// per iteration, far below overflow for any line that fits in the buffers.
+void awb_stats_quad_row_neon(awb_stats_t *stats, const Xuint16 *even, const Xuint16 *odd, int width)
+{
+	uint16x8_t mask = vdupq_n_u16(BAYER_MAX);
+	uint16x8_t clip = vdupq_n_u16(AWB_CLIP_LEVEL);
+	uint16x8_t bright = vdupq_n_u16(2 * AWB_BRIGHT_LEVEL);
+	uint16x8_t zero = vdupq_n_u16(0);
+	uint16x8_t clipped[3] = { zero, zero, zero };
+	uint16x8_t quads = zero, bright_quads = zero;
+	uint32x4_t sum[3], bright_sum[3];
+	uint16x8_t R, G1, G2, B, G, clip_r, clip_g, clip_b, bad, good, lit;
+	uint16x8x2_t e, o;
+	int x, c;
+
+	for (c = 0; c < 3; c++) {
+		sum[c] = vdupq_n_u32(0);
+		bright_sum[c] = vdupq_n_u32(0);
+	}
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		e = vld2q_u16(even + x);
+		o = vld2q_u16(odd + x);
+		R = vandq_u16(e.val[0], mask);
+		G1 = vandq_u16(e.val[1], mask);
+		G2 = vandq_u16(o.val[0], mask);
+		B = vandq_u16(o.val[1], mask);
+
+		clip_r = vcgeq_u16(R, clip);
+		clip_g = vorrq_u16(vcgeq_u16(G1, clip), vcgeq_u16(G2, clip));
+		clip_b = vcgeq_u16(B, clip);
+		clipped[0] = vsubq_u16(clipped[0], clip_r);
+		clipped[1] = vsubq_u16(clipped[1], clip_g);
+		clipped[2] = vsubq_u16(clipped[2], clip_b);
+
+		bad = vorrq_u16(vorrq_u16(clip_r, clip_g), clip_b);
+		R = vbicq_u16(R, bad);
+		G = vbicq_u16(vaddq_u16(G1, G2), bad);
+		B = vbicq_u16(B, bad);
+		good = vbicq_u16(vdupq_n_u16(1), bad);
+		quads = vaddq_u16(quads, good);
+		sum[0] = vpadalq_u16(sum[0], R);
+		sum[1] = vpadalq_u16(sum[1], G);
+		sum[2] = vpadalq_u16(sum[2], B);
+
+		// G is already zero in the clipped quads
+		lit = vcgeq_u16(G, bright);
+		bright_quads = vsubq_u16(bright_quads, lit);
+		bright_sum[0] = vpadalq_u16(bright_sum[0], vandq_u16(R, lit));
+		bright_sum[1] = vpadalq_u16(bright_sum[1], vandq_u16(G, lit));
+		bright_sum[2] = vpadalq_u16(bright_sum[2], vandq_u16(B, lit));
+	}
+
+	for (c = 0; c < 3; c++) {
+		stats->sum[c] += awb_sum_lanes(sum[c]);
+		stats->bright_sum[c] += awb_sum_lanes(bright_sum[c]);
+		stats->clipped[c] += awb_sum_lanes(vpadalq_u16(vdupq_n_u32(0), clipped[c]));
+	}
+	stats->quads += awb_sum_lanes(vpadalq_u16(vdupq_n_u32(0), quads));
+	stats->bright_quads += awb_sum_lanes(vpadalq_u16(vdupq_n_u32(0), bright_quads));
+
+	awb_stats_quad_range_ref(stats, even, odd, x, width);
+}
+
+#endif // DEMOSAIC_HAVE_NEON
+
+// Fastest kernel available for this build
+void awb_stats_quad_row(awb_stats_t *stats, const Xuint16 *even, const Xuint16 *odd, int width)
+{
+#if DEMOSAIC_HAVE_NEON
+	awb_stats_quad_row_neon(stats, even, odd, width);
+#else
+	awb_stats_quad_row_ref(stats, even, odd, width);
+#endif
+}
+
+// Statistics on every AWB_ROW_STEP'th quad row, ctx is the awb_t. Add it
+// before the demosaic (or bayer2ycbcr) stage.
+int awb_stage_stats(void *ctx, isp_line_t *line)
+{
+	awb_t *awb = (awb_t *)ctx;
+
+	if ((line->y >> 1) % AWB_ROW_STEP == 0)
+		awb_stats_quad_row(&awb->stats[line->cpu], line->even, line->odd, line->width);
+
+	return 0;
+}
+
+// Gain that brings channel c to the level of G: (G / 2) / c in Q8
+static Xuint32 awb_target(const Xuint32 *sum, int c)
+{
+	if (sum[c] == 0)
+		return AWB_GAIN_MAX;
+	return (Xuint32)(((u64)sum[1] * (AWB_GAIN_UNITY / 2) + sum[c] / 2) / sum[c]);
+}
+
+// Fold this frame's statistics into new gains for the next one. Call on
+// core 0 once the frame is finished on both cores.
+void awb_update(awb_t *awb)
+{
+	awb_stats_t *all = &awb->last;
+	const Xuint32 *sum;
+	int target, gain;
+	int cpu, c;
+
+	memset(all, 0, sizeof(*all));
+	for (cpu = 0; cpu < AMP_NUM_CPUS; cpu++) {
+		for (c = 0; c < 3; c++) {
+			all->sum[c] += awb->stats[cpu].sum[c];
+			all->bright_sum[c] += awb->stats[cpu].bright_sum[c];
+			all->clipped[c] += awb->stats[cpu].clipped[c];
+		}
+		all->quads += awb->stats[cpu].quads;
+		all->bright_quads += awb->stats[cpu].bright_quads;
+	}
+	awb_reset_stats(awb);
+
+	// A (nearly) saturated or black frame says nothing about the light
+	if (all->quads < AWB_MIN_QUADS || all->sum[1] < 2 * AWB_MIN_LEVEL * all->quads) {
+		awb->held++;
+		return;
+	}
+
+	sum = all->sum;
+	if (awb->mode == AWB_MODE_WHITE_PATCH && all->bright_quads >= AWB_MIN_BRIGHT_QUADS) {
+		sum = all->bright_sum;
+		awb->white_patch++;
+	}
+
+	for (c = 0; c < 3; c += 2) {
+		target = awb_target(sum, c);
+		gain = awb->gain[c] + ((target - (int)awb->gain[c]) >> AWB_DAMPING_SHIFT);
+		awb->gain[c] = (gain < AWB_GAIN_MIN) ? AWB_GAIN_MIN : (gain > AWB_GAIN_MAX) ? AWB_GAIN_MAX : gain;
+	}
+	awb->updates++;
+
+	if (awb->coef)
+		csc_coef_apply_gains(awb->coef, &awb->base, awb->gain);
+	if (awb->wb)
+		memcpy(awb->wb->gain, awb->gain, sizeof(awb->gain));
+}
+
+void awb_report(awb_t *awb)
+{
+	awb_stats_t *last = &awb->last;
+	Xuint32 total = last->quads + last->clipped[0] + last->clipped[1] + last->clipped[2];
+
+	xil_printf("AWB (%s): %d updates, %d held, %d white patch\r\n",
+			(awb->mode == AWB_MODE_WHITE_PATCH) ? "white patch" : "gray world",
+			awb->updates, awb->held, awb->white_patch);
+	xil_printf("  gains R %d.%02d G %d.%02d B %d.%02d\r\n",
+			awb->gain[0] / 256, awb->gain[0] * 100 / 256 % 100,
+			awb->gain[1] / 256, awb->gain[1] * 100 / 256 % 100,
+			awb->gain[2] / 256, awb->gain[2] * 100 / 256 % 100);
+	if (total == 0)
+		return;
+	xil_printf("  last frame: %d unclipped quads, %d bright, clipped R %d G %d B %d\r\n",
+			last->quads, last->bright_quads, last->clipped[0], last->clipped[1], last->clipped[2]);
+}
@@ -0,0 +1,88 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * awb.h - Automatic white balance for the software ISP.
+ *
+ *
+ * NOTES:
+ * The statistics stage goes first in the ISP pipeline and reads the Bayer
+ * lines of the quad row while they are in cache for the demosaic, so the
+ * frame is not read a second time. Every AWB_ROW_STEP'th quad row is
+ * sampled; for each RGGB quad it adds R, G (both greens) and B to the
+ * sums, unless any of its samples is at AWB_CLIP_LEVEL, in which case it
+ * only counts the clipped channels. Each core has its own statistics.
+ *
+ * After the frame, awb_update() (core 0, after the frame barrier) works
+ * out the R and B gains that bring the average (gray world) or the bright
+ * quads (white patch) to neutral, moves part of the way there, and puts
+ * the gains into effect for the next frame: as the CSC's input gains,
+ * applied to each sample (and clipped, as the core would) ahead of its
+ * datapath, which works for the fused kernel without another pass, or in
+ * the white balance stage when there is one.
+ *****************************************************************************/
+
+#ifndef __AWB_H__
+#define __AWB_H__
+
+#include <stdint.h>
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "csc.h"
+#include "isp.h"
+
+#define AWB_MODE_GRAY_WORLD  0
+#define AWB_MODE_WHITE_PATCH 1
+
+// Levels are for 8-bit samples, scaled to BAYER_BITS
+#define AWB_ROW_STEP          8                             // sample one quad row in this many
+#define AWB_CLIP_LEVEL        (250 << (BAYER_BITS - 8))     // a sample at or above this is clipped
+#define AWB_BRIGHT_LEVEL      (200 << (BAYER_BITS - 8))     // G level of a white patch quad
+#define AWB_MIN_QUADS         256                           // fewer unclipped quads: keep the gains
+#define AWB_MIN_LEVEL         (8 << (BAYER_BITS - 8))       // darker on average: keep the gains
+#define AWB_MIN_BRIGHT_QUADS  64                            // fewer bright quads: use gray world
+#define AWB_DAMPING_SHIFT     2                             // move 1/4 of the way each frame
+
+// Gains are Q8 (256 = 1.0); G stays at 1.0
+#define AWB_GAIN_UNITY        256
+#define AWB_GAIN_MIN          64
+#define AWB_GAIN_MAX          1024
+
+struct struct_awb_stats_t {
+	Xuint32 sum[3];                 // R, G (both greens), B of unclipped quads
+	Xuint32 bright_sum[3];          // the same for the bright quads
+	Xuint32 clipped[3];             // quads with that channel clipped
+	Xuint32 quads;                  // unclipped quads
+	Xuint32 bright_quads;
+} __attribute__((aligned(32))); typedef struct struct_awb_stats_t awb_stats_t;
+
+struct struct_awb_t {
+	int mode;
+	awb_stats_t stats[AMP_NUM_CPUS];        // this frame, per core
+	awb_stats_t last;                       // the last frame, both cores
+	uint16_t gain[3];                       // in effect, R/G/B
+	csc_coef_t base;                        // conversion without white balance
+	csc_coef_t *coef;                       // balanced conversion, or NULL
+	isp_wb_t *wb;                           // white balance stage, or NULL
+	Xuint32 updates;
+	Xuint32 held;                           // frames with too few quads
+	Xuint32 white_patch;                    // frames white patch was used
+}; typedef struct struct_awb_t awb_t;
+
+// Function prototypes (awb.c)
+void awb_init(awb_t *awb, int mode, const csc_coef_t *base, csc_coef_t *coef, isp_wb_t *wb);
+void awb_reset_stats(awb_t *awb);
+void awb_stats_quad_range_ref(awb_stats_t *stats, const Xuint16 *even, const Xuint16 *odd, int x_start, int x_end);
+void awb_stats_quad_row_ref(awb_stats_t *stats, const Xuint16 *even, const Xuint16 *odd, int width);
+void awb_stats_quad_row_neon(awb_stats_t *stats, const Xuint16 *even, const Xuint16 *odd, int width);
+void awb_stats_quad_row(awb_stats_t *stats, const Xuint16 *even, const Xuint16 *odd, int width);
+int awb_stage_stats(void *ctx, isp_line_t *line);
+void awb_update(awb_t *awb);
+void awb_report(awb_t *awb);
+
+#endif // __AWB_H__
@@ -0,0 +1,287 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * bayer2ycbcr.c - Bayer to 4:2:2 YCbCr for one quad row (two lines) at a
+ * time. The scalar reference runs demosaic.c, the tone LUT and csc.c;
+ * the NEON kernel does all three in registers, 8 quads (16 pixels of each
+ * line) per iteration, and must produce exactly the same words. Each
+ * quad's two pixels on a line are a 4:2:2 pair, so its chroma comes from
+ * their sum.
+ *****************************************************************************/
+
+#include "bayer2ycbcr.h"
+#include "amp.h"
+
+#if BAYER2YCBCR_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+// Demosaic scratch for the scalar path, one set per core
+static uint16_t ref_planes[AMP_NUM_CPUS][2][3][DEMOSAIC_MAX_WIDTH];
+
+// Output of the reference kernel in comparison mode, one set per core
+static Xuint16 cmp_lines[AMP_NUM_CPUS][2][DEMOSAIC_MAX_WIDTH];
+
+void bayer2ycbcr_quad_range_ref(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		Xuint16 *out_even, Xuint16 *out_odd, int x_start, int x_end, int width)
+{
+	uint16_t (*planes)[3][DEMOSAIC_MAX_WIDTH] = ref_planes[amp_cpu_id()];
+	rgb_line_t ref_lines[2] = {
+		{ planes[0][0], planes[0][1], planes[0][2] },
+		{ planes[1][0], planes[1][1], planes[1][2] }
+	};
+
+	int l, c, x;
+
+	demosaic_bilinear_quad_range(above, even, odd, below, &ref_lines[0], &ref_lines[1], x_start, x_end, width);
+	if (tone) {
+		for (l = 0; l < 2; l++) {
+			for (c = 0; c < 3; c++) {
+				for (x = x_start; x < x_end; x++) {
+					planes[l][c][x] = tone[planes[l][c][x]];
+				}
+			}
+		}
+	}
+	csc_convert_line(coef, &ref_lines[0], out_even, x_start, x_end);
+	csc_convert_line(coef, &ref_lines[1], out_odd,  x_start, x_end);
+}
+
+void bayer2ycbcr_quad_row_ref(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		Xuint16 *out_even, Xuint16 *out_odd, int width)
+{
+	bayer2ycbcr_quad_range_ref(coef, tone, above, even, odd, below, out_even, out_odd, 0, width, width);
+}
+
+#if BAYER2YCBCR_HAVE_NEON
+
+// Widen one pixel class to 32-bit lanes
+static inline void widen_rgb_neon(int32x4_t rgb[3][2], uint16x8_t R, uint16x8_t G, uint16x8_t B)
+{
+	rgb[0][0] = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(R)));
+	rgb[0][1] = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(R)));
+	rgb[1][0] = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(G)));
+	rgb[1][1] = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(G)));
+	rgb[2][0] = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(B)));
+	rgb[2][1] = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(B)));
+}
+
+// Eight lanes of csc_input() on a widened pixel class
+static inline void csc_input_neon(const csc_coef_t *coef, int32x4_t rgb[3][2])
+{
+	const int32x4_t shift = vdupq_n_s32(-(CSC_GAIN_BITS + coef->in_shift));
+	const int32x4_t round = vdupq_n_s32(1 << (CSC_GAIN_BITS + coef->in_shift - 1));
+	const int32x4_t in_max = vdupq_n_s32(CSC_IN_MAX);
+	int k, h;
+
+	for (k = 0; k < 3; k++) {
+		for (h = 0; h < 2; h++) {
+			rgb[k][h] = vminq_s32(vshlq_s32(vmlaq_n_s32(round, rgb[k][h], coef->gain[k]), shift), in_max);
+		}
+	}
+}
+
+// Eight lanes of csc_luma()
+static inline void csc_luma_neon(const csc_coef_t *coef, int32x4_t rgb[3][2], int32x4_t L[2])
+{
+	int32x4_t t;
+	int h;
+
+	for (h = 0; h < 2; h++) {
+		t = vmulq_n_s32(vsubq_s32(rgb[0][h], rgb[1][h]), coef->a);
+		t = vmlaq_n_s32(t, vsubq_s32(rgb[2][h], rgb[1][h]), coef->b);
+		L[h] = vaddq_s32(vrshrq_n_s32(t, CSC_FRAC_BITS), rgb[1][h]);
+	}
+}
+
+// Eight lanes of csc_clamp(), narrowed to 16 bits
+static inline uint16x8_t csc_clamp_neon(const csc_coef_t *coef, int c, const int32x4_t v[2])
+{
+	const int32x4_t offset = vdupq_n_s32(coef->offset[c]);
+	uint16x8_t r;
+
+	r = vcombine_u16(vqmovun_s32(vaddq_s32(v[0], offset)), vqmovun_s32(vaddq_s32(v[1], offset)));
+	r = vmaxq_u16(r, vdupq_n_u16(coef->min[c]));
+	return vminq_u16(r, vdupq_n_u16(coef->max[c]));
+}
+
+// Eight lanes of csc_chroma_pair(), from the pair's two pixel classes
+// and their lumas
+static inline uint16x8_t csc_chroma_pair_neon(const csc_coef_t *coef, int c, int32x4_t p[3][2], int32x4_t Lp[2],
+		int32x4_t q[3][2], int32x4_t Lq[2])
+{
+	int32_t k = (c == CSC_CB) ? coef->d : coef->c;
+	int s = (c == CSC_CB) ? 2 : 0;
+	int32x4_t v[2];
+	int h;
+
+	for (h = 0; h < 2; h++) {
+		v[h] = vsubq_s32(vaddq_s32(p[s][h], q[s][h]), vaddq_s32(Lp[h], Lq[h]));
+		v[h] = vrshrq_n_s32(vmulq_n_s32(v[h], k), CSC_FRAC_BITS + 1);
+	}
+	return csc_clamp_neon(coef, c, v);
+}
+
+// Tone LUT on eight samples; there is no NEON gather, so one at a time
+static inline uint16x8_t tone_lookup_neon(const uint16_t *tone, uint16x8_t v)
+{
+	uint16_t s[8];
+	int i;
+
+	vst1q_u16(s, v);
+	for (i = 0; i < 8; i++) {
+		s[i] = tone[s[i]];
+	}
+	return vld1q_u16(s);
+}
+
+// The tone LUT, if any, on one pixel class
+#define TONE_NEON(R, G, B) \
+	do { \
+		if (tone) { \
+			R = tone_lookup_neon(tone, R); \
+			G = tone_lookup_neon(tone, G); \
+			B = tone_lookup_neon(tone, B); \
+		} \
+	} while (0)
+
+// One pixel class through the tone LUT (if any) and the datapath's input
+// scaling (if any), widened into rgb, with its lumas in L and its Ys in Y
+#define PIXEL_NEON(R, G, B, rgb, L, Y) \
+	do { \
+		TONE_NEON(R, G, B); \
+		widen_rgb_neon(rgb, R, G, B); \
+		if (coef->scaled) \
+			csc_input_neon(coef, rgb); \
+		csc_luma_neon(coef, rgb, L); \
+		Y = csc_clamp_neon(coef, CSC_Y, L); \
+	} while (0)
+
+#define CHROMA_NEON(c) \
+	csc_chroma_pair_neon(coef, c, p, Lp, q, Lq)
+
+VRES_INLINE void b2y_quad_row_neon(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		Xuint16 *out_even, Xuint16 *out_odd, int width)
+{
+	const uint16x8_t mask = vdupq_n_u16(BAYER_MAX);
+	int x;
+
+	// Left edge quad needs mirroring, leave it to the reference
+	bayer2ycbcr_quad_range_ref(coef, tone, above, even, odd, below, out_even, out_odd, 0, 2, width);
+
+	// vld2 splits each line into its even (R or G) and odd (G or B)
+	// columns. The loads at x-2 and x+2 give the neighbouring quads'
+	// columns, so the highest word read is x+17.
+	for (x = 2; x + 16 <= width - 2; x += 16) {
+		uint16x8x2_t a_l = vld2q_u16(above + x - 2), a_c = vld2q_u16(above + x);
+		uint16x8x2_t e_c = vld2q_u16(even  + x),     e_r = vld2q_u16(even  + x + 2);
+		uint16x8x2_t o_l = vld2q_u16(odd   + x - 2), o_c = vld2q_u16(odd   + x);
+		uint16x8x2_t b_c = vld2q_u16(below + x),     b_r = vld2q_u16(below + x + 2);
+
+		uint16x8_t AL = vandq_u16(a_l.val[1], mask), A0 = vandq_u16(a_c.val[0], mask), A1 = vandq_u16(a_c.val[1], mask);
+		uint16x8_t E0 = vandq_u16(e_c.val[0], mask), E1 = vandq_u16(e_c.val[1], mask), E2 = vandq_u16(e_r.val[0], mask);
+		uint16x8_t OL = vandq_u16(o_l.val[1], mask), O0 = vandq_u16(o_c.val[0], mask), O1 = vandq_u16(o_c.val[1], mask);
+		uint16x8_t B0 = vandq_u16(b_c.val[0], mask), B1 = vandq_u16(b_c.val[1], mask), B2 = vandq_u16(b_r.val[0], mask);
+
+		uint16x8_t R, G, B;
+		int32x4_t p[3][2], q[3][2], Lp[2], Lq[2];
+		uint16x8x2_t w_even, w_odd;
+
+		// Red line: red pixel (Y0) and green pixel (Y1), then the pair's
+		// Cb and Cr from the sums of their samples and lumas
+		R = E0;
+		G = vhaddq_u16(A0, O0);
+		B = vshrq_n_u16(vaddq_u16(vaddq_u16(AL, A1), vaddq_u16(OL, O1)), 2);
+		PIXEL_NEON(R, G, B, p, Lp, w_even.val[0]);
+
+		R = vhaddq_u16(E0, E2);
+		G = E1;
+		B = vhaddq_u16(A1, O1);
+		PIXEL_NEON(R, G, B, q, Lq, w_even.val[1]);
+
+		w_even.val[0] = vsliq_n_u16(w_even.val[0], CHROMA_NEON(CSC_CB), 8);
+		w_even.val[1] = vsliq_n_u16(w_even.val[1], CHROMA_NEON(CSC_CR), 8);
+
+		// Blue line: green pixel (Y0) and blue pixel (Y1)
+		R = vhaddq_u16(E0, B0);
+		G = O0;
+		B = vhaddq_u16(OL, O1);
+		PIXEL_NEON(R, G, B, p, Lp, w_odd.val[0]);
+
+		R = vshrq_n_u16(vaddq_u16(vaddq_u16(E0, E2), vaddq_u16(B0, B2)), 2);
+		G = vhaddq_u16(E1, B1);
+		B = O1;
+		PIXEL_NEON(R, G, B, q, Lq, w_odd.val[1]);
+
+		w_odd.val[0] = vsliq_n_u16(w_odd.val[0], CHROMA_NEON(CSC_CB), 8);
+		w_odd.val[1] = vsliq_n_u16(w_odd.val[1], CHROMA_NEON(CSC_CR), 8);
+
+		vst2q_u16(out_even + x, w_even);
+		vst2q_u16(out_odd  + x, w_odd);
+	}
+
+	// Remaining quads and the right edge
+	bayer2ycbcr_quad_range_ref(coef, tone, above, even, odd, below, out_even, out_odd, x, width, width);
+}
+
+void bayer2ycbcr_quad_row_neon(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		Xuint16 *out_even, Xuint16 *out_odd, int width)
+{
+	b2y_quad_row_neon(coef, tone, above, even, odd, below, out_even, out_odd, width);
+}
+
+#endif // BAYER2YCBCR_HAVE_NEON
+
+// Fastest kernel available for this build
+VRES_INLINE void b2y_quad_row(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		Xuint16 *out_even, Xuint16 *out_odd, int width)
+{
+#if BAYER2YCBCR_HAVE_NEON
+	b2y_quad_row_neon(coef, tone, above, even, odd, below, out_even, out_odd, width);
+#else
+	bayer2ycbcr_quad_range_ref(coef, tone, above, even, odd, below, out_even, out_odd, 0, width, width);
+#endif
+}
+
+void bayer2ycbcr_quad_row(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		Xuint16 *out_even, Xuint16 *out_odd, int width)
+{
+	b2y_quad_row(coef, tone, above, even, odd, below, out_even, out_odd, width);
+}
+
+// The same for each video mode's width (video_resolution.h). Only the NEON
+// kernel gains from the fixed width; the scalar one is the reference, out
+// of line.
+#define BAYER2YCBCR_VRES(id, width, ...) \
+void bayer2ycbcr_quad_row_##id(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, \
+		const Xuint16 *odd, const Xuint16 *below, Xuint16 *out_even, Xuint16 *out_odd) \
+{ \
+	b2y_quad_row(coef, tone, above, even, odd, below, out_even, out_odd, width); \
+}
+VRES_MODE_LIST(BAYER2YCBCR_VRES)
+
+// Comparison mode: run the fast kernel into out_even/out_odd, run the
+// reference next to it and return the number of words that differ.
+int bayer2ycbcr_quad_row_compare(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		Xuint16 *out_even, Xuint16 *out_odd, int width)
+{
+	Xuint16 (*ref)[DEMOSAIC_MAX_WIDTH] = cmp_lines[amp_cpu_id()];
+	int x;
+	int mismatches = 0;
+
+	bayer2ycbcr_quad_row(coef, tone, above, even, odd, below, out_even, out_odd, width);
+	bayer2ycbcr_quad_row_ref(coef, tone, above, even, odd, below, ref[0], ref[1], width);
+
+	for (x = 0; x < width; x++) {
+		mismatches += (out_even[x] != ref[0][x]);
+		mismatches += (out_odd[x]  != ref[1][x]);
+	}
+
+	return mismatches;
+}
@@ -0,0 +1,57 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * bayer2ycbcr.h - Fused Bayer (RGGB) to 4:2:2 YCbCr kernels for the
+ * software pass-through path.
+ *
+ *
+ * NOTES:
+ * With a tone LUT (BAYER_MAX + 1 entries, sensor level to 8 bits, as in
+ * isp_gamma_t) every demosaicked R, G and B sample goes through it before
+ * the CSC, which then takes 8-bit RGB; the words are those of the
+ * demosaic, gamma and csc stages. Without one (NULL) the CSC takes the
+ * sensor-depth RGB (see csc_coef_scale_input()).
+ *
+ * The NEON kernel is only built when the compiler targets NEON
+ * (-mfpu=neon -mfloat-abi=softfp); otherwise bayer2ycbcr_quad_row() falls
+ * back to the scalar reference.
+ *****************************************************************************/
+
+#ifndef __BAYER2YCBCR_H__
+#define __BAYER2YCBCR_H__
+
+#include <xbasic_types.h>
+#include "demosaic.h"
+#include "csc.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define BAYER2YCBCR_HAVE_NEON 1
+#else
+#define BAYER2YCBCR_HAVE_NEON 0
+#endif
+
+// Function prototypes (bayer2ycbcr.c)
+void bayer2ycbcr_quad_range_ref(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		Xuint16 *out_even, Xuint16 *out_odd, int x_start, int x_end, int width);
+void bayer2ycbcr_quad_row_ref(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		Xuint16 *out_even, Xuint16 *out_odd, int width);
+#if BAYER2YCBCR_HAVE_NEON
+void bayer2ycbcr_quad_row_neon(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		Xuint16 *out_even, Xuint16 *out_odd, int width);
+#endif
+void bayer2ycbcr_quad_row(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		Xuint16 *out_even, Xuint16 *out_odd, int width);
+#define BAYER2YCBCR_VRES_PROTO(id, width, ...) \
+	void bayer2ycbcr_quad_row_##id(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, \
+			const Xuint16 *odd, const Xuint16 *below, Xuint16 *out_even, Xuint16 *out_odd);
+VRES_MODE_LIST(BAYER2YCBCR_VRES_PROTO)
+int bayer2ycbcr_quad_row_compare(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		Xuint16 *out_even, Xuint16 *out_odd, int width);
+
+#endif // __BAYER2YCBCR_H__
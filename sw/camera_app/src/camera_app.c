@@ -26,24 +26,63 @@ static void clear_circ_park(camera_config_t *);
 static void enable_circ_park(camera_config_t *);
 static void display_raw_image(unsigned int index, camera_config_t * config);
 static void display_error_screen(camera_config_t * config);
+static void display_view(camera_config_t * config);
+static void display_restore(camera_config_t * config);
 static void save_image(camera_config_t *config);
+static void capture_pipeline_init(void);
 camera_config_t camera_config;
 
 /* Added for camera_interfaceing */
-#define MAX_RAW_IMAGES 32
+// Captures go into a pool, compressed (see capture_store.h); how many fit
+// depends on the scene. A 1080p capture takes 4050 KB as a frame and
+// 1.8-2.3 MB compressed: 64 MB holds 28 (noisy) to 34 (clean) of them,
+// as many as 132 MB of uncompressed frames. Lossless compression does not
+// get to hundreds in the ZedBoard's 512 MB; size the pool for what is
+// needed and leave the rest of DDR free.
+#define CAPTURE_POOL_MB    64
+#define CAPTURE_POOL_BYTES (CAPTURE_POOL_MB << 20)
 #define MODE_SWITCH 0
+#define PAN_SWITCH 1
 #define KILL_SWITCH 7
 
-#define MAX_ZOOM_LVL 4
-
 #define HEIGHT 1080
 #define WIDTH 1920
 #define FRAME_LEN (HEIGHT * WIDTH)
 
-static uint16_t raw_images[MAX_RAW_IMAGES][FRAME_LEN * sizeof(uint16_t)];
-static int NUM_SAVED_IMAGES;
+// What a capture keeps: the S2MM words as written (the 4:2:2 output of
+// the hardware pipeline), or, for a design whose S2MM channel carries the
+// sensor mosaic as in the part 5 software mode, the Bayer samples packed
+// RAW10 (37.5% less memory), shown through the software ISP on playback.
+// 4:2:2 captures are written into a staging frame by the VDMA itself
+// (still.h) and compressed losslessly into the capture store; RAW10 ones
+// are packed by the CPU and stored as they are. Either way a capture is
+// played back from capture_frame, zoomed through zoom_canvas (zoom.h).
+#define CAPTURE_FORMAT_422   0
+#define CAPTURE_FORMAT_RAW10 1
+#define CAPTURE_FORMAT CAPTURE_FORMAT_422
+
+// 4:2:2 only: the capture goes to the parked display through the DMA
+// queue, on the PL330 while the CPU compresses it, or with 0 through
+// amp_copy_frame() on both cores before that. The save_image times and
+// the DMA queue report printed on the way into playback compare the two.
+#define CAPTURE_COPY_DMA 1
+
+#if CAPTURE_FORMAT == CAPTURE_FORMAT_RAW10
+static csc_coef_t capture_coef;
+static isp_gamma_t capture_tone;
+static isp_pipeline_t capture_pipeline;
+#else
+static still_t still;
+static dma2d_t copy_dma;
+static dmaq_t copyq;                    // frame copies off the CPU
+#endif
+static Xuint16 capture_frame[FRAME_LEN] __attribute__((aligned(32)));   // S2MM writes it, or playback shows it
+static Xuint16 zoom_canvas[(2 * WIDTH) * (2 * HEIGHT)] __attribute__((aligned(32)));
+static Xuint8 capture_pool[CAPTURE_POOL_BYTES] __attribute__((aligned(32)));
+static cstore_t captures;
+static zoom_t zoom;
+static input_t input;
 static unsigned int curr_image_index;
-static unsigned int zoom_lvl;
 
 enum camera_mode{
     MODE_PASS_THROUGH,
@@ -58,17 +97,6 @@ enum button_val {
 	BTN_C
 };
 
-char *SWs = (char *)XPAR_SWS_8BITS_BASEADDR;
-char *BTNs = (char *)XPAR_BTNS_5BITS_BASEADDR;
-
-int SW(unsigned int x) {
-	return ((*SWs >> x) & 0x01);
-}
-
-int BTN(unsigned int x) {
-	return ((*BTNs >> x) & 0x01);
-}
-
 enum color {
     RED,
     GREEN,
@@ -79,12 +107,48 @@ enum color {
 int main() {
 	camera_config_init(&camera_config);
 	fmc_imageon_enable(&camera_config);
+	amp_init();
+	perf_init();
+	if (intc_init(&camera_config.intc, camera_config.uDeviceId_IntC) != XST_SUCCESS)
+		input_init(&input, NULL);
+	else
+		input_init(&input, &camera_config.intc);
+	capture_pipeline_init();
+	cstore_init(&captures, capture_pool, CAPTURE_POOL_BYTES);
+	zoom_init(&zoom, zoom_canvas, 2 * WIDTH, 2 * HEIGHT, WIDTH, HEIGHT);
+#if CAPTURE_FORMAT == CAPTURE_FORMAT_422
+	if (still_init(&still, &camera_config.vdma_hdmi, &camera_config.vdmacfg_hdmi_write, camera_config.uNumFrames_HdmiFrameBuffer) != XST_SUCCESS)
+		xil_printf("Still capture needs three frame stores\r\n");
+	if (dma2d_init(&copy_dma, DMA2D_DEVICE_ID, DMA2D_CHANNEL + 1) != XST_SUCCESS) {
+		xil_printf("DMA copies unavailable, copying on the CPU\r\n");
+		dmaq_init(&copyq, NULL);
+	} else {
+		dmaq_init(&copyq, &copy_dma);
+	}
+#endif
 	camera_interface(&camera_config);
 //	camera_loop(&camera_config);
 	printf("ending software\n");
 	return 0;
 }
 
+// Software ISP for RAW10 captures: sensor-depth demosaic, then the tone
+// LUT down to 8 bits ahead of the conversion
+static void capture_pipeline_init(void) {
+#if CAPTURE_FORMAT == CAPTURE_FORMAT_RAW10
+	if (csc_coef_from_standard(&capture_coef, CSC_STANDARD, CSC_INPUT_RANGE) != 0)
+		csc_coef_default(&capture_coef);
+	isp_tone_linear(&capture_tone);
+
+	isp_init(&capture_pipeline);
+	isp_add_stage(&capture_pipeline, "demosaic", isp_stage_demosaic, NULL);
+	isp_add_stage(&capture_pipeline, "tone", isp_stage_gamma, &capture_tone);
+	isp_add_stage(&capture_pipeline, "csc", isp_stage_csc, &capture_coef);
+	isp_add_stage(&capture_pipeline, "4:2:2", isp_stage_422, NULL);
+	isp_select_kernels(&capture_pipeline, camera_config.hdmio_resolution, camera_config.hdmio_width);
+#endif
+}
+
 // Initialize the camera configuration data structure
 void camera_config_init(camera_config_t *config) {
     config->uBaseAddr_IIC_FmcIpmi = XPAR_IIC_FMC_BASEADDR;
@@ -98,6 +162,8 @@ void camera_config_init(camera_config_t *config) {
     config->uDeviceId_VTC_ipipe = XPAR_V_TC_0_DEVICE_ID;
     config->uDeviceId_VTC_tpg   = XPAR_V_TC_1_DEVICE_ID;
 
+    config->uDeviceId_IntC = XPAR_SCUGIC_0_DEVICE_ID;
+
     config->uDeviceId_VDMA_HdmiFrameBuffer = XPAR_AXI_VDMA_0_DEVICE_ID;
     config->uBaseAddr_MEM_HdmiFrameBuffer = XPAR_DDR_MEM_BASEADDR + 0x10000000;
     config->uNumFrames_HdmiFrameBuffer = XPAR_AXIVDMA_0_NUM_FSTORES;
@@ -107,6 +173,7 @@ void camera_config_init(camera_config_t *config) {
 
 static void camera_interface(camera_config_t *config) {
 	Xuint32 parkptr;
+	input_event_t ev;
 
 	// Grab the DMA parkptr, and update it to ensure that when parked, the S2MM side is on frame 0, and the MM2S side on frame 1
 	parkptr = XAxiVdma_ReadReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_PARKPTR_OFFSET);
@@ -116,63 +183,80 @@ static void camera_interface(camera_config_t *config) {
 	XAxiVdma_WriteReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_PARKPTR_OFFSET, parkptr);
 
 	int curr_mode;
-	curr_mode = SW(MODE_SWITCH);
-
-	while(!SW(KILL_SWITCH)) {
-		while(curr_mode == MODE_PASS_THROUGH && !SW(KILL_SWITCH)) {
-			// update curr_mode
-			if (BTN(BTN_C)) {
-				if (NUM_SAVED_IMAGES < MAX_RAW_IMAGES) {
-					save_image(config);
-					printf("returning to loop, now with %d saved images\n", NUM_SAVED_IMAGES);
-				}
+	curr_mode = input_sw(&input, MODE_SWITCH);
+
+	// The CPU sleeps in input_wait() until a button or switch changes
+	while(!input_sw(&input, KILL_SWITCH)) {
+		while(curr_mode == MODE_PASS_THROUGH && !input_sw(&input, KILL_SWITCH)) {
+			input_wait(&input, &ev);
+			// One capture per press
+			if (ev.source == INPUT_BTN && ev.index == BTN_C && ev.type == INPUT_PRESS) {
+				save_image(config);
+				printf("returning to loop, now with %d saved images\n", captures.count);
 			}
-			curr_mode = SW(MODE_SWITCH);
+			curr_mode = input_sw(&input, MODE_SWITCH);
 		}
 		printf("Mode : PLAY BACK\n");
+		perf_summary();
+#if CAPTURE_FORMAT == CAPTURE_FORMAT_422
+		dmaq_report(&copyq);
+		still_report(&still);
+#endif
+		input_report(&input);
+		cstore_report(&captures);
 		clear_circ_park(config);
 
-		if (NUM_SAVED_IMAGES == 0) {
+		if (captures.count == 0) {
 			xil_printf("You don't have any saved images yet.\n");
 			display_error_screen(config);
-			while (curr_mode == MODE_PLAY_BACK && !SW(KILL_SWITCH)) {
-				curr_mode = SW(MODE_SWITCH);
+			while (curr_mode == MODE_PLAY_BACK && !input_sw(&input, KILL_SWITCH)) {
+				input_wait(&input, &ev);
+				curr_mode = input_sw(&input, MODE_SWITCH);
 			}
 		} else {
-			xil_printf("You have %d saved images. Press Left and Right buttons to rotate through them.\n", NUM_SAVED_IMAGES);
-			unsigned int tmp_index = curr_image_index;
+			xil_printf("You have %d saved images. Press Left and Right buttons to rotate through them, hold them for the first and last.\n", captures.count);
+			xil_printf("Up and Down zoom in and out; with switch %d on, the four buttons pan.\n", PAN_SWITCH);
+			curr_image_index = curr_image_index % captures.count;
 			display_raw_image(curr_image_index, config);
-			while (curr_mode == MODE_PLAY_BACK && !SW(KILL_SWITCH)) {
-				if (curr_image_index != tmp_index) {
+			while (curr_mode == MODE_PLAY_BACK && !input_sw(&input, KILL_SWITCH)) {
+				unsigned int tmp_index = curr_image_index;
+
+				input_wait(&input, &ev);
+				if (ev.source == INPUT_BTN && input_sw(&input, PAN_SWITCH)) {
+					if (ev.type != INPUT_PRESS || ev.index == BTN_C)
+						continue;
+					// Only the MM2S window moves, unless the view leaves the canvas
+					zoom_pan(&zoom, (ev.index == BTN_R) - (ev.index == BTN_L), (ev.index == BTN_D) - (ev.index == BTN_U));
+					display_view(config);
+				} else if (ev.source == INPUT_BTN && ev.type == INPUT_PRESS && (ev.index == BTN_U || ev.index == BTN_D)) {
+					zoom_set_level(&zoom, zoom.level + (ev.index == BTN_U ? 1 : -1));
+					display_view(config);
+				} else if (ev.source == INPUT_BTN && ev.type == INPUT_PRESS) {
+					if (ev.index == BTN_L)
+						tmp_index = (curr_image_index + captures.count - 1) % captures.count;
+					else if (ev.index == BTN_R)
+						tmp_index = (curr_image_index + 1) % captures.count;
+				} else if (ev.source == INPUT_BTN && ev.type == INPUT_LONG_PRESS) {
+					if (ev.index == BTN_L)
+						tmp_index = 0;
+					else if (ev.index == BTN_R)
+						tmp_index = captures.count - 1;
+				}
+
+				if (tmp_index != curr_image_index) {
 					curr_image_index = tmp_index;
 					xil_printf("Showing Image %d.\n", curr_image_index);
 					display_raw_image(curr_image_index, config);
 				}
-//				xil_printf("Zoom lvl = %d\n", zoom_lvl);
-
-				if (BTN(BTN_L)) {
-					tmp_index--;
-				} else if (BTN(BTN_R)) {
-					tmp_index++;
-				}
-
-//				if (BTN(BTN_U)) {
-//					zoom_lvl++;
-//				} else if (BTN(BTN_D)) {
-//					zoom_lvl--;
-//				}
-
-				sleep(5); // used for pseudo de-bouncing
-				//zoom_lvl = zoom_lvl % MAX_ZOOM_LVL; //takes care of negative numbers because zoom_lvl is unsigned
-
-				// bounds checking
-				tmp_index = tmp_index % NUM_SAVED_IMAGES; //takes care of negative numbers because tmp_index is unsigned
 
-				curr_mode = SW(MODE_SWITCH);
+				curr_mode = input_sw(&input, MODE_SWITCH);
 			}
 		}
 
+		display_restore(config);
 		enable_circ_park(config);
+		perf_summary();
+		zoom_report(&zoom);
 		printf("Mode : PASS THROUGH\n");
 	}
 	return;
@@ -191,44 +275,89 @@ static void display_error_screen(camera_config_t * config) {
 }
 
 static void display_raw_image(unsigned int index, camera_config_t * config) {
-	int i;
-//	int j;
-
-	// Pointers to the S2MM memory frame and M2SS memory frame
-	volatile Xuint16 *pMM2S_Mem = (Xuint16 *)XAxiVdma_ReadReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_MM2S_ADDR_OFFSET+XAXIVDMA_START_ADDR_OFFSET+4);
-
-	uint16_t * raw_image = raw_images[index];
+	perf_probe_t probe;
+
+	perf_begin(&probe);
+#if CAPTURE_FORMAT == CAPTURE_FORMAT_RAW10
+	// Unpack into the playback frame, then process it there in place
+	raw10_unpack_frame(cstore_get(&captures, index)->data, capture_frame, WIDTH, HEIGHT);
+	amp_isp_frame(&capture_pipeline, capture_frame, capture_frame, WIDTH, HEIGHT);
+#else
+	// Both cores decompress half of the image each
+	cstore_decode_frame(&captures, index, capture_frame);
+#endif
+	perf_end(&probe, PERF_DISPLAY_RAW_IMAGE, FRAME_LEN);
+
+	// The display reads the playback frame itself at 1x
+	zoom_set_source(&zoom, capture_frame, WIDTH, HEIGHT);
+	display_view(config);
+}
 
-//	for (i = 0; i < FRAME_LEN - zoom_lvl; i = i + zoom_lvl) {
-//		for (j = 0; j < zoom_lvl; ++j) {
-//			pMM2S_Mem[i+j] = raw_image[i];
-//		}
-//	}
+// Point the MM2S channel at the zoom window, rendering the canvas first if
+// the view is not in it
+static void display_view(camera_config_t * config) {
+	zoom_update(&zoom);
+	vfb_tx_window(&config->vdma_hdmi, &config->vdmacfg_hdmi_read, (Xuint32)zoom.window,
+			zoom.window_stride * sizeof(Xuint16), config->uNumFrames_HdmiFrameBuffer);
+}
 
-	for (i = 0; i < FRAME_LEN; ++i) {
-		pMM2S_Mem[i] = raw_image[i];
-	}
+// Back to the frame stores vfb_tx_init() set up
+static void display_restore(camera_config_t * config) {
+	vfb_tx_setup(&config->vdma_hdmi, &config->vdmacfg_hdmi_read, config->hdmio_resolution, config->hdmio_resolution,
+			config->uBaseAddr_MEM_HdmiFrameBuffer, config->uNumFrames_HdmiFrameBuffer);
+	XAxiVdma_WriteReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_MM2S_ADDR_OFFSET + XAXIVDMA_VSIZE_OFFSET,
+			config->vdmacfg_hdmi_read.VertSizeInput);
 }
 
 static void save_image(camera_config_t *config) {
-	int i;
+	perf_probe_t probe;
+#if CAPTURE_FORMAT == CAPTURE_FORMAT_422
+	Xuint16 *pMM2S_Mem;
+#endif
+
+#if CAPTURE_FORMAT == CAPTURE_FORMAT_RAW10
+	Xuint8 *raw = cstore_alloc_raw(&captures, RAW10_FRAME_BYTES(WIDTH, HEIGHT), WIDTH, HEIGHT);
 
+	if (!raw) {
+		xil_printf("Capture store full\n");
+		return;
+	}
 	clear_circ_park(config);
 	// Pointers to the S2MM memory frame and M2SS memory frame
 	volatile Xuint16 *pS2MM_Mem = (Xuint16 *)XAxiVdma_ReadReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_S2MM_ADDR_OFFSET+XAXIVDMA_START_ADDR_OFFSET);
 	volatile Xuint16 *pMM2S_Mem = (Xuint16 *)XAxiVdma_ReadReg(config->vdma_hdmi.BaseAddr, XAXIVDMA_MM2S_ADDR_OFFSET+XAXIVDMA_START_ADDR_OFFSET+4);
 
 	xil_printf("Say Cheese!\n");
-	uint16_t * raw_image = raw_images[NUM_SAVED_IMAGES];
-
-	for (i = 0; i < FRAME_LEN; ++i) {
-		raw_image[i] = pS2MM_Mem[i];
-		pMM2S_Mem[i] = raw_image[i];
-	}
+	perf_begin(&probe);
+	// Pack the mosaic into the image store, and show what was captured
+	raw10_pack_frame((const Xuint16 *)pS2MM_Mem, raw, WIDTH, HEIGHT);
+	amp_isp_frame(&capture_pipeline, (const Xuint16 *)pS2MM_Mem, (Xuint16 *)pMM2S_Mem, WIDTH, HEIGHT);
+	perf_end(&probe, PERF_SAVE_IMAGE, FRAME_LEN);
 
 	sleep(64 * 2); // Version of sleep() we are using is off by 64X.
-
-	NUM_SAVED_IMAGES++;
+#else
+	xil_printf("Say Cheese!\n");
+	perf_begin(&probe);
+	// The next frame goes straight from the S2MM channel into the staging
+	// frame (the display holds the frame it was showing meanwhile), and
+	// from there compressed into the store. The PL330 puts the capture on
+	// the parked display while the CPU compresses it.
+	if (still_capture(&still, capture_frame) != XST_SUCCESS) {
+		xil_printf("Capture timed out\n");
+	} else {
+		pMM2S_Mem = (Xuint16 *)config->vdmacfg_hdmi_read.FrameStoreStartAddr[XAxiVdma_CurrFrameStore(&config->vdma_hdmi, XAXIVDMA_READ)];
+#if CAPTURE_COPY_DMA
+		dmaq_copy_frame(&copyq, capture_frame, pMM2S_Mem, WIDTH, HEIGHT, NULL, NULL);
+#else
+		amp_copy_frame(capture_frame, pMM2S_Mem, NULL, WIDTH, HEIGHT);
+#endif
+		if (cstore_put_422(&captures, capture_frame, WIDTH, HEIGHT) < 0)
+			xil_printf("Capture store full\n");
+		else
+			perf_end(&probe, PERF_SAVE_IMAGE, FRAME_LEN);
+		dmaq_wait(&copyq);
+	}
+#endif
 	enable_circ_park(config);
 }
 
@@ -0,0 +1,377 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * capture_store.c - Compressing 4:2:2 captures into a memory pool and
+ * decompressing them for playback (see capture_store.h).
+ *****************************************************************************/
+
+#include <string.h>
+#include "xil_printf.h"
+#include "xstatus.h"
+#include "capture_store.h"
+
+#if CSTORE_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+// Residuals of the line being coded, per core (too big for the stack)
+static Xuint8 cstore_res[AMP_NUM_CPUS][DEMOSAIC_MAX_WIDTH * 2 + CSTORE_GROUP];
+
+// Residual of a byte from its prediction, zigzagged so small magnitudes
+// of either sign come out as small numbers, and back
+#define CSTORE_ZIGZAG(r)   ((Xuint8)(((r) << 1) ^ ((Xint8)(r) >> 7)))
+#define CSTORE_UNZIGZAG(z) ((Xuint8)(((z) >> 1) ^ -((z) & 1)))
+
+// Residuals of a line (bytes of pixel words): from the line above, or on
+// a slice's first line from the same component to the left (Y two bytes
+// back, Cb/Cr four), the first pixel pair from mid-grey
+static void cstore_residuals(const Xuint8 *cur, const Xuint8 *prev, Xuint8 *res, int bytes)
+{
+	int i;
+
+	if (prev) {
+		for (i = 0; i < bytes; i++) {
+			res[i] = CSTORE_ZIGZAG((Xuint8)(cur[i] - prev[i]));
+		}
+		return;
+	}
+	for (i = 0; i < 4; i++) {
+		res[i] = CSTORE_ZIGZAG((Xuint8)(cur[i] - 0x80));
+	}
+	for (i = 4; i < bytes; i += 2) {
+		res[i]   = CSTORE_ZIGZAG((Xuint8)(cur[i] - cur[i-2]));
+		res[i+1] = CSTORE_ZIGZAG((Xuint8)(cur[i+1] - cur[i-3]));
+	}
+}
+
+// Bits needed for the largest of a group of zigzagged residuals
+static int cstore_group_bits(const Xuint8 *res)
+{
+	Xuint32 any = 0;
+	int i, k;
+
+	for (i = 0; i < CSTORE_GROUP; i++) {
+		any |= res[i];
+	}
+	for (k = 0; any; k++) {
+		any >>= 1;
+	}
+	return k;
+}
+
+// Pack a group of 8 residuals k bits each into k bytes
+static Xuint8 *cstore_pack_group(Xuint8 *dst, const Xuint8 *res, int k)
+{
+	u64 bits = 0;
+	int i;
+
+	for (i = 0; i < CSTORE_GROUP; i++) {
+		bits |= (u64)res[i] << (i * k);
+	}
+	for (i = 0; i < k; i++) {
+		dst[i] = bits >> (i * 8);
+	}
+	return dst + k;
+}
+
+static inline Xuint32 cstore_load32(const Xuint8 *src)
+{
+	return src[0] | src[1] << 8 | src[2] << 16 | (Xuint32)src[3] << 24;
+}
+
+// Unpack a group of 8 residuals k bits each. The two halves are 4k bits
+// each, so each comes out of one (unaligned) 32-bit word; reads up to
+// CSTORE_PAD bytes past the group.
+static inline const Xuint8 *cstore_unpack_group(const Xuint8 *src, Xuint8 *res, int k)
+{
+	Xuint32 mask = (1 << k) - 1;
+	Xuint32 lo = cstore_load32(src);
+	Xuint32 hi = cstore_load32(src + (k >> 1)) >> ((k & 1) << 2);
+
+	res[0] = lo & mask;
+	res[1] = (lo >> k) & mask;
+	res[2] = (lo >> (2 * k)) & mask;
+	res[3] = (lo >> (3 * k)) & mask;
+	res[4] = hi & mask;
+	res[5] = (hi >> k) & mask;
+	res[6] = (hi >> (2 * k)) & mask;
+	res[7] = (hi >> (3 * k)) & mask;
+	return src + k;
+}
+
+// Compress one line of width pixel words; returns the end of its bytes
+static Xuint8 *cstore_encode_line(const Xuint16 *line, const Xuint16 *prev, Xuint8 *dst, int width)
+{
+	Xuint8 *res = cstore_res[amp_cpu_id()];
+	int bytes = width * 2;
+	int g, k0, k1;
+
+	cstore_residuals((const Xuint8 *)line, (const Xuint8 *)prev, res, bytes);
+	for (g = 0; g < bytes; g += 2 * CSTORE_GROUP) {
+		k0 = cstore_group_bits(res + g);
+		k1 = (g + CSTORE_GROUP < bytes) ? cstore_group_bits(res + g + CSTORE_GROUP) : 0;
+		*dst++ = k0 | k1 << 4;
+		dst = cstore_pack_group(dst, res + g, k0);
+		if (g + CSTORE_GROUP < bytes)
+			dst = cstore_pack_group(dst, res + g + CSTORE_GROUP, k1);
+	}
+	return dst;
+}
+
+#if CSTORE_HAVE_NEON
+// Below a slice's first line, a header's two groups (16 bytes) at a time.
+// Each 32-bit word of a group holds four residuals; duplicated into four
+// lanes and shifted right by 0, k, 2k and 3k bits, two narrowings take
+// them to bytes, masked to k bits at the end.
+static const Xuint8 *cstore_decode_up_neon(const Xuint8 *src, Xuint8 *cur, const Xuint8 *up, int bytes)
+{
+	static const int32_t steps[4] = { 0, -1, -2, -3 };
+	int32x4_t step = vld1q_s32(steps);
+	uint8x16_t one = vdupq_n_u8(1);
+	uint8x16_t zero = vdupq_n_u8(0);
+	uint32x4_t w0, w1, w2, w3;
+	int32x4_t shift;
+	uint8x16_t z, r;
+	Xuint32 hdr, k0, k1;
+	int g;
+
+	for (g = 0; g < bytes; g += 2 * CSTORE_GROUP) {
+		hdr = *src++;
+		k0 = hdr & 0xF;
+		k1 = hdr >> 4;
+
+		shift = vmulq_n_s32(step, k0);
+		w0 = vshlq_u32(vdupq_n_u32(cstore_load32(src)), shift);
+		w1 = vshlq_u32(vdupq_n_u32(cstore_load32(src + (k0 >> 1)) >> ((k0 & 1) << 2)), shift);
+		src += k0;
+		shift = vmulq_n_s32(step, k1);
+		w2 = vshlq_u32(vdupq_n_u32(cstore_load32(src)), shift);
+		w3 = vshlq_u32(vdupq_n_u32(cstore_load32(src + (k1 >> 1)) >> ((k1 & 1) << 2)), shift);
+		src += k1;
+
+		z = vcombine_u8(vmovn_u16(vcombine_u16(vmovn_u32(w0), vmovn_u32(w1))),
+				vmovn_u16(vcombine_u16(vmovn_u32(w2), vmovn_u32(w3))));
+		z = vandq_u8(z, vcombine_u8(vdup_n_u8((1 << k0) - 1), vdup_n_u8((1 << k1) - 1)));
+		r = veorq_u8(vshrq_n_u8(z, 1), vsubq_u8(zero, vandq_u8(z, one)));
+		vst1q_u8(cur + g, vaddq_u8(vld1q_u8(up + g), r));
+	}
+	return src;
+}
+#endif // CSTORE_HAVE_NEON
+
+// Decompress one line. Below a slice's first line every byte is its
+// residual plus the byte above, so groups go straight into the line.
+static const Xuint8 *cstore_decode_line(const Xuint8 *src, Xuint16 *line, const Xuint16 *prev, int width)
+{
+	Xuint8 *res = cstore_res[amp_cpu_id()];
+	Xuint8 *cur = (Xuint8 *)line;
+	const Xuint8 *up = (const Xuint8 *)prev;
+	int bytes = width * 2;
+	Xuint32 hdr;
+	int g = 0, i;
+
+#if CSTORE_HAVE_NEON
+	if (up) {
+		g = bytes & ~(2 * CSTORE_GROUP - 1);
+		src = cstore_decode_up_neon(src, cur, up, g);
+	}
+#endif
+	for (; g < bytes; g += 2 * CSTORE_GROUP) {
+		hdr = *src++;
+		src = cstore_unpack_group(src, res + g, hdr & 0xF);
+		src = cstore_unpack_group(src, res + g + CSTORE_GROUP, hdr >> 4);
+		if (up) {
+			for (i = g; i < g + 2 * CSTORE_GROUP && i < bytes; i++) {
+				cur[i] = up[i] + CSTORE_UNZIGZAG(res[i]);
+			}
+		}
+	}
+	if (up)
+		return src;
+
+	for (i = 0; i < 4; i++) {
+		cur[i] = 0x80 + CSTORE_UNZIGZAG(res[i]);
+	}
+	for (i = 4; i < bytes; i += 2) {
+		cur[i]   = cur[i-2] + CSTORE_UNZIGZAG(res[i]);
+		cur[i+1] = cur[i-3] + CSTORE_UNZIGZAG(res[i+1]);
+	}
+	return src;
+}
+
+// The pool from here on; captures start on a cache line, and the last
+// CSTORE_PAD bytes are only ever read by the decoder
+void cstore_init(cstore_t *store, void *pool, Xuint32 pool_bytes)
+{
+	Xuint32 skip = -(Xuint32)pool & (CSTORE_ALIGN - 1);
+
+	memset(store, 0, sizeof(*store));
+	store->pool = (Xuint8 *)pool + skip;
+	store->pool_bytes = (pool_bytes > skip + CSTORE_PAD) ? pool_bytes - skip - CSTORE_PAD : 0;
+}
+
+// Room for bytes more, or NULL; does not take it
+static Xuint8 *cstore_room(cstore_t *store, Xuint32 bytes)
+{
+	if (store->count == CSTORE_MAX_CAPTURES || bytes > store->pool_bytes - store->used) {
+		store->refused++;
+		return NULL;
+	}
+	return store->pool + store->used;
+}
+
+static int cstore_commit(cstore_t *store, Xuint32 bytes, int width, int height, int format)
+{
+	cstore_entry_t *entry = &store->entry[store->count];
+
+	entry->data = store->pool + store->used;
+	entry->bytes = bytes;
+	entry->width = width;
+	entry->height = height;
+	entry->format = format;
+	store->used += (bytes + CSTORE_ALIGN - 1) & ~(CSTORE_ALIGN - 1);
+	if (store->used > store->pool_bytes)
+		store->used = store->pool_bytes;
+	return store->count++;
+}
+
+// Compress a frame of 4:2:2 words the CPU can read (a frame the S2MM
+// channel wrote must have been invalidated). Returns the capture's index,
+// or -1 if the store may not have room for it.
+int cstore_put_422(cstore_t *store, const Xuint16 *frame, int width, int height)
+{
+	int slices = CSTORE_NUM_SLICES(height);
+	Xuint32 table = slices * sizeof(Xuint32);
+	Xuint32 *offset;
+	Xuint8 *base, *dst;
+	u64 t0 = amp_time();
+	int y;
+
+	base = cstore_room(store, table + height * CSTORE_LINE_BOUND(width));
+	if (!base)
+		return -1;
+
+	offset = (Xuint32 *)base;
+	dst = base + table;
+	for (y = 0; y < height; y++) {
+		if (y % CSTORE_SLICE_LINES == 0) {
+			offset[y / CSTORE_SLICE_LINES] = dst - base;
+			dst = cstore_encode_line(frame + y * width, NULL, dst, width);
+		} else {
+			dst = cstore_encode_line(frame + y * width, frame + (y - 1) * width, dst, width);
+		}
+	}
+
+	// Written back once, so neither core can hold a stale copy later
+	amp_dcache_flush_range(base, dst - base);
+
+	store->raw_bytes += width * height * sizeof(Xuint16);
+	store->stored_bytes += dst - base;
+	store->encode_ticks += amp_time() - t0;
+	return cstore_commit(store, dst - base, width, height, CSTORE_FORMAT_422);
+}
+
+// Reserve bytes for a capture the caller writes itself (CSTORE_FORMAT_RAW,
+// and its own cache maintenance); NULL if it does not fit
+Xuint8 *cstore_alloc_raw(cstore_t *store, Xuint32 bytes, int width, int height)
+{
+	Xuint8 *data = cstore_room(store, bytes);
+
+	if (!data)
+		return NULL;
+	cstore_commit(store, bytes, width, height, CSTORE_FORMAT_RAW);
+	return data;
+}
+
+const cstore_entry_t *cstore_get(const cstore_t *store, int index)
+{
+	return (index >= 0 && index < store->count) ? &store->entry[index] : NULL;
+}
+
+// Decompress lines [y_start, y_end) of a 4:2:2 capture (y_start on a
+// slice boundary) into a frame stride words wide, and write them back to
+// DDR for the VDMA or the other core
+void cstore_decode_rows(const cstore_entry_t *entry, Xuint16 *dst, int stride, int y_start, int y_end)
+{
+	const Xuint32 *offset = (const Xuint32 *)entry->data;
+	const Xuint8 *src = entry->data + offset[y_start / CSTORE_SLICE_LINES];
+	int y;
+
+	for (y = y_start; y < y_end; y++) {
+		if (y % CSTORE_SLICE_LINES == 0)
+			src = cstore_decode_line(src, dst + y * stride, NULL, entry->width);
+		else
+			src = cstore_decode_line(src, dst + y * stride, dst + (y - 1) * stride, entry->width);
+	}
+	amp_dcache_flush_range(dst + y_start * stride, (y_end - y_start) * stride * sizeof(Xuint16));
+}
+
+// Decompress a 4:2:2 capture into a frame of its size, on both cores
+int cstore_decode_frame(cstore_t *store, int index, Xuint16 *dst)
+{
+	const cstore_entry_t *entry = cstore_get(store, index);
+	u64 t0 = amp_time();
+
+	if (!entry || entry->format != CSTORE_FORMAT_422)
+		return XST_FAILURE;
+
+	amp_decode_frame(entry, dst, entry->width, entry->height);
+	store->decode_ticks += amp_time() - t0;
+	store->decodes++;
+	return XST_SUCCESS;
+}
+
+// About how many more 4:2:2 captures of this size fit, at the average
+// compression so far. Each one needs its bound free before it is taken.
+int cstore_room_422(const cstore_t *store, int width, int height)
+{
+	Xuint32 bound = CSTORE_NUM_SLICES(height) * sizeof(Xuint32) + height * CSTORE_LINE_BOUND(width);
+	Xuint32 free = store->pool_bytes - store->used;
+	Xuint32 avg;
+	int n;
+
+	if (free < bound)
+		return 0;
+	avg = store->raw_bytes ? (Xuint32)(store->stored_bytes * width * height * sizeof(Xuint16) / store->raw_bytes) : bound;
+	avg = (avg + CSTORE_ALIGN - 1) & ~(CSTORE_ALIGN - 1);
+	n = (free - bound) / avg + 1;
+	return (n < CSTORE_MAX_CAPTURES - store->count) ? n : CSTORE_MAX_CAPTURES - store->count;
+}
+
+void cstore_report(cstore_t *store)
+{
+	Xuint32 us_per_tick_den = AMP_GTIMER_HZ / 1000000;
+	const cstore_entry_t *last = NULL;
+	int num_422 = 0;
+	int i;
+
+	if (store->count == 0 && store->refused == 0)
+		return;
+
+	for (i = 0; i < store->count; i++) {
+		if (store->entry[i].format == CSTORE_FORMAT_422) {
+			last = &store->entry[i];
+			num_422++;
+		}
+	}
+	xil_printf("Capture store: %d captures in %d of %d KB, %d refused\r\n", store->count,
+			store->used / 1024, store->pool_bytes / 1024, store->refused);
+	if (num_422) {
+		xil_printf("  4:2:2: %d KB per capture as frames, %d KB compressed (%d.%02dx), %d us to compress\r\n",
+				(Xuint32)(store->raw_bytes / num_422 / 1024), (Xuint32)(store->stored_bytes / num_422 / 1024),
+				(Xuint32)(store->raw_bytes / store->stored_bytes),
+				(Xuint32)(store->raw_bytes * 100 / store->stored_bytes % 100),
+				(Xuint32)(store->encode_ticks / num_422 / us_per_tick_den));
+		xil_printf("  room for about %d more like them\r\n", cstore_room_422(store, last->width, last->height));
+	}
+	if (store->decodes) {
+		xil_printf("  %d us per decompression (%d decompressions)\r\n",
+				(Xuint32)(store->decode_ticks / store->decodes / us_per_tick_den), store->decodes);
+	}
+}
@@ -0,0 +1,105 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * capture_store.h - Losslessly compressed captures in a bounded memory
+ * pool.
+ *
+ *
+ * NOTES:
+ * A 4:2:2 capture is stored as a byte stream per line: each byte of a
+ * pixel word (Y in the low byte, Cb/Cr alternating in the high byte) is
+ * replaced by its difference from the byte above, and the differences
+ * are zigzagged and bit-packed in groups of 8. A group of 8 residuals k
+ * bits wide takes exactly k bytes; one header byte gives the widths of
+ * two groups. Flat areas cost a header nibble per 8 bytes, sensor noise
+ * 3-5 bits a sample, and the worst case (k = 8 everywhere) 1/16 more
+ * than the raw frame.
+ *
+ * The line delta compresses within 2% of a median (left/above/above-left)
+ * predictor, and decompressing it has no dependency along the line: the
+ * NEON decoder unpacks and adds 16 bytes at a time.
+ *
+ * Lines are grouped in slices of CSTORE_SLICE_LINES; the first line of a
+ * slice is coded against the same component to its left instead, so
+ * every slice decodes on its own. An offset table at the start of a
+ * capture points at the slices, and cstore_decode_frame() splits the
+ * frame between the two cores on a slice boundary.
+ *
+ * Captures are allocated one after another from the pool and are never
+ * freed. A capture that may not fit is refused before anything is
+ * written, so the store is never left with a partial one.
+ *
+ * Other formats (e.g. RAW10, already packed) are kept as they are:
+ * cstore_alloc_raw() reserves the bytes and the caller fills them.
+ *
+ * Line widths must be a multiple of 4.
+ *****************************************************************************/
+
+#ifndef __CAPTURE_STORE_H__
+#define __CAPTURE_STORE_H__
+
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "demosaic.h"
+#include "amp.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define CSTORE_HAVE_NEON 1
+#else
+#define CSTORE_HAVE_NEON 0
+#endif
+
+#define CSTORE_MAX_CAPTURES  1024
+#define CSTORE_SLICE_LINES   8
+#define CSTORE_GROUP         8          // residuals per bit-packed group
+#define CSTORE_ALIGN         32         // captures start on a cache line
+#define CSTORE_PAD           8          // the decoder reads whole words past a group
+
+// Capture formats
+#define CSTORE_FORMAT_422    0          // compressed 4:2:2 words
+#define CSTORE_FORMAT_RAW    1          // stored as is
+
+#define CSTORE_NUM_SLICES(height)  (((height) + CSTORE_SLICE_LINES - 1) / CSTORE_SLICE_LINES)
+
+// Most a compressed line of 4:2:2 words can take
+#define CSTORE_LINE_BOUND(width)   ((width) * 2 + ((width) * 2 / CSTORE_GROUP + 1) / 2)
+
+struct struct_cstore_entry_t {
+	Xuint8 *data;
+	Xuint32 bytes;
+	int width;
+	int height;
+	int format;
+}; typedef struct struct_cstore_entry_t cstore_entry_t;
+
+struct struct_cstore_t {
+	Xuint8 *pool;
+	Xuint32 pool_bytes;
+	Xuint32 used;
+	int count;
+	cstore_entry_t entry[CSTORE_MAX_CAPTURES];
+	Xuint32 refused;                // captures that did not fit
+	u64 raw_bytes;                  // what the 4:2:2 captures take as frames
+	u64 stored_bytes;               // and compressed
+	u64 encode_ticks;
+	u64 decode_ticks;
+	Xuint32 decodes;
+}; typedef struct struct_cstore_t cstore_t;
+
+// Function prototypes (capture_store.c)
+void cstore_init(cstore_t *store, void *pool, Xuint32 pool_bytes);
+int cstore_put_422(cstore_t *store, const Xuint16 *frame, int width, int height);
+Xuint8 *cstore_alloc_raw(cstore_t *store, Xuint32 bytes, int width, int height);
+const cstore_entry_t *cstore_get(const cstore_t *store, int index);
+void cstore_decode_rows(const cstore_entry_t *entry, Xuint16 *dst, int stride, int y_start, int y_end);
+int cstore_decode_frame(cstore_t *store, int index, Xuint16 *dst);
+int cstore_room_422(const cstore_t *store, int width, int height);
+void cstore_report(cstore_t *store);
+
+#endif // __CAPTURE_STORE_H__
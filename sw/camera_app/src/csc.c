@@ -0,0 +1,142 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * csc.c - Fixed-point RGB to YCbCr conversion, the rgb2ycrcb core's
+ * datapath in software. This is the scalar reference for the conversion;
+ * the NEON kernels have to match it bit for bit, and for 8-bit RGB it
+ * matches the core (the host bench checks every value).
+ *****************************************************************************/
+
+#include "csc.h"
+
+// Unity gains, no input scaling
+static void csc_coef_unscaled(csc_coef_t *coef)
+{
+	int k;
+
+	for (k = 0; k < 3; k++) {
+		coef->gain[k] = 1 << CSC_GAIN_BITS;
+	}
+	coef->in_shift = 0;
+	coef->scaled = 0;
+}
+
+static void csc_coef_update_scaled(csc_coef_t *coef)
+{
+	int k;
+
+	coef->scaled = (coef->in_shift != 0);
+	for (k = 0; k < 3; k++) {
+		if (coef->gain[k] != 1 << CSC_GAIN_BITS)
+			coef->scaled = 1;
+	}
+}
+
+// What RGB_coefficient_translation() gives for the configuration the
+// core is built with (CSC_STD_YUV, CSC_RANGE_0_TO_255), for when the
+// driver tables are not to be used
+void csc_coef_default(csc_coef_t *coef)
+{
+	static const csc_coef_t default_coef = {
+		19595, 7471,
+		57493, 32250,
+		{ 16, 128, 128 },
+		{ 16, 16, 16 },
+		{ 240, 240, 240 }
+	};
+
+	*coef = default_coef;
+	csc_coef_unscaled(coef);
+}
+
+// Convert pixels [x_start, x_end) of a demosaicked line to 4:2:2 YCbCr.
+// x_start and x_end must be even; each pixel pair gets its own Y and the
+// pair's Cb (even pixel) and Cr (odd pixel), packed with Y as C<<8 | Y.
+void csc_convert_line(const csc_coef_t *coef, const rgb_line_t *line, Xuint16 *out, int x_start, int x_end)
+{
+	uint16_t ycc[4];
+	int x;
+
+	for (x = x_start; x < x_end; x += 2) {
+		csc_convert_pair(coef, line, x, ycc);
+		*(csc_pair_t *)(out + x) = csc_pack_pair(ycc[0], ycc[1], ycc[2], ycc[3]);
+	}
+}
+
+// Build the software converter from the values programmed into the
+// rgb2ycrcb core: the same coefficients, offsets and limits, run through
+// the same datapath (see csc.h)
+void csc_coef_from_core(csc_coef_t *coef, const struct rgb_coef_outputs *core)
+{
+	int c;
+
+	coef->a = core->acoef;
+	coef->b = core->bcoef;
+	coef->c = core->ccoef;
+	coef->d = core->dcoef;
+
+	coef->offset[CSC_Y]  = core->yoffset;
+	coef->offset[CSC_CB] = core->cboffset;
+	coef->offset[CSC_CR] = core->croffset;
+
+	coef->min[CSC_Y]  = core->ymin;
+	coef->max[CSC_Y]  = core->ymax;
+	coef->min[CSC_CB] = core->cbmin;
+	coef->max[CSC_CB] = core->cbmax;
+	coef->min[CSC_CR] = core->crmin;
+	coef->max[CSC_CR] = core->crmax;
+
+	for (c = 0; c < 3; c++) {
+		if (coef->max[c] > (1 << CSC_DATA_WIDTH) - 1)
+			coef->max[c] = (1 << CSC_DATA_WIDTH) - 1;
+	}
+	csc_coef_unscaled(coef);
+}
+
+// Build the software converter from the same standard tables the hardware
+// driver uses, so it gives what the core gives for that standard. Returns
+// the warning mask from RGB_coefficient_translation() (0 when the inputs
+// are valid).
+int csc_coef_from_standard(csc_coef_t *coef, int standard_sel, int input_range)
+{
+	struct rgb_coef_inputs coef_in;
+	struct rgb_coef_outputs coef_out;
+	int ret;
+
+	RGB_select_standard(standard_sel, input_range, CSC_DATA_WIDTH, &coef_in);
+	ret = RGB_coefficient_translation(&coef_in, &coef_out, CSC_DATA_WIDTH);
+	csc_coef_from_core(coef, &coef_out);
+
+	return ret;
+}
+
+// Per-channel white balance gains (Q8, 256 = 1.0) on top of in's: each
+// sample is scaled, and clipped, ahead of the datapath, a multiply per
+// sample
+void csc_coef_apply_gains(csc_coef_t *out, const csc_coef_t *in, const uint16_t gain[3])
+{
+	int k;
+
+	*out = *in;
+	for (k = 0; k < 3; k++) {
+		out->gain[k] = (in->gain[k] * (Xuint32)gain[k]) >> 8;
+	}
+	csc_coef_update_scaled(out);
+}
+
+// Converter for RGB samples bits deep: in's conversion of the samples
+// rounded down to 8 bits, the same as the linear tone LUT
+// (isp_tone_linear()). For stages that convert sensor-depth RGB with no
+// tone LUT in front.
+void csc_coef_scale_input(csc_coef_t *out, const csc_coef_t *in, int bits)
+{
+	*out = *in;
+	out->in_shift = bits - CSC_DATA_WIDTH;
+	csc_coef_update_scaled(out);
+}
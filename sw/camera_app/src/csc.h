@@ -0,0 +1,164 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * csc.h - Integer (fixed-point) RGB to YCbCr colour space conversion used
+ * by the software ISP.
+ *
+ *
+ * NOTES:
+ * The conversion is the rgb2ycrcb core's datapath, with its Q16
+ * coefficients:
+ *    Y  = A*(R-G) + B*(B-G) + G, rounded to an integer
+ *    Cr = C*(R-Y), Cb = D*(B-Y), rounded
+ * then the offsets and the clipping/clamping of each channel. For 8-bit
+ * RGB the software gives the core's Y, Cb and Cr exactly. Samples deeper
+ * than 8 bits, or with white balance gains, are first scaled (and
+ * rounded, and clipped at 255) to the 8 bits the datapath takes.
+ *
+ * 4:2:2 output works on pixel pairs: Y for both pixels, and one Cb/Cr pair
+ * from the sums of the two pixels' B (or R) and Y, rounded once (the
+ * conversion of their mean colour, a 2-tap filter ahead of the
+ * subsampling rather than a dropped sample). The two output words are
+ * packed for a single 32-bit store; the Zynq and the host bench are both
+ * little-endian, so the Cb word comes first.
+ *****************************************************************************/
+
+#ifndef __CSC_H__
+#define __CSC_H__
+
+#include <stdint.h>
+#include <xbasic_types.h>
+#include "rgb2ycrcb.h"
+#include "demosaic.h"
+
+#define CSC_FRAC_BITS 16
+#define CSC_GAIN_BITS 8
+
+// Colour standard and input range shared by the rgb2ycrcb core and the
+// software converter (see RGB_select_standard() in rgb2ycrcb.c)
+#define CSC_STD_SD_ITU_601           0
+#define CSC_STD_HD_ITU_709_1125_NTSC 1
+#define CSC_STD_HD_ITU_709_1250_PAL  2
+#define CSC_STD_YUV                  3
+
+#define CSC_RANGE_16_TO_240          0
+#define CSC_RANGE_16_TO_235          1
+#define CSC_RANGE_0_TO_255           2
+
+// What the rgb2ycrcb core is built with (Standard_Sel 3 = YUV,
+// Input_Range 2 = 0-255 in system.mhs)
+#define CSC_STANDARD    CSC_STD_YUV
+#define CSC_INPUT_RANGE CSC_RANGE_0_TO_255
+#define CSC_DATA_WIDTH  8
+#define CSC_IN_MAX      ((1 << CSC_DATA_WIDTH) - 1)
+
+// The hardware pipeline's rgb2ycrcb core runs the standard it was built
+// with. Set this to 1 to have fmc_imageon_enable_ipipe() program the core
+// with CSC_STANDARD/CSC_INPUT_RANGE, so that the hardware and software
+// pipelines keep giving the same colours when those are changed.
+#define CSC_PROGRAM_CORE 0
+
+#define CSC_Y  0
+#define CSC_CB 1
+#define CSC_CR 2
+
+struct struct_csc_coef_t {
+	int32_t a, b;         // Y = a(R-G) + b(B-G) + G, Q(CSC_FRAC_BITS)
+	int32_t c, d;         // Cr = c(R-Y), Cb = d(B-Y), Q(CSC_FRAC_BITS)
+	int32_t offset[3];    // [Y/Cb/Cr], output units
+	uint16_t min[3];      // clamping
+	uint16_t max[3];      // clipping
+	uint16_t gain[3];     // on R/G/B ahead of the datapath, Q(CSC_GAIN_BITS)
+	int in_shift;         // input bits above CSC_DATA_WIDTH
+	int scaled;           // gain or in_shift to apply
+}; typedef struct struct_csc_coef_t csc_coef_t;
+
+// Sample k (R/G/B) of a pixel taken to the CSC_DATA_WIDTH bits the
+// datapath takes
+static inline int csc_input(const csc_coef_t *coef, int k, int v)
+{
+	int shift = CSC_GAIN_BITS + coef->in_shift;
+
+	if (!coef->scaled)
+		return v;
+	v = (v * coef->gain[k] + (1 << (shift - 1))) >> shift;
+	return (v > CSC_IN_MAX) ? CSC_IN_MAX : v;
+}
+
+// Y before its offset, as the core rounds it for the chroma terms
+static inline int csc_luma(const csc_coef_t *coef, int R, int G, int B)
+{
+	return ((coef->a * (R - G) + coef->b * (B - G) + (1 << (CSC_FRAC_BITS - 1))) >> CSC_FRAC_BITS) + G;
+}
+
+// Offset, clip and clamp one output component
+static inline uint16_t csc_clamp(const csc_coef_t *coef, int c, int v)
+{
+	v += coef->offset[c];
+	if (v < coef->min[c]) v = coef->min[c];
+	if (v > coef->max[c]) v = coef->max[c];
+	return v;
+}
+
+// Chroma component of a pixel pair, from the sums of its two B (Cb) or R
+// (Cr) samples and of its two lumas: the core's chroma term on the pair's
+// mean, rounded once
+static inline uint16_t csc_chroma_pair(const csc_coef_t *coef, int c, int X2, int L2)
+{
+	int32_t k = (c == CSC_CB) ? coef->d : coef->c;
+
+	return csc_clamp(coef, c, (k * (X2 - L2) + (1 << CSC_FRAC_BITS)) >> (CSC_FRAC_BITS + 1));
+}
+
+// Single output component of one pixel
+static inline uint16_t csc_component(const csc_coef_t *coef, int c, uint16_t R, uint16_t G, uint16_t B)
+{
+	int r = csc_input(coef, 0, R);
+	int g = csc_input(coef, 1, G);
+	int b = csc_input(coef, 2, B);
+	int L = csc_luma(coef, r, g, b);
+
+	if (c == CSC_Y)
+		return csc_clamp(coef, CSC_Y, L);
+	return csc_chroma_pair(coef, c, 2 * ((c == CSC_CB) ? b : r), 2 * L);
+}
+
+// The pixel pair at x of a line: Y0, Y1, Cb, Cr
+static inline void csc_convert_pair(const csc_coef_t *coef, const rgb_line_t *line, int x, uint16_t ycc[4])
+{
+	int R0 = csc_input(coef, 0, line->R[x]),   R1 = csc_input(coef, 0, line->R[x+1]);
+	int G0 = csc_input(coef, 1, line->G[x]),   G1 = csc_input(coef, 1, line->G[x+1]);
+	int B0 = csc_input(coef, 2, line->B[x]),   B1 = csc_input(coef, 2, line->B[x+1]);
+	int L0 = csc_luma(coef, R0, G0, B0);
+	int L1 = csc_luma(coef, R1, G1, B1);
+
+	ycc[0] = csc_clamp(coef, CSC_Y, L0);
+	ycc[1] = csc_clamp(coef, CSC_Y, L1);
+	ycc[2] = csc_chroma_pair(coef, CSC_CB, B0 + B1, L0 + L1);
+	ycc[3] = csc_chroma_pair(coef, CSC_CR, R0 + R1, L0 + L1);
+}
+
+// A 4:2:2 pixel pair, Cb<<8 | Y0 then Cr<<8 | Y1, as one 32-bit word.
+// Stores go through csc_pair_t, which may alias the 16-bit frame words.
+typedef uint32_t __attribute__((may_alias)) csc_pair_t;
+
+static inline uint32_t csc_pack_pair(uint16_t Y0, uint16_t Y1, uint16_t Cb, uint16_t Cr)
+{
+	return (uint32_t)(Cr << 8 | Y1) << 16 | (Cb << 8 | Y0);
+}
+
+// Function prototypes (csc.c)
+void csc_coef_default(csc_coef_t *coef);
+void csc_coef_from_core(csc_coef_t *coef, const struct rgb_coef_outputs *core);
+int csc_coef_from_standard(csc_coef_t *coef, int standard_sel, int input_range);
+void csc_convert_line(const csc_coef_t *coef, const rgb_line_t *line, Xuint16 *out, int x_start, int x_end);
+void csc_coef_apply_gains(csc_coef_t *out, const csc_coef_t *in, const uint16_t gain[3]);
+void csc_coef_scale_input(csc_coef_t *out, const csc_coef_t *in, int bits);
+
+#endif // __CSC_H__
@@ -0,0 +1,121 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * demosaic.c - Bilinear demosaic of RGGB Bayer frames. Replaces the old
+ * per-pixel switch on a colour LUT with a quad based engine: every 2x2
+ * quad has the same layout
+ *
+ *      R G      (even line)
+ *      G B      (odd line)
+ *
+ * so the colour of each pixel is known from its position in the quad and
+ * no per-pixel decisions, modulos or bounds checks are needed.
+ *****************************************************************************/
+
+#include "demosaic.h"
+
+// Interpolate one RGGB quad whose top-left (red) pixel is at column x.
+// xl/xr are the columns to the left of the quad and the right of it; on
+// the frame edges the caller mirrors them back into the frame.
+static inline void demosaic_bilinear_quad(const Xuint16 *a, const Xuint16 *e, const Xuint16 *o, const Xuint16 *b,
+		int x, int xl, int xr, rgb_line_t *out_e, rgb_line_t *out_o)
+{
+	uint16_t e0 = BAYER_PIXEL(e[x]),  e1 = BAYER_PIXEL(e[x+1]), e2 = BAYER_PIXEL(e[xr]);
+	uint16_t o0 = BAYER_PIXEL(o[x]),  o1 = BAYER_PIXEL(o[x+1]), ol = BAYER_PIXEL(o[xl]);
+	uint16_t a0 = BAYER_PIXEL(a[x]),  a1 = BAYER_PIXEL(a[x+1]), al = BAYER_PIXEL(a[xl]);
+	uint16_t b0 = BAYER_PIXEL(b[x]),  b1 = BAYER_PIXEL(b[x+1]), b2 = BAYER_PIXEL(b[xr]);
+
+	// Red pixel
+	out_e->R[x]   = e0;
+	out_e->G[x]   = (a0 + o0) >> 1;
+	out_e->B[x]   = (al + a1 + ol + o1) >> 2;
+
+	// Green pixel on a red line
+	out_e->R[x+1] = (e0 + e2) >> 1;
+	out_e->G[x+1] = e1;
+	out_e->B[x+1] = (a1 + o1) >> 1;
+
+	// Green pixel on a blue line
+	out_o->R[x]   = (e0 + b0) >> 1;
+	out_o->G[x]   = o0;
+	out_o->B[x]   = (ol + o1) >> 1;
+
+	// Blue pixel
+	out_o->R[x+1] = (e0 + e2 + b0 + b2) >> 2;
+	out_o->G[x+1] = (e1 + b1) >> 1;
+	out_o->B[x+1] = o1;
+}
+
+// Demosaic the quads of one quad row (an even/odd line pair) whose red
+// pixel lies in [x_start, x_end). above/below are the lines just outside
+// the pair; width must be even and at least 4.
+VRES_INLINE void demosaic_bilinear_range(const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		rgb_line_t *out_even, rgb_line_t *out_odd, int x_start, int x_end, int width)
+{
+	int x = x_start;
+	int x_stop = (x_end < width - 2) ? x_end : width - 2;
+
+	// Left edge: the column left of the frame mirrors to column 1
+	if (x == 0) {
+		demosaic_bilinear_quad(above, even, odd, below, 0, 1, 2, out_even, out_odd);
+		x += 2;
+	}
+
+	// Interior fast path, no edge handling at all
+	for (; x < x_stop; x += 2) {
+		demosaic_bilinear_quad(above, even, odd, below, x, x - 1, x + 2, out_even, out_odd);
+	}
+
+	// Right edge: the column right of the frame mirrors to column width-2
+	if (x_end == width) {
+		demosaic_bilinear_quad(above, even, odd, below, width - 2, width - 3, width - 2, out_even, out_odd);
+	}
+}
+
+void demosaic_bilinear_quad_range(const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		rgb_line_t *out_even, rgb_line_t *out_odd, int x_start, int x_end, int width)
+{
+	demosaic_bilinear_range(above, even, odd, below, out_even, out_odd, x_start, x_end, width);
+}
+
+// Demosaic one full quad row
+void demosaic_bilinear_quad_row(const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		rgb_line_t *out_even, rgb_line_t *out_odd, int width)
+{
+	demosaic_bilinear_range(above, even, odd, below, out_even, out_odd, 0, width, width);
+}
+
+// The same for each video mode's width (video_resolution.h)
+#define DEMOSAIC_BILINEAR_VRES(id, width, ...) \
+void demosaic_bilinear_quad_row_##id(const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below, \
+		rgb_line_t *out_even, rgb_line_t *out_odd) \
+{ \
+	demosaic_bilinear_range(above, even, odd, below, out_even, out_odd, 0, width, width); \
+}
+VRES_MODE_LIST(DEMOSAIC_BILINEAR_VRES)
+
+// Find the four source lines needed for quad row y (y even). The first
+// and last quad rows mirror the missing neighbour line back into the frame.
+void demosaic_quad_row_lines(const Xuint16 *frame, int width, int height, int y,
+		const Xuint16 **above, const Xuint16 **even, const Xuint16 **odd, const Xuint16 **below)
+{
+	*even  = frame + y * width;
+	*odd   = *even + width;
+	*above = (y > 0)          ? *even - width : *odd;
+	*below = (y + 2 < height) ? *odd + width  : *even;
+}
+
+// Demosaic lines y and y+1 (y even) of a full Bayer frame
+void demosaic_bilinear_rows(const Xuint16 *frame, int width, int height, int y, rgb_line_t *out_even, rgb_line_t *out_odd)
+{
+	const Xuint16 *above, *even, *odd, *below;
+
+	demosaic_quad_row_lines(frame, width, height, y, &above, &even, &odd, &below);
+	demosaic_bilinear_quad_row(above, even, odd, below, out_even, out_odd, width);
+}
@@ -0,0 +1,112 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * demosaic.h - Software demosaic (CFA interpolation) for the RGGB Bayer
+ * frames written by the S2MM channel of the VDMA.
+ *
+ *
+ * NOTES:
+ * The engine works on 2x2 RGGB quads, i.e. two output lines at a time.
+ * Frame edges are handled by mirroring the missing neighbour line/column,
+ * which gives exactly the same result as averaging only over the
+ * neighbours that exist.
+ *
+ * Two kernels: bilinear, which reads one line above and below a quad row,
+ * and the gradient-corrected 5x5 kernel (demosaic_mhc.c), which reads two.
+ * The NEON version of the 5x5 kernel is only built when the compiler
+ * targets NEON. For previews, demosaic_bin.c turns each quad into one
+ * pixel of a half-size image instead.
+ *****************************************************************************/
+
+#ifndef __DEMOSAIC_H__
+#define __DEMOSAIC_H__
+
+#include <stdint.h>
+#include <xbasic_types.h>
+#include "video_resolution.h"
+
+// Widest line supported by the software ISP (VIDEO_RESOLUTION_1080P)
+#define DEMOSAIC_MAX_WIDTH 1920
+
+// Lines needed on each side of a quad row
+#define DEMOSAIC_BILINEAR_APRON 1
+#define DEMOSAIC_MHC_APRON      2
+
+// For the kernel bodies shared by the generic row kernels and the copies
+// built for each video mode's width (VRES_MODE_LIST); without
+// always_inline GCC keeps one out-of-line body and the width is a
+// variable again
+#define VRES_INLINE static inline __attribute__((always_inline))
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define DEMOSAIC_HAVE_NEON 1
+#else
+#define DEMOSAIC_HAVE_NEON 0
+#endif
+
+// Sensor bit depth. The sample sits in the low BAYER_BITS bits of each
+// 16-bit S2MM word. The receiver in system.mhs is built with
+// C_XSVI_DATA_WIDTH = 8; build with -DBAYER_BITS=10 for a receiver and
+// v_vid_in_axi4s rebuilt at 10 bits. The demosaic and CSC arithmetic is
+// sized for up to 10 bits (the 5x5 kernel works in 16-bit lanes).
+#ifndef BAYER_BITS
+#define BAYER_BITS 8
+#endif
+#if BAYER_BITS < 8 || BAYER_BITS > 10
+#error "BAYER_BITS must be 8, 9 or 10"
+#endif
+#define BAYER_MAX ((1 << BAYER_BITS) - 1)
+
+#define BAYER_PIXEL(p) ((p) & BAYER_MAX)
+
+// One demosaicked line, stored as three planes so that later stages
+// can walk a single colour channel with unit stride.
+struct struct_rgb_line_t {
+	uint16_t *R;
+	uint16_t *G;
+	uint16_t *B;
+}; typedef struct struct_rgb_line_t rgb_line_t;
+
+// Function prototypes (demosaic.c)
+void demosaic_quad_row_lines(const Xuint16 *frame, int width, int height, int y,
+		const Xuint16 **above, const Xuint16 **even, const Xuint16 **odd, const Xuint16 **below);
+void demosaic_bilinear_quad_range(const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		rgb_line_t *out_even, rgb_line_t *out_odd, int x_start, int x_end, int width);
+void demosaic_bilinear_quad_row(const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+		rgb_line_t *out_even, rgb_line_t *out_odd, int width);
+void demosaic_bilinear_rows(const Xuint16 *frame, int width, int height, int y, rgb_line_t *out_even, rgb_line_t *out_odd);
+#define DEMOSAIC_BILINEAR_VRES_PROTO(id, width, ...) \
+	void demosaic_bilinear_quad_row_##id(const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below, \
+			rgb_line_t *out_even, rgb_line_t *out_odd);
+VRES_MODE_LIST(DEMOSAIC_BILINEAR_VRES_PROTO)
+
+// Function prototypes (demosaic_mhc.c)
+void demosaic_mhc_quad_range_ref(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd,
+		int x_start, int x_end, int width);
+void demosaic_mhc_quad_row_ref(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd, int width);
+#if DEMOSAIC_HAVE_NEON
+void demosaic_mhc_quad_row_neon(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd, int width);
+#endif
+void demosaic_mhc_quad_row(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd, int width);
+#define DEMOSAIC_MHC_VRES_PROTO(id, width, ...) \
+	void demosaic_mhc_quad_row_##id(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd);
+VRES_MODE_LIST(DEMOSAIC_MHC_VRES_PROTO)
+
+// Function prototypes (demosaic_bin.c)
+void demosaic_bin2_quad_range_ref(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out, int x_start, int x_end);
+void demosaic_bin2_quad_row_ref(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out, int width);
+#if DEMOSAIC_HAVE_NEON
+void demosaic_bin2_quad_row_neon(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out, int width);
+#endif
+void demosaic_bin2_quad_row(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out, int width);
+#define DEMOSAIC_BIN2_VRES_PROTO(id, width, ...) \
+	void demosaic_bin2_quad_row_##id(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out);
+VRES_MODE_LIST(DEMOSAIC_BIN2_VRES_PROTO)
+
+#endif // __DEMOSAIC_H__
@@ -0,0 +1,96 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * demosaic_bin.c - 2x2 binning demosaic for the preview pipeline.
+ *
+ * Every RGGB quad becomes one RGB pixel of a half-width line: R and B as
+ * sampled, G the rounded mean of the two greens. Nothing is interpolated,
+ * so no lines outside the quad row are read and each output pixel costs
+ * four loads. The NEON kernel must produce exactly the same samples as
+ * the scalar one.
+ *****************************************************************************/
+
+#include "demosaic.h"
+
+#if DEMOSAIC_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+// Bin the quads whose red pixel lies in [x_start, x_end) into pixels
+// x_start/2 .. x_end/2-1 of out (x_start and x_end even)
+VRES_INLINE void bin2_quad_range(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out, int x_start, int x_end)
+{
+	int x;
+
+	for (x = x_start; x < x_end; x += 2) {
+		out->R[x >> 1] = BAYER_PIXEL(even[x]);
+		out->G[x >> 1] = (BAYER_PIXEL(even[x+1]) + BAYER_PIXEL(odd[x]) + 1) >> 1;
+		out->B[x >> 1] = BAYER_PIXEL(odd[x+1]);
+	}
+}
+
+void demosaic_bin2_quad_range_ref(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out, int x_start, int x_end)
+{
+	bin2_quad_range(even, odd, out, x_start, x_end);
+}
+
+void demosaic_bin2_quad_row_ref(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out, int width)
+{
+	bin2_quad_range(even, odd, out, 0, width);
+}
+
+#if DEMOSAIC_HAVE_NEON
+
+VRES_INLINE void bin2_quad_row_neon(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out, int width)
+{
+	uint16x8_t mask = vdupq_n_u16(BAYER_MAX);
+	uint16x8x2_t e, o;
+	int x;
+
+	// 8 quads per iteration; vld2 splits each line into its two colours
+	for (x = 0; x + 16 <= width; x += 16) {
+		e = vld2q_u16(even + x);
+		o = vld2q_u16(odd + x);
+		vst1q_u16(out->R + (x >> 1), vandq_u16(e.val[0], mask));
+		vst1q_u16(out->G + (x >> 1), vrhaddq_u16(vandq_u16(e.val[1], mask), vandq_u16(o.val[0], mask)));
+		vst1q_u16(out->B + (x >> 1), vandq_u16(o.val[1], mask));
+	}
+
+	bin2_quad_range(even, odd, out, x, width);
+}
+
+void demosaic_bin2_quad_row_neon(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out, int width)
+{
+	bin2_quad_row_neon(even, odd, out, width);
+}
+
+#endif // DEMOSAIC_HAVE_NEON
+
+// Fastest kernel available for this build
+VRES_INLINE void bin2_quad_row(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out, int width)
+{
+#if DEMOSAIC_HAVE_NEON
+	bin2_quad_row_neon(even, odd, out, width);
+#else
+	bin2_quad_range(even, odd, out, 0, width);
+#endif
+}
+
+void demosaic_bin2_quad_row(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out, int width)
+{
+	bin2_quad_row(even, odd, out, width);
+}
+
+// The same for each video mode's width (video_resolution.h)
+#define DEMOSAIC_BIN2_VRES(id, width, ...) \
+void demosaic_bin2_quad_row_##id(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out) \
+{ \
+	bin2_quad_row(even, odd, out, width); \
+}
+VRES_MODE_LIST(DEMOSAIC_BIN2_VRES)
@@ -0,0 +1,237 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * demosaic_mhc.c - Gradient-corrected 5x5 demosaic (Malvar, He and Cutler,
+ * "High-quality linear interpolation for demosaicing of Bayer-patterned
+ * color images", ICASSP 2004) for one quad row at a time.
+ *
+ * Each missing colour is the bilinear estimate plus a fraction of the
+ * Laplacian of the channel that was sampled at the pixel, which removes
+ * most of the colour fringing bilinear leaves on edges. With the kernels
+ * scaled by 16 every weight is an integer:
+ *
+ *    G at R/B          8C + 4(N+S+W+E) - 2(NN+SS+WW+EE)
+ *    R at B, B at R    12C + 4(NW+NE+SW+SE) - 3(NN+SS+WW+EE)
+ *    R/B at G, along   10C + 8(W+E) - 2(WW+EE) - 2(NW+NE+SW+SE) + (NN+SS)
+ *    the row of that colour (transposed for the column)
+ *
+ * and the result is (sum + 8) >> 4 clipped to 0..BAYER_MAX. The NEON kernel
+ * must produce exactly the same samples as the scalar one.
+ *****************************************************************************/
+
+#include "demosaic.h"
+
+#if DEMOSAIC_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+static inline uint16_t mhc_clip(int v)
+{
+	v = (v + 8) >> 4;
+	return (v < 0) ? 0 : (v > BAYER_MAX) ? BAYER_MAX : v;
+}
+
+// Interpolate pixel x of the centre row r[2] of a 5-line window. c[] holds
+// the columns x-2 .. x+2, mirrored at the frame edges. own is the plane of
+// the colour sampled on this row (R on even rows, B on odd rows), other
+// the plane of the colour sampled on the rows above and below.
+static inline void mhc_pixel(const Xuint16 *const *r, const int *c, int colour_site, int x,
+		uint16_t *own, uint16_t *G, uint16_t *other)
+{
+#define P(dy, dx) BAYER_PIXEL(r[2 + (dy)][c[2 + (dx)]])
+	int C = P(0, 0);
+	int h1 = P(0, -1) + P(0, 1);
+	int v1 = P(-1, 0) + P(1, 0);
+	int h2 = P(0, -2) + P(0, 2);
+	int v2 = P(-2, 0) + P(2, 0);
+	int diag = P(-1, -1) + P(-1, 1) + P(1, -1) + P(1, 1);
+#undef P
+
+	if (colour_site) {
+		own[x]   = C;
+		G[x]     = mhc_clip(8 * C + 4 * (h1 + v1) - 2 * (h2 + v2));
+		other[x] = mhc_clip(12 * C + 4 * diag - 3 * (h2 + v2));
+	} else {
+		// Green: its row neighbours are the row's colour, its column
+		// neighbours the other one
+		G[x]     = C;
+		own[x]   = mhc_clip(10 * C + 8 * h1 - 2 * h2 - 2 * diag + v2);
+		other[x] = mhc_clip(10 * C + 8 * v1 - 2 * v2 - 2 * diag + h2);
+	}
+}
+
+// Pixels [x_start, x_end) of the centre row of r[0..4]. phase is 0 on an
+// R/G row (colour at even columns) and 1 on a G/B row.
+VRES_INLINE void mhc_row_range(const Xuint16 *const *r, int phase, uint16_t *own, uint16_t *G, uint16_t *other,
+		int x_start, int x_end, int width)
+{
+	int c[5];
+	int x, i, col;
+
+	for (x = x_start; x < x_end; x++) {
+		for (i = 0; i < 5; i++) {
+			col = x - 2 + i;
+			c[i] = (col < 0) ? -col : (col >= width) ? 2 * width - 2 - col : col;
+		}
+		mhc_pixel(r, c, (x & 1) == phase, x, own, G, other);
+	}
+}
+
+// Demosaic pixels [x_start, x_end) of a quad row. lines[0..5] are frame
+// lines y-2 .. y+3 (see lbuf_window()); width must be even and at least 4.
+VRES_INLINE void mhc_quad_range(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd,
+		int x_start, int x_end, int width)
+{
+	mhc_row_range(&lines[0], 0, out_even->R, out_even->G, out_even->B, x_start, x_end, width);
+	mhc_row_range(&lines[1], 1, out_odd->B, out_odd->G, out_odd->R, x_start, x_end, width);
+}
+
+void demosaic_mhc_quad_range_ref(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd,
+		int x_start, int x_end, int width)
+{
+	mhc_quad_range(lines, out_even, out_odd, x_start, x_end, width);
+}
+
+void demosaic_mhc_quad_row_ref(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd, int width)
+{
+	mhc_quad_range(lines, out_even, out_odd, 0, width, width);
+}
+
+#if DEMOSAIC_HAVE_NEON
+
+// Columns x-2 .. x+17 of one line as six vectors of 8: col[d + 2] holds
+// columns x + 2i + d for d = -2 .. 3, sensor bits only
+static inline void mhc_load_neon(const Xuint16 *line, int x, int16x8_t col[6])
+{
+	uint16x8_t mask = vdupq_n_u16(BAYER_MAX);
+	uint16x8x2_t l = vld2q_u16(line + x - 2);
+	uint16x8x2_t m = vld2q_u16(line + x);
+	uint16x8x2_t h = vld2q_u16(line + x + 2);
+
+	col[0] = vreinterpretq_s16_u16(vandq_u16(l.val[0], mask));
+	col[1] = vreinterpretq_s16_u16(vandq_u16(l.val[1], mask));
+	col[2] = vreinterpretq_s16_u16(vandq_u16(m.val[0], mask));
+	col[3] = vreinterpretq_s16_u16(vandq_u16(m.val[1], mask));
+	col[4] = vreinterpretq_s16_u16(vandq_u16(h.val[0], mask));
+	col[5] = vreinterpretq_s16_u16(vandq_u16(h.val[1], mask));
+}
+
+// (sum + 8) >> 4, clipped to 0..BAYER_MAX
+static inline uint16x8_t mhc_clip_neon(int16x8_t sum)
+{
+#if BAYER_BITS == 8
+	return vmovl_u8(vqmovun_s16(vrshrq_n_s16(sum, 4)));
+#else
+	int16x8_t v = vmaxq_s16(vrshrq_n_s16(sum, 4), vdupq_n_s16(0));
+
+	return vminq_u16(vreinterpretq_u16_s16(v), vdupq_n_u16(BAYER_MAX));
+#endif
+}
+
+// The scalar mhc_pixel() for 8 pixels at columns x + 2i + p, p = 0 or 1.
+// All sums stay within +/-28 * BAYER_MAX, so 16-bit lanes are enough up
+// to 10 bits.
+static inline void mhc_pixels_neon(int16x8_t row[5][6], int p, int colour_site,
+		uint16x8_t *own, uint16x8_t *G, uint16x8_t *other)
+{
+#define P(dy, dx) row[2 + (dy)][2 + p + (dx)]
+	int16x8_t C = P(0, 0);
+	int16x8_t h1 = vaddq_s16(P(0, -1), P(0, 1));
+	int16x8_t v1 = vaddq_s16(P(-1, 0), P(1, 0));
+	int16x8_t h2 = vaddq_s16(P(0, -2), P(0, 2));
+	int16x8_t v2 = vaddq_s16(P(-2, 0), P(2, 0));
+	int16x8_t diag = vaddq_s16(vaddq_s16(P(-1, -1), P(-1, 1)), vaddq_s16(P(1, -1), P(1, 1)));
+#undef P
+	int16x8_t sum;
+
+	if (colour_site) {
+		*own = vreinterpretq_u16_s16(C);
+		sum = vshlq_n_s16(C, 3);
+		sum = vmlaq_n_s16(sum, vaddq_s16(h1, v1), 4);
+		sum = vmlaq_n_s16(sum, vaddq_s16(h2, v2), -2);
+		*G = mhc_clip_neon(sum);
+		sum = vmulq_n_s16(C, 12);
+		sum = vmlaq_n_s16(sum, diag, 4);
+		sum = vmlaq_n_s16(sum, vaddq_s16(h2, v2), -3);
+		*other = mhc_clip_neon(sum);
+	} else {
+		*G = vreinterpretq_u16_s16(C);
+		sum = vmulq_n_s16(C, 10);
+		sum = vmlaq_n_s16(sum, diag, -2);
+		*own = mhc_clip_neon(vaddq_s16(vmlaq_n_s16(vmlaq_n_s16(sum, h1, 8), h2, -2), v2));
+		*other = mhc_clip_neon(vaddq_s16(vmlaq_n_s16(vmlaq_n_s16(sum, v1, 8), v2, -2), h2));
+	}
+}
+
+// 16 pixels of the centre row of r[0..4] starting at column x (even)
+static inline void mhc_row_neon(const Xuint16 *const *r, int phase, uint16_t *own, uint16_t *G, uint16_t *other, int x)
+{
+	int16x8_t row[5][6];
+	uint16x8x2_t o, g, t;
+	int i;
+
+	for (i = 0; i < 5; i++) {
+		mhc_load_neon(r[i], x, row[i]);
+	}
+
+	mhc_pixels_neon(row, 0, phase == 0, &o.val[0], &g.val[0], &t.val[0]);
+	mhc_pixels_neon(row, 1, phase == 1, &o.val[1], &g.val[1], &t.val[1]);
+
+	vst2q_u16(own + x, o);
+	vst2q_u16(G + x, g);
+	vst2q_u16(other + x, t);
+}
+
+VRES_INLINE void mhc_quad_row_neon(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd, int width)
+{
+	int x;
+
+	// Left edge: columns -2 and -1 are mirrored
+	mhc_quad_range(lines, out_even, out_odd, 0, 2, width);
+
+	// 16 pixels of both lines per iteration while columns x-2 .. x+17 are
+	// all inside the line
+	for (x = 2; x + 18 <= width; x += 16) {
+		mhc_row_neon(&lines[0], 0, out_even->R, out_even->G, out_even->B, x);
+		mhc_row_neon(&lines[1], 1, out_odd->B, out_odd->G, out_odd->R, x);
+	}
+
+	// Remaining pixels and the right edge
+	mhc_quad_range(lines, out_even, out_odd, x, width, width);
+}
+
+void demosaic_mhc_quad_row_neon(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd, int width)
+{
+	mhc_quad_row_neon(lines, out_even, out_odd, width);
+}
+
+#endif // DEMOSAIC_HAVE_NEON
+
+// Fastest kernel available for this build
+VRES_INLINE void mhc_quad_row(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd, int width)
+{
+#if DEMOSAIC_HAVE_NEON
+	mhc_quad_row_neon(lines, out_even, out_odd, width);
+#else
+	mhc_quad_range(lines, out_even, out_odd, 0, width, width);
+#endif
+}
+
+void demosaic_mhc_quad_row(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd, int width)
+{
+	mhc_quad_row(lines, out_even, out_odd, width);
+}
+
+// The same for each video mode's width (video_resolution.h)
+#define DEMOSAIC_MHC_VRES(id, width, ...) \
+void demosaic_mhc_quad_row_##id(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd) \
+{ \
+	mhc_quad_row(lines, out_even, out_odd, width); \
+}
+VRES_MODE_LIST(DEMOSAIC_MHC_VRES)
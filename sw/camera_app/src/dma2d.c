@@ -0,0 +1,275 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * dma2d.c - Rectangle copies on the PS DMA controller (PL330).
+ *
+ * The program is assembled by hand. Encodings are from the PL330 TRM:
+ * DMAMOV, DMALP/DMALPEND (loop counters 0 and 1), DMALD/DMAST, DMAADDH,
+ * DMAWMB, DMASEV and DMAEND. Beats are 8 bytes when every address, width
+ * and stride allows it, 4 bytes otherwise.
+ *****************************************************************************/
+
+#include <string.h>
+#include "xil_printf.h"
+#include "xstatus.h"
+#include "dma2d.h"
+
+// DMAMOV destination registers and DMAADDH address registers
+#define DMA2D_SAR          0
+#define DMA2D_CCR          1
+#define DMA2D_DAR          2
+#define DMA2D_ADDH_SAR     0
+#define DMA2D_ADDH_DAR     1
+
+// Longest code for one chunk of lines, and for the end of the program
+#define DMA2D_CHUNK_BYTES  (2 + 6 + 2 + 1 + 1 + 2 + 6 + 1 + 1 + 3 + 3 + 2)
+#define DMA2D_END_BYTES    (1 + 2 + 1)
+
+static void (*const dma2d_done_isr[XDMAPS_CHANNELS_PER_DEV])(XDmaPs *) = {
+	XDmaPs_DoneISR_0, XDmaPs_DoneISR_1, XDmaPs_DoneISR_2, XDmaPs_DoneISR_3,
+	XDmaPs_DoneISR_4, XDmaPs_DoneISR_5, XDmaPs_DoneISR_6, XDmaPs_DoneISR_7
+};
+
+static int dma2d_mov(Xuint8 *p, int rd, Xuint32 imm)
+{
+	p[0] = 0xBC;
+	p[1] = rd;
+	p[2] = imm & 0xFF;
+	p[3] = (imm >> 8) & 0xFF;
+	p[4] = (imm >> 16) & 0xFF;
+	p[5] = (imm >> 24) & 0xFF;
+	return 6;
+}
+
+static int dma2d_lp(Xuint8 *p, int lc, int iter)
+{
+	p[0] = 0x20 | (lc << 1);
+	p[1] = iter - 1;
+	return 2;
+}
+
+// Jump back to the first instruction of the loop body
+static int dma2d_lpend(Xuint8 *p, const Xuint8 *body, int lc)
+{
+	p[0] = 0x38 | (lc << 2);
+	p[1] = p - body;
+	return 2;
+}
+
+static int dma2d_addh(Xuint8 *p, int ra, int imm)
+{
+	p[0] = 0x54 | (ra << 1);
+	p[1] = imm & 0xFF;
+	p[2] = (imm >> 8) & 0xFF;
+	return 3;
+}
+
+static int dma2d_ldst(Xuint8 *p)
+{
+	p[0] = 0x04;                    // DMALD
+	p[1] = 0x08;                    // DMAST
+	return 2;
+}
+
+// Channel control: incrementing source and destination, same burst on both
+static Xuint32 dma2d_ccr(int beat_bytes, int beats)
+{
+	Xuint32 size = (beat_bytes == 8) ? 3 : 2;
+
+	return ((beats - 1) << 18) | (size << 15) | (1 << 14) | ((beats - 1) << 4) | (size << 1) | 1;
+}
+
+int dma2d_init(dma2d_t *dma, u16 device_id, int channel)
+{
+	XDmaPs_Config *config;
+
+	memset(dma, 0, sizeof(*dma));
+	dma->channel = channel;
+
+	config = XDmaPs_LookupConfig(device_id);
+	if (config == NULL || channel < 0 || channel >= XDMAPS_CHANNELS_PER_DEV) {
+		xil_printf("DMA2D: no DMA controller %d channel %d\r\n", device_id, channel);
+		return XST_FAILURE;
+	}
+
+	return XDmaPs_CfgInitialize(&dma->dmac, config, config->BaseAddress);
+}
+
+// Start a new (empty) batch
+void dma2d_begin(dma2d_t *dma)
+{
+	dma->prog_len = 0;
+	dma->copies = 0;
+	dma->batch_bytes = 0;
+}
+
+// Add a copy of lines rows of bytes each to the batch. Addresses, widths
+// and strides must be multiples of 4. Returns XST_FAILURE (and leaves the
+// batch as it was) if the copy cannot be expressed or the program is full;
+// the caller then copies it some other way.
+int dma2d_add(dma2d_t *dma, const void *src, void *dst, int bytes, int lines, int src_stride, int dst_stride)
+{
+	Xuint8 *p = dma->prog + dma->prog_len;
+	Xuint32 s = (Xuint32)src;
+	Xuint32 d = (Xuint32)dst;
+	int beat, bursts, tail, chunk, chunks, n;
+	Xuint8 *body, *inner;
+
+	if (dma->busy || bytes <= 0 || lines <= 0 || ((s | d | bytes | src_stride | dst_stride) & 3))
+		return XST_FAILURE;
+	if (src_stride < bytes || dst_stride < bytes ||
+			src_stride - bytes > DMA2D_MAX_STRIDE || dst_stride - bytes > DMA2D_MAX_STRIDE)
+		return XST_FAILURE;
+
+	beat = ((s | d | bytes | src_stride | dst_stride) & 7) ? 4 : 8;
+	bursts = bytes / (beat * DMA2D_BURST_LEN);
+	tail = (bytes % (beat * DMA2D_BURST_LEN)) / beat;
+	if (bursts > DMA2D_MAX_LOOP)
+		return XST_FAILURE;
+
+	chunks = (lines + DMA2D_MAX_LOOP - 1) / DMA2D_MAX_LOOP;
+	if (dma->prog_len + 12 + chunks * DMA2D_CHUNK_BYTES + DMA2D_END_BYTES > DMA2D_PROG_BYTES)
+		return XST_FAILURE;
+
+	p += dma2d_mov(p, DMA2D_SAR, s);
+	p += dma2d_mov(p, DMA2D_DAR, d);
+	for (n = 0; n < lines; n += chunk) {
+		chunk = lines - n;
+		if (chunk > DMA2D_MAX_LOOP)
+			chunk = DMA2D_MAX_LOOP;
+
+		p += dma2d_lp(p, 0, chunk);
+		body = p;
+		if (bursts) {
+			p += dma2d_mov(p, DMA2D_CCR, dma2d_ccr(beat, DMA2D_BURST_LEN));
+			p += dma2d_lp(p, 1, bursts);
+			inner = p;
+			p += dma2d_ldst(p);
+			p += dma2d_lpend(p, inner, 1);
+		}
+		if (tail) {
+			p += dma2d_mov(p, DMA2D_CCR, dma2d_ccr(beat, tail));
+			p += dma2d_ldst(p);
+		}
+		if (src_stride != bytes)
+			p += dma2d_addh(p, DMA2D_ADDH_SAR, src_stride - bytes);
+		if (dst_stride != bytes)
+			p += dma2d_addh(p, DMA2D_ADDH_DAR, dst_stride - bytes);
+		p += dma2d_lpend(p, body, 0);
+	}
+
+	dma->prog_len = p - dma->prog;
+	dma->copies++;
+	dma->batch_bytes += bytes * lines;
+	return XST_SUCCESS;
+}
+
+// Close the program and start the batch. An empty batch is not started.
+int dma2d_start(dma2d_t *dma)
+{
+	Xuint8 *p = dma->prog + dma->prog_len;
+	int status;
+
+	if (dma->busy || dma->copies == 0)
+		return XST_SUCCESS;
+
+	*p++ = 0x13;                            // DMAWMB
+	*p++ = 0x34;                            // DMASEV
+	*p++ = dma->channel << 3;
+	*p++ = 0x00;                            // DMAEND
+	dma->prog_len = p - dma->prog;
+	amp_dcache_flush_range(dma->prog, dma->prog_len);
+
+	memset(&dma->cmd, 0, sizeof(dma->cmd));
+	dma->cmd.UserDmaProg = dma->prog;
+	dma->cmd.UserDmaProgLength = dma->prog_len;
+
+	status = XDmaPs_Start(&dma->dmac, dma->channel, &dma->cmd, 0);
+	if (status != XST_SUCCESS) {
+		dma->faults++;
+		return status;
+	}
+
+	dma->busy = 1;
+	dma->start_ticks = amp_time();
+	dma->batches++;
+	dma->bytes += dma->batch_bytes;
+	return XST_SUCCESS;
+}
+
+// Check on the running batch without waiting. Returns XST_DEVICE_BUSY
+// while it runs; otherwise the batch (if any) is over and its status is
+// returned. On a fault or a timeout the channel is killed and XST_FAILURE
+// returned; the destination is then undefined.
+int dma2d_poll(dma2d_t *dma)
+{
+	Xuint32 base = dma->dmac.Config.BaseAddress;
+	Xuint32 mask = 1 << dma->channel;
+	int status = XST_SUCCESS;
+
+	if (!dma->busy)
+		return XST_SUCCESS;
+
+	if (!(XDmaPs_ReadReg(base, XDMAPS_INTSTATUS_OFFSET) & mask)) {
+		if ((XDmaPs_ReadReg(base, XDmaPs_CSn_OFFSET(dma->channel)) & 0x0F) == DMA2D_CS_FAULTING) {
+			dma->faults++;
+			status = XST_FAILURE;
+		} else if (amp_time() - dma->start_ticks > DMA2D_TIMEOUT) {
+			dma->timeouts++;
+			status = XST_FAILURE;
+		} else {
+			return XST_DEVICE_BUSY;
+		}
+		XDmaPs_ResetChannel(&dma->dmac, dma->channel);
+	}
+
+	// Clears the event and releases the channel in the driver
+	dma2d_done_isr[dma->channel](&dma->dmac);
+	dma->busy = 0;
+	return status;
+}
+
+// Wait for the running batch (if any); see dma2d_poll()
+int dma2d_wait(dma2d_t *dma)
+{
+	u64 start = amp_time();
+	int status;
+
+	while ((status = dma2d_poll(dma)) == XST_DEVICE_BUSY)
+		;
+	dma->wait_ticks += amp_time() - start;
+	return status;
+}
+
+// One rectangle, start to finish
+int dma2d_copy(dma2d_t *dma, const void *src, void *dst, int bytes, int lines, int src_stride, int dst_stride)
+{
+	int status;
+
+	dma2d_begin(dma);
+	status = dma2d_add(dma, src, dst, bytes, lines, src_stride, dst_stride);
+	if (status == XST_SUCCESS)
+		status = dma2d_start(dma);
+	if (status == XST_SUCCESS)
+		status = dma2d_wait(dma);
+
+	return status;
+}
+
+void dma2d_report(dma2d_t *dma)
+{
+	Xuint32 us_per_tick_den = AMP_GTIMER_HZ / 1000000;
+
+	if (dma->batches == 0)
+		return;
+
+	xil_printf("DMA2D report: %d batches, %d KB/batch, %d us/batch waiting, %d faults, %d timeouts\r\n",
+			dma->batches, (Xuint32)(dma->bytes / dma->batches / 1024),
+			(Xuint32)(dma->wait_ticks / dma->batches / us_per_tick_den), dma->faults, dma->timeouts);
+}
@@ -0,0 +1,84 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * dma2d.h - Rectangle copies on the PS DMA controller (PL330).
+ *
+ *
+ * NOTES:
+ * The XDmaPs driver only builds 1D programs, so this module writes its
+ * own PL330 program: for each rectangle, an outer loop over the lines
+ * (256 at a time, the loop counter limit) around an inner loop of 16-beat
+ * bursts, a shorter burst for the rest of the line, and DMAADDH to step
+ * both addresses on to the next line. Several rectangles go into one
+ * program, which ends with DMASEV on the channel's event, so the whole
+ * batch runs without the CPU.
+ *
+ * The batch is started with dma2d_start() and waited for with
+ * dma2d_wait(), which polls the channel's interrupt status and then runs
+ * the driver's done handler, so no GIC interrupt is needed. dma2d_poll()
+ * makes the same check once, without blocking (see dma_queue.h).
+ *
+ * No cache maintenance is done on the rectangles: the source must have
+ * been written back and the destination must not be written by the CPU
+ * until the copy is done (frame stores the CPU only ever writes through
+ * lbuf_write_back() satisfy both).
+ *****************************************************************************/
+
+#ifndef __DMA2D_H__
+#define __DMA2D_H__
+
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include <xparameters.h>
+#include "xdmaps.h"
+#include "amp.h"
+
+// The secure PL330 (the standalone BSP runs in the secure state)
+#define DMA2D_DEVICE_ID    XPAR_XDMAPS_1_DEVICE_ID
+#define DMA2D_CHANNEL      0
+
+#define DMA2D_PROG_BYTES   4096
+#define DMA2D_BURST_LEN    16            // beats per burst
+#define DMA2D_MAX_LOOP     256           // PL330 loop counter limit
+#define DMA2D_MAX_STRIDE   65535         // DMAADDH takes a 16-bit step
+
+// Longest a batch may run (global timer ticks)
+#define DMA2D_TIMEOUT      (AMP_GTIMER_HZ / 10)
+
+// Channel status value of a faulting channel
+#define DMA2D_CS_FAULTING  0x0F
+
+struct struct_dma2d_t {
+	XDmaPs dmac;
+	XDmaPs_Cmd cmd;
+	int channel;
+	int busy;                       // a batch has been started
+	int prog_len;
+	int copies;                     // rectangles in the batch
+	Xuint32 batch_bytes;
+	Xuint32 batches;
+	Xuint32 timeouts;
+	Xuint32 faults;
+	u64 bytes;                      // copied since dma2d_init()
+	u64 start_ticks;                // the running batch was started
+	u64 wait_ticks;                 // CPU time spent in dma2d_wait()
+	Xuint8 prog[DMA2D_PROG_BYTES] __attribute__((aligned(32)));
+}; typedef struct struct_dma2d_t dma2d_t;
+
+// Function prototypes (dma2d.c)
+int dma2d_init(dma2d_t *dma, u16 device_id, int channel);
+void dma2d_begin(dma2d_t *dma);
+int dma2d_add(dma2d_t *dma, const void *src, void *dst, int bytes, int lines, int src_stride, int dst_stride);
+int dma2d_start(dma2d_t *dma);
+int dma2d_poll(dma2d_t *dma);
+int dma2d_wait(dma2d_t *dma);
+int dma2d_copy(dma2d_t *dma, const void *src, void *dst, int bytes, int lines, int src_stride, int dst_stride);
+void dma2d_report(dma2d_t *dma);
+
+#endif // __DMA2D_H__
@@ -0,0 +1,187 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * dma_queue.c - Queue of 2D copies fed to the PL330 in dma2d batches (see
+ * dma_queue.h).
+ *****************************************************************************/
+
+#include <string.h>
+#include "xil_printf.h"
+#include "xstatus.h"
+#include "dma_queue.h"
+
+#define dmaq_at(q, i) (&(q)->req[((q)->head + (i)) % DMAQ_DEPTH])
+
+void dmaq_init(dmaq_t *q, dma2d_t *dma)
+{
+	memset(q, 0, sizeof(*q));
+	q->dma = dma;
+}
+
+// What the PL330 would have done, on the CPU
+static void dmaq_cpu_copy(dmaq_t *q, const dmaq_req_t *r)
+{
+	const Xuint8 *src = r->src;
+	Xuint8 *dst = r->dst;
+	int l;
+
+	for (l = 0; l < r->lines; l++) {
+		amp_dcache_flush_range(src, r->bytes);
+		memcpy(dst, src, r->bytes);
+		amp_dcache_flush_range(dst, r->bytes);
+		src += r->src_stride;
+		dst += r->dst_stride;
+	}
+	q->cpu_copies++;
+}
+
+// Take the oldest copy off the queue, into done[] for its callback
+static void dmaq_retire(dmaq_t *q, dmaq_req_t *done, int *num_done)
+{
+	dmaq_req_t *r = dmaq_at(q, 0);
+
+	q->head = (q->head + 1) % DMAQ_DEPTH;
+	q->count--;
+	q->copies++;
+	q->bytes += (u64)r->bytes * r->lines;
+	q->latency_ticks += amp_time() - r->queued;
+	done[(*num_done)++] = *r;
+}
+
+// Put as many queued copies as fit into a batch and start it. Copies that
+// cannot go on the PL330 at all are done on the CPU on the way.
+static void dmaq_start(dmaq_t *q, dmaq_req_t *done, int *num_done)
+{
+	dmaq_req_t *r;
+
+	while (q->count > 0 && q->running == 0) {
+		if (q->dma) {
+			dma2d_begin(q->dma);
+			while (q->running < q->count) {
+				r = dmaq_at(q, q->running);
+				if (dma2d_add(q->dma, r->src, r->dst, r->bytes, r->lines, r->src_stride, r->dst_stride) != XST_SUCCESS)
+					break;
+				q->running++;
+			}
+			if (q->running > 0 && dma2d_start(q->dma) == XST_SUCCESS)
+				return;
+		}
+
+		// Nothing in the batch (or it would not start): the oldest copy
+		// goes on the CPU, then try again with the rest
+		q->running = 0;
+		dmaq_cpu_copy(q, dmaq_at(q, 0));
+		dmaq_retire(q, done, num_done);
+	}
+}
+
+// Retire the running batch if it is done, and start the next one. The
+// callbacks run last, with the queue in order, so they may queue copies
+// themselves. Returns the number of copies not done yet.
+static int dmaq_advance(dmaq_t *q)
+{
+	dmaq_req_t done[DMAQ_DEPTH];
+	int num_done = 0;
+	int status, i;
+
+	if (q->running > 0) {
+		status = dma2d_poll(q->dma);
+		if (status == XST_DEVICE_BUSY)
+			return q->count;
+
+		// A failed batch left its destinations undefined: redo them
+		if (status != XST_SUCCESS) {
+			for (i = 0; i < q->running; i++) {
+				dmaq_cpu_copy(q, dmaq_at(q, i));
+			}
+		}
+		for (i = q->running; i > 0; i--) {
+			dmaq_retire(q, done, &num_done);
+		}
+		q->running = 0;
+	}
+	dmaq_start(q, done, &num_done);
+
+	for (i = 0; i < num_done; i++) {
+		if (done[i].done)
+			done[i].done(done[i].ctx, XST_SUCCESS);
+	}
+	return q->count;
+}
+
+// Queue a copy of lines lines of bytes bytes; see dma_queue.h. Returns
+// XST_FAILURE, queueing nothing, if the queue stays full.
+int dmaq_copy(dmaq_t *q, const void *src, void *dst, int bytes, int lines, int src_stride, int dst_stride,
+		dmaq_done_t done, void *ctx)
+{
+	u64 t0 = amp_time();
+	dmaq_req_t *r;
+
+	if (q->count == DMAQ_DEPTH && dmaq_advance(q) == DMAQ_DEPTH) {
+		q->full++;
+		q->cpu_ticks += amp_time() - t0;
+		return XST_FAILURE;
+	}
+
+	r = dmaq_at(q, q->count);
+	r->src = src;
+	r->dst = dst;
+	r->bytes = bytes;
+	r->lines = lines;
+	r->src_stride = src_stride;
+	r->dst_stride = dst_stride;
+	r->done = done;
+	r->ctx = ctx;
+	r->queued = t0;
+	q->count++;
+
+	dmaq_advance(q);
+	q->cpu_ticks += amp_time() - t0;
+	return XST_SUCCESS;
+}
+
+// A whole frame of width x height words
+int dmaq_copy_frame(dmaq_t *q, const Xuint16 *src, Xuint16 *dst, int width, int height, dmaq_done_t done, void *ctx)
+{
+	int bytes = width * sizeof(Xuint16);
+
+	return dmaq_copy(q, src, dst, bytes, height, bytes, bytes, done, ctx);
+}
+
+int dmaq_poll(dmaq_t *q)
+{
+	u64 t0 = amp_time();
+	int left = dmaq_advance(q);
+
+	q->cpu_ticks += amp_time() - t0;
+	return left;
+}
+
+// Until every queued copy is done
+void dmaq_wait(dmaq_t *q)
+{
+	while (dmaq_poll(q) > 0)
+		;
+}
+
+void dmaq_report(dmaq_t *q)
+{
+	Xuint32 us_per_tick_den = AMP_GTIMER_HZ / 1000000;
+
+	if (q->copies == 0 && q->full == 0)
+		return;
+
+	xil_printf("DMA queue: %d copies (%d on the CPU), %d refused, %d KB/copy\r\n",
+			q->copies, q->cpu_copies, q->full, q->copies ? (Xuint32)(q->bytes / q->copies / 1024) : 0);
+	if (q->copies) {
+		xil_printf("  %d us/copy queued to done, %d us/copy of CPU time\r\n",
+				(Xuint32)(q->latency_ticks / q->copies / us_per_tick_den),
+				(Xuint32)(q->cpu_ticks / q->copies / us_per_tick_den));
+	}
+}
@@ -0,0 +1,81 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * dma_queue.h - Asynchronous frame and rectangle copies on the PL330.
+ *
+ *
+ * NOTES:
+ * dmaq_copy() queues a 2D copy (lines of bytes at a source and a
+ * destination stride) and returns at once. Queued copies go to the
+ * PL330 as dma2d batches: as many as fit in one channel program, and the
+ * next batch starts as soon as the previous one is done. A copy's
+ * callback runs once its bytes are in the destination.
+ *
+ * Nothing runs in an interrupt: the queue moves on when dmaq_poll() is
+ * called (from a main loop, say), and dmaq_copy() and dmaq_wait() poll
+ * too. Callbacks run from inside those calls, in the caller's context.
+ *
+ * A copy dma2d cannot express (addresses, widths or strides not a
+ * multiple of 4) is done on the CPU instead, and so are the copies of a
+ * batch that faults or times out; the callback's status is that of the
+ * copy, not of the PL330.
+ *
+ * The cache rules of dma2d.h apply: the source must be in DDR and the
+ * destination must not be written by the CPU until the callback has run.
+ * The CPU fallback cleans the source and writes the destination back, so
+ * the result is the same either way.
+ *****************************************************************************/
+
+#ifndef __DMA_QUEUE_H__
+#define __DMA_QUEUE_H__
+
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "dma2d.h"
+
+#define DMAQ_DEPTH 16
+
+typedef void (*dmaq_done_t)(void *ctx, int status);
+
+struct struct_dmaq_req_t {
+	const void *src;
+	void *dst;
+	int bytes;                      // per line
+	int lines;
+	int src_stride;                 // bytes
+	int dst_stride;
+	dmaq_done_t done;               // or NULL
+	void *ctx;
+	u64 queued;                     // global timer
+}; typedef struct struct_dmaq_req_t dmaq_req_t;
+
+struct struct_dmaq_t {
+	dma2d_t *dma;                   // NULL: every copy on the CPU
+	dmaq_req_t req[DMAQ_DEPTH];
+	int head;                       // oldest copy
+	int count;                      // copies not done yet
+	int running;                    // of which in the running batch
+	Xuint32 copies;
+	Xuint32 cpu_copies;
+	Xuint32 full;                   // copies refused, queue full
+	u64 bytes;
+	u64 latency_ticks;              // queued to done, summed
+	u64 cpu_ticks;                  // spent in dmaq_* calls
+}; typedef struct struct_dmaq_t dmaq_t;
+
+// Function prototypes (dma_queue.c)
+void dmaq_init(dmaq_t *q, dma2d_t *dma);
+int dmaq_copy(dmaq_t *q, const void *src, void *dst, int bytes, int lines, int src_stride, int dst_stride,
+		dmaq_done_t done, void *ctx);
+int dmaq_copy_frame(dmaq_t *q, const Xuint16 *src, Xuint16 *dst, int width, int height, dmaq_done_t done, void *ctx);
+int dmaq_poll(dmaq_t *q);
+void dmaq_wait(dmaq_t *q);
+void dmaq_report(dmaq_t *q);
+
+#endif // __DMA_QUEUE_H__
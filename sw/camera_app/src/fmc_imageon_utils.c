@@ -280,12 +280,26 @@ int fmc_imageon_enable_vita( camera_config_t *config ) {
 }
 
 int fmc_imageon_enable_ipipe( camera_config_t *config ) {
+#if CSC_PROGRAM_CORE
+   struct rgb_coef_inputs rgb_coef_in;
+   struct rgb_coef_outputs rgb_coef_out;
+#endif
 
    xil_printf("Image Processing Pipeline (iPIPE) Initialization ...\n\r" );
 
    RGB_Reset(config->uBaseAddr_RGBYCC );
    RGB_ClearReset( config->uBaseAddr_RGBYCC );
    RGB_Enable( config->uBaseAddr_RGBYCC );
+#if CSC_PROGRAM_CORE
+   // Replace the standard the core was built with by the software
+   // converter's (csc.h)
+   RGB_select_standard( CSC_STANDARD, CSC_INPUT_RANGE, CSC_DATA_WIDTH, &rgb_coef_in );
+   RGB_coefficient_translation( &rgb_coef_in, &rgb_coef_out, CSC_DATA_WIDTH );
+   RGB_RegUpdateDisable( config->uBaseAddr_RGBYCC );
+   RGB_set_coefficients( config->uBaseAddr_RGBYCC, &rgb_coef_out );
+   RGB_RegUpdateEnable( config->uBaseAddr_RGBYCC );
+   xil_printf("\tRGB2YCrCb reprogrammed: standard %d, input range %d (CSC_PROGRAM_CORE)\r\n", CSC_STANDARD, CSC_INPUT_RANGE);
+#endif
    xil_printf("\tRGB2YCrCb done\r\n");
 
    CFA_Reset( config->uBaseAddr_CFA );
@@ -0,0 +1,166 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * frame_sync.c - S2MM frame-done interrupt handling and frame accounting
+ * for the software processing loop.
+ *****************************************************************************/
+
+#include "xil_exception.h"
+#include "xil_printf.h"
+#include "xstatus.h"
+#include "amp.h"
+#include "frame_sync.h"
+
+// Set up the GIC and hook it into the IRQ exception. Interrupts stay off
+// at the sources until a driver enables them.
+int intc_init(XScuGic *pIntc, u16 uDeviceId)
+{
+	XScuGic_Config *Config;
+	int Status;
+
+	Config = XScuGic_LookupConfig(uDeviceId);
+	if (!Config) {
+		xil_printf("No interrupt controller found for ID %d\r\n", uDeviceId);
+		return XST_FAILURE;
+	}
+
+	Status = XScuGic_CfgInitialize(pIntc, Config, Config->CpuBaseAddress);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Interrupt controller initialization failed %d\r\n", Status);
+		return Status;
+	}
+
+	Xil_ExceptionInit();
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT, (Xil_ExceptionHandler)XScuGic_InterruptHandler, pIntc);
+	Xil_ExceptionEnable();
+
+	return XST_SUCCESS;
+}
+
+// A frame has been written to memory
+static void fsync_s2mm_done(void *CallBackRef, u32 InterruptTypes)
+{
+	frame_sync_t *fs = (frame_sync_t *)CallBackRef;
+
+	if (InterruptTypes & XAXIVDMA_IXR_FRMCNT_MASK)
+		fs->produced++;
+}
+
+// The driver also calls this when the interrupt fired with nothing
+// pending, with ErrorMask 0; only a set error interrupt is an S2MM error
+static void fsync_s2mm_error(void *CallBackRef, u32 ErrorMask)
+{
+	frame_sync_t *fs = (frame_sync_t *)CallBackRef;
+
+	if (ErrorMask & XAXIVDMA_IXR_ERROR_MASK) {
+		fs->errors++;
+		fs->error_bits |= XAxiVdma_GetDmaChannelErrors(fs->vdma, XAXIVDMA_WRITE);
+	} else {
+		fs->spurious++;
+	}
+}
+
+int fsync_init(frame_sync_t *fs, XScuGic *pIntc, XAxiVdma *pAxiVdma)
+{
+	XAxiVdma_FrameCounter FrameCfg;
+	int Status;
+
+	fs->intc = pIntc;
+	fs->vdma = pAxiVdma;
+	fs->produced = 0;
+	fs->errors = 0;
+	fs->error_bits = 0;
+	fs->spurious = 0;
+	fs->taken = 0;
+	fs->processed = 0;
+	fs->dropped = 0;
+
+	// Interrupt after every S2MM frame
+	XAxiVdma_GetFrameCounter(pAxiVdma, &FrameCfg);
+	FrameCfg.WriteFrameCount = 1;
+	FrameCfg.WriteDelayTimerCount = 0;
+	if (FrameCfg.ReadFrameCount == 0)
+		FrameCfg.ReadFrameCount = 1;
+	Status = XAxiVdma_SetFrameCounter(pAxiVdma, &FrameCfg);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Setting the S2MM frame counter failed %d\r\n", Status);
+		return Status;
+	}
+
+	XAxiVdma_SetCallBack(pAxiVdma, XAXIVDMA_HANDLER_GENERAL, fsync_s2mm_done, fs, XAXIVDMA_WRITE);
+	XAxiVdma_SetCallBack(pAxiVdma, XAXIVDMA_HANDLER_ERROR, fsync_s2mm_error, fs, XAXIVDMA_WRITE);
+
+	Status = XScuGic_Connect(pIntc, FSYNC_S2MM_INTR_ID, (Xil_InterruptHandler)XAxiVdma_WriteIntrHandler, pAxiVdma);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Connecting the S2MM interrupt failed %d\r\n", Status);
+		return Status;
+	}
+	XScuGic_Enable(pIntc, FSYNC_S2MM_INTR_ID);
+
+	return XST_SUCCESS;
+}
+
+// Reset the counters and start taking frame-done interrupts
+void fsync_start(frame_sync_t *fs)
+{
+	XAxiVdma_IntrDisable(fs->vdma, XAXIVDMA_IXR_ALL_MASK, XAXIVDMA_WRITE);
+	fs->produced = 0;
+	fs->errors = 0;
+	fs->error_bits = 0;
+	fs->spurious = 0;
+	fs->taken = 0;
+	fs->processed = 0;
+	fs->dropped = 0;
+	fs->start = amp_time();
+	XAxiVdma_IntrClear(fs->vdma, XAXIVDMA_IXR_ALL_MASK, XAXIVDMA_WRITE);
+	XAxiVdma_IntrEnable(fs->vdma, XAXIVDMA_IXR_FRMCNT_MASK | XAXIVDMA_IXR_ERROR_MASK, XAXIVDMA_WRITE);
+}
+
+void fsync_stop(frame_sync_t *fs)
+{
+	XAxiVdma_IntrDisable(fs->vdma, XAXIVDMA_IXR_ALL_MASK, XAXIVDMA_WRITE);
+}
+
+// Wait for a frame that has not been processed yet. Frames that completed
+// since the last call, other than the newest, are counted as dropped.
+// Returns XST_FAILURE if no frame arrives within FSYNC_TIMEOUT.
+int fsync_wait(frame_sync_t *fs)
+{
+	u64 start = amp_time();
+	Xuint32 produced;
+
+	while ((produced = fs->produced) == fs->taken) {
+		if (amp_time() - start > FSYNC_TIMEOUT)
+			return XST_FAILURE;
+	}
+
+	fs->dropped += produced - fs->taken - 1;
+	fs->taken = produced;
+
+	return XST_SUCCESS;
+}
+
+void fsync_done(frame_sync_t *fs)
+{
+	fs->processed++;
+}
+
+void fsync_report(frame_sync_t *fs)
+{
+	u64 elapsed = amp_time() - fs->start;
+	Xuint32 ms = (Xuint32)(elapsed / (AMP_GTIMER_HZ / 1000));
+
+	xil_printf("Frames: %d produced, %d processed, %d dropped, %d errors in %d ms\r\n",
+			fs->produced, fs->processed, fs->dropped, fs->errors, ms);
+	if (fs->errors || fs->spurious)
+		xil_printf("  S2MM error bits 0x%03x, %d interrupts with nothing pending\r\n", fs->error_bits, fs->spurious);
+	if (ms)
+		xil_printf("Throughput: %d.%02d processed frames/s\r\n",
+				fs->processed * 1000 / ms, (fs->processed * 100000 / ms) % 100);
+}
@@ -0,0 +1,65 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * frame_sync.h - Paces the software processing loop on the S2MM channel's
+ * frame-done interrupt.
+ *
+ *
+ * NOTES:
+ * The S2MM frame counter is set to interrupt after every frame. The
+ * interrupt handler only counts; the processing loop picks up the newest
+ * frame each time round and counts the ones it never saw as dropped, so
+ * no frame is processed twice.
+ *
+ * The VDMA's s2mm_introut has to be wired to IRQ_F2P[0] in system.mhs.
+ *****************************************************************************/
+
+#ifndef __FRAME_SYNC_H__
+#define __FRAME_SYNC_H__
+
+#include <xparameters.h>
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "xscugic.h"
+#include "xaxivdma.h"
+#include "amp.h"
+
+// IRQ_F2P[0] is SPI 61
+#ifdef XPAR_FABRIC_AXI_VDMA_0_S2MM_INTROUT_INTR
+#define FSYNC_S2MM_INTR_ID XPAR_FABRIC_AXI_VDMA_0_S2MM_INTROUT_INTR
+#else
+#define FSYNC_S2MM_INTR_ID 61
+#endif
+
+// Give up waiting for a frame after this long (global timer ticks)
+#define FSYNC_TIMEOUT (AMP_GTIMER_HZ / 4)
+
+struct struct_frame_sync_t {
+	XScuGic *intc;
+	XAxiVdma *vdma;
+	volatile Xuint32 produced;    // S2MM frame-done interrupts
+	volatile Xuint32 errors;      // S2MM error interrupts
+	volatile Xuint32 error_bits;  // XAXIVDMA_SR_ERR_* seen in them
+	volatile Xuint32 spurious;    // interrupts with nothing pending
+	Xuint32 taken;                // value of produced at the last pick-up
+	Xuint32 processed;
+	Xuint32 dropped;
+	u64 start;                    // global timer at fsync_start()
+}; typedef struct struct_frame_sync_t frame_sync_t;
+
+// Function prototypes (frame_sync.c)
+int intc_init(XScuGic *pIntc, u16 uDeviceId);
+int fsync_init(frame_sync_t *fs, XScuGic *pIntc, XAxiVdma *pAxiVdma);
+void fsync_start(frame_sync_t *fs);
+void fsync_stop(frame_sync_t *fs);
+int fsync_wait(frame_sync_t *fs);
+void fsync_done(frame_sync_t *fs);
+void fsync_report(frame_sync_t *fs);
+
+#endif // __FRAME_SYNC_H__
@@ -0,0 +1,279 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * input.c - Timer-debounced GPIO buttons and switches and their event
+ * queue (see input.h).
+ *****************************************************************************/
+
+#include <string.h>
+#include "xil_exception.h"
+#include "xil_printf.h"
+#include "xpseudo_asm.h"
+#include "xstatus.h"
+#include "input.h"
+
+#define input_wfi() __asm__ __volatile__ ("wfi" : : : "memory")
+
+#define INPUT_TICK_GTIMER (AMP_GTIMER_HZ / INPUT_TICK_HZ)
+
+// Raw levels, laid out as the debounced state
+static Xuint32 input_read(input_t *in)
+{
+	Xuint32 btns = XGpio_DiscreteRead(&in->btns, 1) & ((1 << INPUT_NUM_BTNS) - 1);
+	Xuint32 sws = XGpio_DiscreteRead(&in->sws, 1) & ((1 << INPUT_NUM_SWS) - 1);
+
+	return btns | (sws << INPUT_SW_SHIFT);
+}
+
+// Only ever called with the queue's reader unable to run (from the
+// interrupt, or from input_get() itself)
+static void input_push(input_t *in, int type, int bit)
+{
+	input_event_t *ev;
+
+	if (in->tail - in->head == INPUT_QUEUE_LEN) {
+		in->dropped++;
+		return;
+	}
+
+	ev = &in->queue[in->tail % INPUT_QUEUE_LEN];
+	ev->type = type;
+	ev->source = bit < INPUT_SW_SHIFT ? INPUT_BTN : INPUT_SW;
+	ev->index = bit < INPUT_SW_SHIFT ? bit : bit - INPUT_SW_SHIFT;
+	ev->tick = in->ticks;
+	dmb();
+	in->tail++;
+	in->events++;
+}
+
+// One sample: debounce every input and time the held buttons. Returns
+// nonzero while anything is still changing or a long press may come.
+static int input_tick(input_t *in)
+{
+	Xuint32 state = in->state;
+	Xuint32 diff = input_read(in) ^ state;
+	int busy = 0;
+	int bit;
+
+	in->ticks++;
+
+	for (bit = 0; bit < INPUT_NUM_BITS; bit++) {
+		if (!(diff & (1 << bit))) {
+			in->count[bit] = 0;
+			continue;
+		}
+		busy = 1;
+		if (++in->count[bit] < INPUT_DEBOUNCE_TICKS)
+			continue;
+
+		in->count[bit] = 0;
+		state ^= 1 << bit;
+		input_push(in, (state & (1 << bit)) ? INPUT_PRESS : INPUT_RELEASE, bit);
+		if (bit < INPUT_NUM_BTNS)
+			in->held[bit] = 0;
+	}
+
+	for (bit = 0; bit < INPUT_NUM_BTNS; bit++) {
+		if (!(state & (1 << bit)) || in->held[bit] >= INPUT_LONG_PRESS_TICKS)
+			continue;
+		busy = 1;
+		if (++in->held[bit] == INPUT_LONG_PRESS_TICKS)
+			input_push(in, INPUT_LONG_PRESS, bit);
+	}
+
+	in->state = state;
+	return busy;
+}
+
+#if INPUT_HAVE_GPIO_INTR
+static void input_gpio_arm(input_t *in)
+{
+	XGpio_InterruptClear(&in->btns, XGPIO_IR_CH1_MASK);
+	XGpio_InterruptClear(&in->sws, XGPIO_IR_CH1_MASK);
+	XGpio_InterruptEnable(&in->btns, XGPIO_IR_CH1_MASK);
+	XGpio_InterruptEnable(&in->sws, XGPIO_IR_CH1_MASK);
+}
+
+// A level changed: sample until it settles
+static void input_gpio_handler(void *CallBackRef)
+{
+	input_t *in = (input_t *)CallBackRef;
+
+	XGpio_InterruptDisable(&in->btns, XGPIO_IR_CH1_MASK);
+	XGpio_InterruptDisable(&in->sws, XGPIO_IR_CH1_MASK);
+	XGpio_InterruptClear(&in->btns, XGPIO_IR_CH1_MASK);
+	XGpio_InterruptClear(&in->sws, XGPIO_IR_CH1_MASK);
+	in->wakeups++;
+
+	XScuTimer_RestartTimer(&in->timer);
+	XScuTimer_Start(&in->timer);
+}
+#endif
+
+static void input_timer_handler(void *CallBackRef)
+{
+	input_t *in = (input_t *)CallBackRef;
+	int busy;
+
+	XScuTimer_ClearInterruptStatus(&in->timer);
+	busy = input_tick(in);
+
+#if INPUT_HAVE_GPIO_INTR
+	// Settled: wait for the next change. One that came in before the
+	// GPIO interrupts were back on keeps the timer going.
+	if (in->gpio_intr && !busy) {
+		XScuTimer_Stop(&in->timer);
+		input_gpio_arm(in);
+		if (input_read(in) != in->state)
+			XScuTimer_Start(&in->timer);
+	}
+#else
+	(void)busy;
+#endif
+}
+
+static int input_intr_init(input_t *in)
+{
+	XScuTimer_Config *Config;
+	int Status;
+
+	Config = XScuTimer_LookupConfig(INPUT_TIMER_DEVICE_ID);
+	if (!Config) {
+		xil_printf("No private timer found for ID %d\r\n", INPUT_TIMER_DEVICE_ID);
+		return XST_FAILURE;
+	}
+	Status = XScuTimer_CfgInitialize(&in->timer, Config, Config->BaseAddr);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Private timer initialization failed %d\r\n", Status);
+		return Status;
+	}
+
+	XScuTimer_LoadTimer(&in->timer, INPUT_TICK_GTIMER - 1);
+	XScuTimer_EnableAutoReload(&in->timer);
+
+	Status = XScuGic_Connect(in->intc, INPUT_TIMER_INTR_ID, (Xil_InterruptHandler)input_timer_handler, in);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Connecting the timer interrupt failed %d\r\n", Status);
+		return Status;
+	}
+	XScuTimer_EnableInterrupt(&in->timer);
+	XScuGic_Enable(in->intc, INPUT_TIMER_INTR_ID);
+
+#if INPUT_HAVE_GPIO_INTR
+	if (XScuGic_Connect(in->intc, INPUT_BTNS_INTR_ID, (Xil_InterruptHandler)input_gpio_handler, in) == XST_SUCCESS &&
+			XScuGic_Connect(in->intc, INPUT_SWS_INTR_ID, (Xil_InterruptHandler)input_gpio_handler, in) == XST_SUCCESS) {
+		in->gpio_intr = 1;
+		XGpio_InterruptGlobalEnable(&in->btns);
+		XGpio_InterruptGlobalEnable(&in->sws);
+		input_gpio_arm(in);
+		XScuGic_Enable(in->intc, INPUT_BTNS_INTR_ID);
+		XScuGic_Enable(in->intc, INPUT_SWS_INTR_ID);
+		return XST_SUCCESS;
+	}
+	xil_printf("Connecting the GPIO interrupts failed, sampling all the time\r\n");
+#endif
+
+	XScuTimer_Start(&in->timer);
+	return XST_SUCCESS;
+}
+
+// The GIC must have been set up (intc_init()); with pIntc NULL, or if the
+// timer cannot be set up, the inputs are sampled from input_get()
+int input_init(input_t *in, XScuGic *pIntc)
+{
+	int Status;
+
+	memset(in, 0, sizeof(*in));
+
+	Status = XGpio_Initialize(&in->btns, INPUT_BTNS_DEVICE_ID);
+	if (Status == XST_SUCCESS)
+		Status = XGpio_Initialize(&in->sws, INPUT_SWS_DEVICE_ID);
+	if (Status != XST_SUCCESS) {
+		xil_printf("GPIO initialization failed %d\r\n", Status);
+		return Status;
+	}
+	XGpio_SetDataDirection(&in->btns, 1, 0xFFFFFFFF);
+	XGpio_SetDataDirection(&in->sws, 1, 0xFFFFFFFF);
+
+	// Whatever is held now does not count as pressed
+	in->state = input_read(in);
+	in->next_sample = amp_time();
+
+	in->intc = pIntc;
+	if (pIntc && input_intr_init(in) != XST_SUCCESS)
+		in->intc = NULL;
+
+	return XST_SUCCESS;
+}
+
+// Without interrupts, the samples that are due
+static void input_poll(input_t *in)
+{
+	u64 now = amp_time();
+
+	// Long away: carry on from now rather than catch up
+	if (now - in->next_sample > INPUT_DEBOUNCE_TICKS * INPUT_TICK_GTIMER)
+		in->next_sample = now;
+
+	while ((s64)(now - in->next_sample) >= 0) {
+		input_tick(in);
+		in->next_sample += INPUT_TICK_GTIMER;
+	}
+}
+
+// The oldest event, if any. Returns 0 if there is none.
+int input_get(input_t *in, input_event_t *ev)
+{
+	if (!in->intc)
+		input_poll(in);
+
+	if (in->head == in->tail)
+		return 0;
+
+	dmb();
+	*ev = in->queue[in->head % INPUT_QUEUE_LEN];
+	in->head++;
+	return 1;
+}
+
+// Sleep until there is an event. IRQs are masked between the check and
+// the wfi, so one arriving in between still wakes it.
+void input_wait(input_t *in, input_event_t *ev)
+{
+	for (;;) {
+		if (in->intc)
+			Xil_ExceptionDisable();
+		if (input_get(in, ev))
+			break;
+		if (in->intc) {
+			input_wfi();
+			Xil_ExceptionEnable();
+		}
+	}
+	if (in->intc)
+		Xil_ExceptionEnable();
+}
+
+// Debounced levels
+int input_btn(input_t *in, int index)
+{
+	return (in->state >> index) & 1;
+}
+
+int input_sw(input_t *in, int index)
+{
+	return (in->state >> (INPUT_SW_SHIFT + index)) & 1;
+}
+
+void input_report(input_t *in)
+{
+	xil_printf("Input: %d events, %d dropped, %d samples, %d GPIO wakeups (%s)\r\n",
+			in->events, in->dropped, in->ticks, in->wakeups,
+			!in->intc ? "polled" : in->gpio_intr ? "GPIO and timer interrupts" : "timer interrupt");
+}
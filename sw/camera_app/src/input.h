@@ -0,0 +1,125 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * input.h - Debounced push buttons and switches, delivered as a queue of
+ * press, release and long-press events.
+ *
+ *
+ * NOTES:
+ * The SCU private timer interrupts every 1/INPUT_TICK_HZ s and samples
+ * both AXI GPIOs. An input changes state once its level has differed from
+ * the debounced one for INPUT_DEBOUNCE_MS in a row; a button still held
+ * INPUT_LONG_PRESS_MS after its press also gives a long press. Events go
+ * into a ring the interrupt handler fills and input_get() empties; when it
+ * is full new events are dropped (and counted).
+ *
+ * If the GPIOs have their interrupt (XPAR_*_INTERRUPT_PRESENT, with
+ * ip2intc_irpt wired to IRQ_F2P[1] and [2] in system.mhs), a change on
+ * either wakes the timer and the timer stops again once every input has
+ * settled and no long press is pending. Otherwise the timer runs all the
+ * time, which costs a few hundred cycles a millisecond.
+ *
+ * input_wait() sleeps the CPU (wfi) until there is an event. Without an
+ * interrupt controller nothing runs in an interrupt: the inputs are
+ * sampled from input_get() instead, timed by the global timer.
+ *
+ * Buttons are bits 0-4 of the debounced state and switches bits 8-15.
+ *****************************************************************************/
+
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include <xparameters.h>
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "xscugic.h"
+#include "xscutimer.h"
+#include "xgpio.h"
+#include "amp.h"
+
+#define INPUT_BTNS_DEVICE_ID  XPAR_BTNS_5BITS_DEVICE_ID
+#define INPUT_SWS_DEVICE_ID   XPAR_SWS_8BITS_DEVICE_ID
+#define INPUT_TIMER_DEVICE_ID XPAR_XSCUTIMER_0_DEVICE_ID
+#define INPUT_TIMER_INTR_ID   XPAR_SCUTIMER_INTR
+
+#if XPAR_BTNS_5BITS_INTERRUPT_PRESENT && XPAR_SWS_8BITS_INTERRUPT_PRESENT
+#define INPUT_HAVE_GPIO_INTR 1
+#else
+#define INPUT_HAVE_GPIO_INTR 0
+#endif
+
+// IRQ_F2P[1] and [2] are SPIs 62 and 63
+#ifdef XPAR_FABRIC_BTNS_5BITS_IP2INTC_IRPT_INTR
+#define INPUT_BTNS_INTR_ID XPAR_FABRIC_BTNS_5BITS_IP2INTC_IRPT_INTR
+#else
+#define INPUT_BTNS_INTR_ID 62
+#endif
+#ifdef XPAR_FABRIC_SWS_8BITS_IP2INTC_IRPT_INTR
+#define INPUT_SWS_INTR_ID XPAR_FABRIC_SWS_8BITS_IP2INTC_IRPT_INTR
+#else
+#define INPUT_SWS_INTR_ID 63
+#endif
+
+#define INPUT_TICK_HZ        1000
+#define INPUT_DEBOUNCE_MS    20
+#define INPUT_LONG_PRESS_MS  800
+#define INPUT_QUEUE_LEN      32         // a power of two
+
+#define INPUT_NUM_BTNS       5
+#define INPUT_NUM_SWS        8
+#define INPUT_SW_SHIFT       8          // switches in the debounced state
+#define INPUT_NUM_BITS       (INPUT_SW_SHIFT + INPUT_NUM_SWS)
+
+#define INPUT_DEBOUNCE_TICKS   (INPUT_DEBOUNCE_MS * INPUT_TICK_HZ / 1000)
+#define INPUT_LONG_PRESS_TICKS (INPUT_LONG_PRESS_MS * INPUT_TICK_HZ / 1000)
+
+// Event types
+#define INPUT_PRESS       0             // a button pressed, a switch turned on
+#define INPUT_RELEASE     1             // and released, turned off
+#define INPUT_LONG_PRESS  2             // a button still held
+
+// Event sources
+#define INPUT_BTN         0
+#define INPUT_SW          1
+
+struct struct_input_event_t {
+	Xuint8 type;
+	Xuint8 source;
+	Xuint8 index;                   // button or switch number
+	Xuint32 tick;                   // when it was debounced
+}; typedef struct struct_input_event_t input_event_t;
+
+struct struct_input_t {
+	XGpio btns;
+	XGpio sws;
+	XScuTimer timer;
+	XScuGic *intc;                  // NULL: sampled from input_get()
+	int gpio_intr;                  // the GPIO interrupts wake the timer
+	volatile Xuint32 state;         // debounced levels
+	Xuint8 count[INPUT_NUM_BITS];   // ticks the level has differed
+	Xuint16 held[INPUT_NUM_BTNS];   // ticks since the press
+	volatile Xuint32 ticks;
+	u64 next_sample;                // global timer, without interrupts
+	input_event_t queue[INPUT_QUEUE_LEN];
+	volatile Xuint32 head;          // next event to take
+	volatile Xuint32 tail;          // next free slot
+	volatile Xuint32 events;
+	volatile Xuint32 dropped;       // queue full
+	volatile Xuint32 wakeups;       // GPIO interrupts
+}; typedef struct struct_input_t input_t;
+
+// Function prototypes (input.c)
+int input_init(input_t *in, XScuGic *pIntc);
+int input_get(input_t *in, input_event_t *ev);
+void input_wait(input_t *in, input_event_t *ev);
+int input_btn(input_t *in, int index);
+int input_sw(input_t *in, int index);
+void input_report(input_t *in);
+
+#endif // __INPUT_H__
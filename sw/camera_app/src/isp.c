@@ -0,0 +1,441 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * isp.c - Software ISP pipeline: stage registration, the quad row loop
+ * that runs every stage on a line while it is in cache, per-stage cycle
+ * accounting, and the standard stages.
+ *****************************************************************************/
+
+#include "xil_printf.h"
+#include "xstatus.h"
+#include "isp.h"
+#include "bayer2ycbcr.h"
+
+// Intermediate lines, one set per core
+static uint16_t isp_rgb[AMP_NUM_CPUS][2][3][DEMOSAIC_MAX_WIDTH];
+static uint16_t isp_ycc[AMP_NUM_CPUS][2][3][DEMOSAIC_MAX_WIDTH];
+static isp_line_t isp_lines[AMP_NUM_CPUS];
+
+// Bayer lines for isp_time_kernels(), enough for the 5x5 window
+static Xuint16 isp_test_bayer[2 * DEMOSAIC_MHC_APRON + 2][DEMOSAIC_MAX_WIDTH];
+
+// Every width in VRES_MODE_LIST must suit the row kernels and the lines
+#define ISP_VRES_WIDTH_CHECK(id, width, ...) \
+	typedef char isp_vres_width_ok_##id[((width) % 4 == 0 && (width) <= DEMOSAIC_MAX_WIDTH) ? 1 : -1];
+VRES_MODE_LIST(ISP_VRES_WIDTH_CHECK)
+
+// Fixed-width row kernels, indexed by VIDEO_RESOLUTION_*
+#define ISP_VRES_KERNELS(id, width, ...) \
+	[VIDEO_RESOLUTION_##id] = { #id, width, demosaic_bilinear_quad_row_##id, demosaic_mhc_quad_row_##id, \
+		demosaic_bin2_quad_row_##id, bayer2ycbcr_quad_row_##id },
+static const isp_kernels_t isp_vres_kernels[NUM_VIDEO_RESOLUTIONS] = {
+	VRES_MODE_LIST(ISP_VRES_KERNELS)
+};
+
+void isp_init(isp_pipeline_t *pipe)
+{
+	pipe->num_stages = 0;
+	pipe->apron = DEMOSAIC_BILINEAR_APRON;
+	pipe->bin = 1;
+	pipe->kernels = NULL;
+	isp_reset_stats(pipe);
+}
+
+// Append a stage. Returns XST_FAILURE if the pipeline is full.
+int isp_add_stage(isp_pipeline_t *pipe, const char *name, isp_stage_fn fn, void *ctx)
+{
+	isp_stage_t *stage;
+	int cpu;
+
+	if (pipe->num_stages == ISP_MAX_STAGES)
+		return XST_FAILURE;
+
+	stage = &pipe->stage[pipe->num_stages++];
+	stage->name = name;
+	stage->fn = fn;
+	stage->ctx = ctx;
+	if (fn == isp_stage_demosaic_mhc)
+		pipe->apron = DEMOSAIC_MHC_APRON;
+	if (fn == isp_stage_bin2)
+		pipe->bin = 2;
+	for (cpu = 0; cpu < AMP_NUM_CPUS; cpu++) {
+		stage->cycles[cpu] = 0;
+	}
+
+	return XST_SUCCESS;
+}
+
+// Use the row kernels built for video mode resolution (a VIDEO_RESOLUTION_*
+// value) on frames and bands width pixels wide. Returns XST_FAILURE, and
+// leaves the generic kernels in place, if the mode is unknown or is not
+// width pixels wide.
+int isp_select_kernels(isp_pipeline_t *pipe, Xuint32 resolution, int width)
+{
+	pipe->kernels = NULL;
+	if (resolution >= NUM_VIDEO_RESOLUTIONS || isp_vres_kernels[resolution].width != width)
+		return XST_FAILURE;
+
+	pipe->kernels = &isp_vres_kernels[resolution];
+	return XST_SUCCESS;
+}
+
+// Point a core's line context at its scratch lines
+static isp_line_t *isp_line_setup(const isp_pipeline_t *pipe, int cpu, int width, int height, int stride)
+{
+	isp_line_t *line = &isp_lines[cpu];
+	int bin = pipe->bin;
+	int l, c;
+
+	line->kernels = (pipe->kernels && pipe->kernels->width == width) ? pipe->kernels : NULL;
+	line->cpu = cpu;
+	line->width = width;
+	line->height = height;
+	line->stride = stride;
+	line->out_width = width / bin;
+	line->out_lines = 2 / bin;
+	for (l = 0; l < 2; l++) {
+		line->rgb[l].R = isp_rgb[cpu][l][0];
+		line->rgb[l].G = isp_rgb[cpu][l][1];
+		line->rgb[l].B = isp_rgb[cpu][l][2];
+		for (c = 0; c < 3; c++) {
+			line->ycc[l][c] = isp_ycc[cpu][l][c];
+		}
+	}
+
+	return line;
+}
+
+// Run every stage on quad rows [y_start, y_end) of the frame streaming
+// through lbuf (already set up for that band, with the pipeline's apron),
+// writing 4:2:2 lines to dst at the same stride. Returns the sum of the
+// stages' problem counts.
+int isp_run_rows(isp_pipeline_t *pipe, line_buffer_t *lbuf, Xuint16 *dst, int y_start, int y_end)
+{
+	int cpu = amp_cpu_id();
+	isp_line_t *line = isp_line_setup(pipe, cpu, lbuf->width, lbuf->height, lbuf->stride);
+	isp_stage_t *stage;
+	Xuint32 t;
+	int y, s, l;
+	int errors = 0;
+
+	for (y = y_start; y < y_end; y += 2) {
+		lbuf_window(lbuf, y, line->window);
+		line->above = line->window[lbuf->apron - 1];
+		line->even = line->window[lbuf->apron];
+		line->odd = line->window[lbuf->apron + 1];
+		line->below = line->window[lbuf->apron + 2];
+		line->y = y;
+		line->out_y = y / pipe->bin;
+		line->out[0] = dst + line->out_y * line->stride;
+		line->out[1] = line->out[0] + line->stride;
+
+		for (s = 0; s < pipe->num_stages; s++) {
+			stage = &pipe->stage[s];
+			t = amp_cycles();
+			errors += stage->fn(stage->ctx, line);
+			stage->cycles[cpu] += amp_cycles() - t;
+		}
+
+		for (l = 0; l < line->out_lines; l++) {
+			lbuf_write_back(line->out[l], line->out_width, 1);
+		}
+	}
+
+	return errors;
+}
+
+void isp_reset_stats(isp_pipeline_t *pipe)
+{
+	int s, cpu;
+
+	for (s = 0; s < pipe->num_stages; s++) {
+		for (cpu = 0; cpu < AMP_NUM_CPUS; cpu++) {
+			pipe->stage[s].cycles[cpu] = 0;
+		}
+	}
+	pipe->frames = 0;
+}
+
+// Average cost of each stage per frame, on each core and per pixel
+void isp_report(isp_pipeline_t *pipe)
+{
+	isp_stage_t *stage;
+	u64 total;
+	int s, cpu;
+
+	if (pipe->frames == 0 || pipe->pixels == 0)
+		return;
+
+	xil_printf("ISP pipeline, %d frames, %s kernels:\r\n", pipe->frames,
+			pipe->kernels ? pipe->kernels->name : "generic");
+	for (s = 0; s < pipe->num_stages; s++) {
+		stage = &pipe->stage[s];
+		total = 0;
+		xil_printf("  %-16s", stage->name);
+		for (cpu = 0; cpu < AMP_NUM_CPUS; cpu++) {
+			xil_printf(" core %d: %d kcycles/frame", cpu, (Xuint32)(stage->cycles[cpu] / pipe->frames / 1000));
+			total += stage->cycles[cpu];
+		}
+		xil_printf(", %d.%02d cycles/pixel\r\n",
+				(Xuint32)(total / pipe->frames / pipe->pixels),
+				(Xuint32)(total * 100 / pipe->frames / pipe->pixels) % 100);
+	}
+}
+
+// Time ISP_KERNEL_TIMING_ROWS calls of a row kernel into cycles, after
+// one call to warm the caches
+#define ISP_TIME_ROWS(cycles, call) \
+	do { \
+		Xuint32 t_; \
+		int r_; \
+		call; \
+		t_ = amp_cycles(); \
+		for (r_ = 0; r_ < ISP_KERNEL_TIMING_ROWS; r_++) { \
+			call; \
+		} \
+		cycles = amp_cycles() - t_; \
+	} while (0)
+
+static void isp_print_kernel_time(const char *name, Xuint32 generic, Xuint32 fixed, int width)
+{
+	u64 pixels = (u64)2 * width * ISP_KERNEL_TIMING_ROWS;
+
+	xil_printf("  %-12s generic %d.%02d, fixed %d.%02d cycles/pixel\r\n", name,
+			(Xuint32)(generic / pixels), (Xuint32)((u64)generic * 100 / pixels % 100),
+			(Xuint32)(fixed / pixels), (Xuint32)((u64)fixed * 100 / pixels % 100));
+}
+
+// Time the row kernels isp_select_kernels() picked against the generic
+// ones, on a test pattern in this core's scratch lines, and print both in
+// cycles per Bayer pixel. The fused kernel runs without a tone LUT. Call
+// between frames, as it uses the lines the pipeline runs in.
+void isp_time_kernels(const isp_pipeline_t *pipe)
+{
+	const isp_kernels_t *k = pipe->kernels;
+	const Xuint16 *window[2 * DEMOSAIC_MHC_APRON + 2];
+	const Xuint16 *above, *even, *odd, *below;
+	isp_line_t *line;
+	Xuint16 *out[2];
+	csc_coef_t coef;
+	Xuint32 generic, fixed;
+	int w, l, x;
+
+	if (!k)
+		return;
+	w = k->width;
+	line = isp_line_setup(pipe, amp_cpu_id(), w, 2 * DEMOSAIC_MHC_APRON + 2, w);
+	for (l = 0; l < 2 * DEMOSAIC_MHC_APRON + 2; l++) {
+		for (x = 0; x < w; x++) {
+			isp_test_bayer[l][x] = (x * 37 + l * 101) & BAYER_MAX;
+		}
+		window[l] = isp_test_bayer[l];
+	}
+	above = window[DEMOSAIC_MHC_APRON - 1];
+	even = window[DEMOSAIC_MHC_APRON];
+	odd = window[DEMOSAIC_MHC_APRON + 1];
+	below = window[DEMOSAIC_MHC_APRON + 2];
+	out[0] = line->ycc[0][0];
+	out[1] = line->ycc[1][0];
+	csc_coef_default(&coef);
+
+	xil_printf("Row kernels for %s (%d wide), %d calls each:\r\n", k->name, w, ISP_KERNEL_TIMING_ROWS);
+	ISP_TIME_ROWS(generic, demosaic_bilinear_quad_row(above, even, odd, below, &line->rgb[0], &line->rgb[1], w));
+	ISP_TIME_ROWS(fixed, k->bilinear(above, even, odd, below, &line->rgb[0], &line->rgb[1]));
+	isp_print_kernel_time("demosaic", generic, fixed, w);
+	ISP_TIME_ROWS(generic, demosaic_mhc_quad_row(window, &line->rgb[0], &line->rgb[1], w));
+	ISP_TIME_ROWS(fixed, k->mhc(window, &line->rgb[0], &line->rgb[1]));
+	isp_print_kernel_time("demosaic 5x5", generic, fixed, w);
+	ISP_TIME_ROWS(generic, demosaic_bin2_quad_row(even, odd, &line->rgb[0], w));
+	ISP_TIME_ROWS(fixed, k->bin2(even, odd, &line->rgb[0]));
+	isp_print_kernel_time("bin 2x2", generic, fixed, w);
+	ISP_TIME_ROWS(generic, bayer2ycbcr_quad_row(&coef, NULL, above, even, odd, below, out[0], out[1], w));
+	ISP_TIME_ROWS(fixed, k->bayer2ycbcr(&coef, NULL, above, even, odd, below, out[0], out[1]));
+	isp_print_kernel_time("bayer2ycbcr", generic, fixed, w);
+}
+
+// Bilinear demosaic into the RGB lines
+int isp_stage_demosaic(void *ctx, isp_line_t *line)
+{
+	if (line->kernels)
+		line->kernels->bilinear(line->above, line->even, line->odd, line->below, &line->rgb[0], &line->rgb[1]);
+	else
+		demosaic_bilinear_quad_row(line->above, line->even, line->odd, line->below, &line->rgb[0], &line->rgb[1], line->width);
+	return 0;
+}
+
+// Gradient-corrected 5x5 demosaic into the RGB lines (needs an apron of
+// DEMOSAIC_MHC_APRON, which isp_add_stage() sets up)
+int isp_stage_demosaic_mhc(void *ctx, isp_line_t *line)
+{
+	if (line->kernels)
+		line->kernels->mhc(line->window, &line->rgb[0], &line->rgb[1]);
+	else
+		demosaic_mhc_quad_row(line->window, &line->rgb[0], &line->rgb[1], line->width);
+	return 0;
+}
+
+// 2x2 binning into one half-width RGB line (see isp.h)
+int isp_stage_bin2(void *ctx, isp_line_t *line)
+{
+	if (line->kernels)
+		line->kernels->bin2(line->even, line->odd, &line->rgb[0]);
+	else
+		demosaic_bin2_quad_row(line->even, line->odd, &line->rgb[0], line->width);
+	return 0;
+}
+
+// Per-channel gains on the RGB lines
+int isp_stage_white_balance(void *ctx, isp_line_t *line)
+{
+	const isp_wb_t *wb = (const isp_wb_t *)ctx;
+	uint16_t *plane;
+	int l, c, x;
+	Xuint32 v;
+
+	for (l = 0; l < line->out_lines; l++) {
+		for (c = 0; c < 3; c++) {
+			plane = (c == 0) ? line->rgb[l].R : (c == 1) ? line->rgb[l].G : line->rgb[l].B;
+			for (x = 0; x < line->out_width; x++) {
+				v = (plane[x] * wb->gain[c]) >> 8;
+				plane[x] = (v > BAYER_MAX) ? BAYER_MAX : v;
+			}
+		}
+	}
+
+	return 0;
+}
+
+// Identity curve at 8 bits; at higher depths drop the extra bits, with
+// rounding
+void isp_tone_linear(isp_gamma_t *gamma)
+{
+	int shift = BAYER_BITS - CSC_DATA_WIDTH;
+	int i, v;
+
+	for (i = 0; i < ISP_TONE_LUT_SIZE; i++) {
+		v = (shift == 0) ? i : (i + (1 << (shift - 1))) >> shift;
+		gamma->lut[i] = (v > 255) ? 255 : v;
+	}
+}
+
+// Table lookup on every RGB sample, sensor depth in, 8 bits out
+int isp_stage_gamma(void *ctx, isp_line_t *line)
+{
+	const isp_gamma_t *gamma = (const isp_gamma_t *)ctx;
+	uint16_t *plane;
+	int l, c, x;
+
+	for (l = 0; l < line->out_lines; l++) {
+		for (c = 0; c < 3; c++) {
+			plane = (c == 0) ? line->rgb[l].R : (c == 1) ? line->rgb[l].G : line->rgb[l].B;
+			for (x = 0; x < line->out_width; x++) {
+				plane[x] = gamma->lut[plane[x] & BAYER_MAX];
+			}
+		}
+	}
+
+	return 0;
+}
+
+// RGB to YCbCr, ctx is the csc_coef_t. Y for every pixel, chroma once
+// per pixel pair (csc_chroma_pair()), held at the pair's even pixel.
+int isp_stage_csc(void *ctx, isp_line_t *line)
+{
+	const csc_coef_t *coef = (const csc_coef_t *)ctx;
+	uint16_t ycc[4];
+	int l, x;
+
+	for (l = 0; l < line->out_lines; l++) {
+		for (x = 0; x < line->out_width; x += 2) {
+			csc_convert_pair(coef, &line->rgb[l], x, ycc);
+			line->ycc[l][CSC_Y][x] = ycc[0];
+			line->ycc[l][CSC_Y][x+1] = ycc[1];
+			line->ycc[l][CSC_CB][x] = ycc[2];
+			line->ycc[l][CSC_CR][x] = ycc[3];
+		}
+	}
+
+	return 0;
+}
+
+// 4:2:2 output, one 32-bit store per pixel pair, as in csc_convert_line()
+int isp_stage_422(void *ctx, isp_line_t *line)
+{
+	int l, x;
+
+	for (l = 0; l < line->out_lines; l++) {
+		for (x = 0; x < line->out_width; x += 2) {
+			*(csc_pair_t *)(line->out[l] + x) = csc_pack_pair(line->ycc[l][CSC_Y][x], line->ycc[l][CSC_Y][x+1],
+					line->ycc[l][CSC_CB][x], line->ycc[l][CSC_CR][x]);
+		}
+	}
+
+	return 0;
+}
+
+// Draw a rectangle outline on the 4:2:2 output
+int isp_stage_overlay(void *ctx, isp_line_t *line)
+{
+	const isp_overlay_t *box = (const isp_overlay_t *)ctx;
+	Xuint16 even_px = box->Cb << 8 | box->Y;
+	Xuint16 odd_px = box->Cr << 8 | box->Y;
+	int x_end = box->x + box->w;
+	int l, x, y;
+	Xuint16 *out;
+
+	for (l = 0; l < line->out_lines; l++) {
+		y = line->out_y + l;
+		if (y < box->y || y >= box->y + box->h)
+			continue;
+
+		out = line->out[l];
+		if (y < box->y + box->thickness || y >= box->y + box->h - box->thickness) {
+			// Top or bottom edge
+			for (x = box->x; x < x_end; x += 2) {
+				out[x] = even_px;
+				out[x+1] = odd_px;
+			}
+		} else {
+			// Left and right edges, whole pixel pairs
+			for (x = 0; x < box->thickness; x += 2) {
+				out[box->x + x] = even_px;
+				out[box->x + x + 1] = odd_px;
+				out[x_end - 2 - x] = even_px;
+				out[x_end - 1 - x] = odd_px;
+			}
+		}
+	}
+
+	return 0;
+}
+
+// The fused kernel on a quad row, the fixed-width one if the line has one
+void isp_bayer2ycbcr_row(const isp_line_t *line, const csc_coef_t *coef, const uint16_t *tone)
+{
+	if (line->kernels)
+		line->kernels->bayer2ycbcr(coef, tone, line->above, line->even, line->odd, line->below, line->out[0], line->out[1]);
+	else
+		bayer2ycbcr_quad_row(coef, tone, line->above, line->even, line->odd, line->below,
+				line->out[0], line->out[1], line->width);
+}
+
+// Demosaic, CSC and 4:2:2 in one (NEON) kernel, ctx is the csc_coef_t.
+// No tone LUT: see tone_stage_bayer2ycbcr().
+int isp_stage_bayer2ycbcr(void *ctx, isp_line_t *line)
+{
+	isp_bayer2ycbcr_row(line, (const csc_coef_t *)ctx, NULL);
+	return 0;
+}
+
+// As isp_stage_bayer2ycbcr, checked against the scalar reference
+int isp_stage_bayer2ycbcr_verify(void *ctx, isp_line_t *line)
+{
+	return bayer2ycbcr_quad_row_compare((const csc_coef_t *)ctx, NULL, line->above, line->even, line->odd, line->below,
+			line->out[0], line->out[1], line->width);
+}
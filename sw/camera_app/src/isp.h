@@ -0,0 +1,164 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * isp.h - Line-granular software ISP pipeline.
+ *
+ *
+ * NOTES:
+ * A pipeline is an ordered list of stages. Each stage is a callback that
+ * works on one quad row (two output lines) held in the per-core line
+ * context: Bayer lines from the line buffer, two RGB lines, two YCbCr
+ * lines (Y per pixel, Cb/Cr per pixel pair) and the two 4:2:2 output
+ * lines in the frame. All stages run on a quad row before the next one is
+ * fetched, so a line makes a single pass through the cache however many
+ * stages there are.
+ *
+ * Stages must be added in data-flow order:
+ *    demosaic -> [white balance] -> [gamma] -> csc -> 422 -> [overlay]
+ * where demosaic is either the bilinear or the 5x5 (demosaic_mhc) stage,
+ * or use the fused bayer2ycbcr stage in place of demosaic/csc/422 when
+ * there is nothing to do on the RGB lines (tone_stage_bayer2ycbcr() in
+ * place of demosaic/gamma/csc/422 for the tone LUT alone).
+ *
+ * The demosaic and white balance stages work at the sensor bit depth
+ * (BAYER_BITS); the gamma stage is the tone LUT that takes the samples
+ * down to the 8 bits csc expects. Without it, give csc a converter from
+ * csc_coef_scale_input() when BAYER_BITS is above 8.
+ *
+ * The pipeline records how many lines its stages need around a quad row
+ * (its apron), and the line buffer is set up to match.
+ *
+ * With the binning stage (isp_stage_bin2) in place of the demosaic, each
+ * quad row gives a single RGB line of half the width, and the stages after
+ * it work on out_lines lines of out_width pixels. Output line y/2 then
+ * goes to line y/2 of dst (at the full frame stride), so a caller that
+ * passes a dst inside a full-size frame store gets the preview anywhere
+ * in it.
+ *
+ * The frame can also be a rectangle of a larger one (amp_isp_region());
+ * the line y coordinates are then relative to the rectangle, and its
+ * edges are mirrored like the frame edges.
+ *
+ * Each row kernel module also builds its kernel once for every video
+ * mode's width in VRES_MODE_LIST (video_resolution.h), so that the loop
+ * bounds, edge columns and NEON tails fold to constants.
+ * isp_select_kernels() picks the set for config->hdmio_resolution; the
+ * demosaic, binning and fused stages then call it on every band of that
+ * width, and keep the generic kernels for ROIs and other widths.
+ * isp_time_kernels() times the set against the generic kernels on the
+ * board, so that the choice rests on cycles measured there.
+ *****************************************************************************/
+
+#ifndef __ISP_H__
+#define __ISP_H__
+
+#include <stdint.h>
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "demosaic.h"
+#include "csc.h"
+#include "line_buffer.h"
+#include "amp.h"
+
+#define ISP_MAX_STAGES 8
+
+// Calls of each row kernel timed by isp_time_kernels()
+#define ISP_KERNEL_TIMING_ROWS 64
+
+// Row kernels with the line width fixed at compile time
+struct struct_isp_kernels_t {
+	const char *name;               // video mode
+	int width;
+	void (*bilinear)(const Xuint16 *above, const Xuint16 *even, const Xuint16 *odd, const Xuint16 *below,
+			rgb_line_t *out_even, rgb_line_t *out_odd);
+	void (*mhc)(const Xuint16 *const *lines, rgb_line_t *out_even, rgb_line_t *out_odd);
+	void (*bin2)(const Xuint16 *even, const Xuint16 *odd, rgb_line_t *out);
+	void (*bayer2ycbcr)(const csc_coef_t *coef, const uint16_t *tone, const Xuint16 *above, const Xuint16 *even,
+			const Xuint16 *odd, const Xuint16 *below, Xuint16 *out_even, Xuint16 *out_odd);
+}; typedef struct struct_isp_kernels_t isp_kernels_t;
+
+// Everything a stage can see for the current quad row (lines y and y+1)
+struct struct_isp_line_t {
+	int y;
+	int width;
+	int height;
+	int stride;                                   // words per frame line
+	int cpu;
+	int out_y;                                    // first output line
+	int out_width;                                // RGB, YCbCr and 4:2:2 lines
+	int out_lines;                                // per quad row, 2 or 1
+	const Xuint16 *window[LBUF_MAX_LINES];       // Bayer, lines y-apron ..
+	const Xuint16 *above, *even, *odd, *below;   // Bayer
+	rgb_line_t rgb[2];                            // demosaicked (or binned)
+	uint16_t *ycc[2][3];                          // [line][Y/Cb/Cr], Cb/Cr at even x
+	Xuint16 *out[2];                              // 4:2:2, in the frame
+	const isp_kernels_t *kernels;                 // for this width, or NULL
+}; typedef struct struct_isp_line_t isp_line_t;
+
+// A stage returns the number of problems it found on the quad row
+// (reference mismatches); 0 normally
+typedef int (*isp_stage_fn)(void *ctx, isp_line_t *line);
+
+struct struct_isp_stage_t {
+	const char *name;
+	isp_stage_fn fn;
+	void *ctx;
+	u64 cycles[AMP_NUM_CPUS];       // PMU cycles since the last reset
+}; typedef struct struct_isp_stage_t isp_stage_t;
+
+struct struct_isp_pipeline_t {
+	isp_stage_t stage[ISP_MAX_STAGES];
+	int num_stages;
+	int apron;                      // Bayer lines read on each side of a quad row
+	int bin;                        // 1, or 2 after isp_stage_bin2
+	const isp_kernels_t *kernels;   // isp_select_kernels(), or NULL
+	Xuint32 frames;
+	Xuint32 pixels;                 // output pixels per frame
+}; typedef struct struct_isp_pipeline_t isp_pipeline_t;
+
+// Stage contexts
+struct struct_isp_wb_t {
+	uint16_t gain[3];               // R/G/B, Q8 (256 = 1.0)
+}; typedef struct struct_isp_wb_t isp_wb_t;
+
+#define ISP_TONE_LUT_SIZE (BAYER_MAX + 1)
+
+struct struct_isp_gamma_t {
+	uint16_t lut[ISP_TONE_LUT_SIZE];  // sensor level to 8-bit level
+}; typedef struct struct_isp_gamma_t isp_gamma_t;
+
+struct struct_isp_overlay_t {
+	int x, y, w, h;                 // x and w even
+	int thickness;
+	uint8_t Y, Cb, Cr;
+}; typedef struct struct_isp_overlay_t isp_overlay_t;
+
+// Function prototypes (isp.c)
+void isp_init(isp_pipeline_t *pipe);
+int isp_add_stage(isp_pipeline_t *pipe, const char *name, isp_stage_fn fn, void *ctx);
+int isp_select_kernels(isp_pipeline_t *pipe, Xuint32 resolution, int width);
+void isp_time_kernels(const isp_pipeline_t *pipe);
+int isp_run_rows(isp_pipeline_t *pipe, line_buffer_t *lbuf, Xuint16 *dst, int y_start, int y_end);
+void isp_reset_stats(isp_pipeline_t *pipe);
+void isp_report(isp_pipeline_t *pipe);
+void isp_tone_linear(isp_gamma_t *gamma);
+
+int isp_stage_demosaic(void *ctx, isp_line_t *line);
+int isp_stage_demosaic_mhc(void *ctx, isp_line_t *line);
+int isp_stage_bin2(void *ctx, isp_line_t *line);
+int isp_stage_white_balance(void *ctx, isp_line_t *line);
+int isp_stage_gamma(void *ctx, isp_line_t *line);
+int isp_stage_csc(void *ctx, isp_line_t *line);
+int isp_stage_422(void *ctx, isp_line_t *line);
+int isp_stage_overlay(void *ctx, isp_line_t *line);
+void isp_bayer2ycbcr_row(const isp_line_t *line, const csc_coef_t *coef, const uint16_t *tone);
+int isp_stage_bayer2ycbcr(void *ctx, isp_line_t *line);
+int isp_stage_bayer2ycbcr_verify(void *ctx, isp_line_t *line);
+
+#endif // __ISP_H__
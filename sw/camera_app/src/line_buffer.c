@@ -0,0 +1,142 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * line_buffer.c - Rolling line buffer for the software ISP. Frame line n
+ * lives in ring slot n % LBUF_LINES; moving to the next quad row fetches
+ * two new lines into the slots of the two lines that are no longer
+ * needed, and starts prefetching the two lines after that.
+ *****************************************************************************/
+
+#include <string.h>
+#include "line_buffer.h"
+#include "amp.h"
+
+// Private copy of frame line n, if the band was given one
+static const Xuint16 *lbuf_edge(line_buffer_t *lbuf, int n)
+{
+	if (lbuf->edge_above && n < lbuf->first + lbuf->apron)
+		return lbuf->edge_above + (n - lbuf->first) * lbuf->width;
+	if (lbuf->edge_below && n > lbuf->last - lbuf->apron)
+		return lbuf->edge_below + (n - (lbuf->last - lbuf->apron + 1)) * lbuf->width;
+	return NULL;
+}
+
+// Invalidate frame line n (the S2MM channel wrote it behind the cache's
+// back) and ask the L2 to start pulling it in. Lines outside the band,
+// and lines served from a private copy, are left alone: another core may
+// be writing them.
+static void lbuf_prefetch(line_buffer_t *lbuf, int n)
+{
+	const Xuint16 *line = lbuf->frame + n * lbuf->stride;
+	int bytes = lbuf->width * sizeof(Xuint16);
+	int i;
+
+	if (n > lbuf->last || lbuf_edge(lbuf, n))
+		return;
+
+	amp_dcache_invalidate_range(line, bytes);
+	for (i = 0; i < bytes; i += LBUF_CACHE_LINE) {
+		__builtin_prefetch((const char *)line + i);
+	}
+}
+
+// Copy frame line n into its ring slot
+static void lbuf_fetch(line_buffer_t *lbuf, int n)
+{
+	const Xuint16 *line = lbuf_edge(lbuf, n);
+
+	if (!line)
+		line = lbuf->frame + n * lbuf->stride;
+	memcpy(lbuf->ring[n % lbuf->lines], line, lbuf->width * sizeof(Xuint16));
+	lbuf->fetched = n + 1;
+}
+
+// Start streaming the band of quad rows [y_start, y_end) (both even) of a
+// new frame, so each core can walk its own band; apron is the number of
+// lines the kernel needs on each side of a quad row. When the frame is
+// converted in place, the neighbouring bands overwrite the apron lines
+// above and below the band; pass copies of them (apron consecutive lines
+// each) in edge_above/edge_below. The frame may be a rectangle inside a
+// wider one, stride words per line.
+void lbuf_init(line_buffer_t *lbuf, const Xuint16 *frame, int width, int height, int stride, int y_start, int y_end,
+		int apron, const Xuint16 *edge_above, const Xuint16 *edge_below)
+{
+	lbuf->frame = frame;
+	lbuf->width = width;
+	lbuf->height = height;
+	lbuf->stride = stride;
+	lbuf->apron = apron;
+	lbuf->lines = 2 + 2 * apron;
+	lbuf->first = (y_start > apron) ? y_start - apron : 0;
+	lbuf->last = (y_end - 1 + apron < height) ? y_end - 1 + apron : height - 1;
+	lbuf->edge_above = (y_start >= apron && y_start > 0) ? edge_above : NULL;
+	lbuf->edge_below = (y_end < height) ? edge_below : NULL;
+	lbuf->fetched = lbuf->first;
+
+	lbuf_prefetch(lbuf, lbuf->first);
+	lbuf_prefetch(lbuf, lbuf->first + 1);
+}
+
+// Copy every line up to the bottom of quad row y's window into the ring
+static void lbuf_advance(line_buffer_t *lbuf, int y)
+{
+	int last = (y + 1 + lbuf->apron < lbuf->height) ? y + 1 + lbuf->apron : lbuf->height - 1;
+	int n;
+
+	while ((n = lbuf->fetched) <= last) {
+		lbuf_fetch(lbuf, n);
+		// Keep two lines in flight ahead of the one just copied
+		lbuf_prefetch(lbuf, n + 2);
+	}
+}
+
+// Ring slot of frame line n, mirroring lines outside the frame back into
+// it (line -1 is line 1, line height is line height-2) so the RGGB
+// phase is kept
+static const Xuint16 *lbuf_line(line_buffer_t *lbuf, int n)
+{
+	if (n < 0)
+		n = -n;
+	else if (n >= lbuf->height)
+		n = 2 * lbuf->height - 2 - n;
+	return lbuf->ring[n % lbuf->lines];
+}
+
+// Return the four lines of quad row y (y even, rows visited in order) from
+// the ring, mirroring the missing neighbour line on the first and last
+// quad rows like demosaic_quad_row_lines().
+void lbuf_quad_row(line_buffer_t *lbuf, int y, const Xuint16 **above, const Xuint16 **even, const Xuint16 **odd, const Xuint16 **below)
+{
+	lbuf_advance(lbuf, y);
+
+	*above = lbuf_line(lbuf, y - 1);
+	*even  = lbuf_line(lbuf, y);
+	*odd   = lbuf_line(lbuf, y + 1);
+	*below = lbuf_line(lbuf, y + 2);
+}
+
+// Return the 2 + 2 * apron lines y - apron .. y + 1 + apron of quad row y
+// (y even, rows visited in order), mirrored at the frame edges
+void lbuf_window(line_buffer_t *lbuf, int y, const Xuint16 **lines)
+{
+	int i;
+
+	lbuf_advance(lbuf, y);
+
+	for (i = 0; i < lbuf->lines; i++) {
+		lines[i] = lbuf_line(lbuf, y - lbuf->apron + i);
+	}
+}
+
+// Push finished output lines out to DDR in whole cache lines so the MM2S
+// channel sees them
+void lbuf_write_back(const Xuint16 *line, int width, int num_lines)
+{
+	amp_dcache_flush_range(line, width * num_lines * sizeof(Xuint16));
+}
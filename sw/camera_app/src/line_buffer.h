@@ -0,0 +1,60 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * line_buffer.h - Rolling line buffer that streams a Bayer frame out of DDR
+ * for the software ISP.
+ *
+ *
+ * NOTES:
+ * Each source line is invalidated, prefetched and copied into a small ring
+ * of cache-resident lines exactly once per frame; the kernels then read
+ * their neighbourhood from the ring instead of frame memory.
+ *
+ * The apron is the number of lines a kernel needs on each side of a quad
+ * row: 1 for the bilinear demosaic, 2 for the 5x5 gradient-corrected one.
+ *****************************************************************************/
+
+#ifndef __LINE_BUFFER_H__
+#define __LINE_BUFFER_H__
+
+#include <xbasic_types.h>
+#include "demosaic.h"
+
+// A quad row needs its two lines and up to LBUF_MAX_APRON lines on either
+// side of them
+#define LBUF_MAX_APRON 2
+#define LBUF_MAX_LINES (2 + 2 * LBUF_MAX_APRON)
+
+// Bytes per L1/L2 cache line on the Cortex-A9
+#define LBUF_CACHE_LINE 32
+
+struct struct_line_buffer_t {
+	const Xuint16 *frame;
+	int width;
+	int height;
+	int stride;                   // words from one frame line to the next
+	int apron;
+	int lines;                    // ring slots in use, 2 + 2 * apron
+	int first;                    // frame lines the band reads
+	int last;
+	const Xuint16 *edge_above;    // private copies of the apron lines at
+	const Xuint16 *edge_below;    // first and last, or NULL to read them
+	                              // from the frame
+	int fetched;                  // next frame line to copy into the ring
+	Xuint16 ring[LBUF_MAX_LINES][DEMOSAIC_MAX_WIDTH] __attribute__((aligned(LBUF_CACHE_LINE)));
+}; typedef struct struct_line_buffer_t line_buffer_t;
+
+// Function prototypes (line_buffer.c)
+void lbuf_init(line_buffer_t *lbuf, const Xuint16 *frame, int width, int height, int stride, int y_start, int y_end,
+		int apron, const Xuint16 *edge_above, const Xuint16 *edge_below);
+void lbuf_quad_row(line_buffer_t *lbuf, int y, const Xuint16 **above, const Xuint16 **even, const Xuint16 **odd, const Xuint16 **below);
+void lbuf_window(line_buffer_t *lbuf, int y, const Xuint16 **lines);
+void lbuf_write_back(const Xuint16 *line, int width, int num_lines);
+
+#endif // __LINE_BUFFER_H__
@@ -0,0 +1,128 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * perf.c - Sample ring buffer and UART summaries for the PMU / global timer
+ * instrumentation.
+ *****************************************************************************/
+
+#include "xil_printf.h"
+#include "amp.h"
+#include "perf.h"
+
+// Defined in xpm_counter.c but not declared in its header
+void Xpm_EnableEventCounters(void);
+
+static const char *perf_region_name[PERF_NUM_REGIONS] = {
+	"camera_loop",
+	"save_image",
+	"display_raw_image"
+};
+
+static perf_sample_t perf_ring[PERF_RING_SIZE];
+static Xuint32 perf_count;          // samples recorded so far
+static Xuint32 perf_reported;       // value of perf_count at the last summary
+
+// Program the event counters for cache refills, accesses and stalls
+void perf_init(void)
+{
+	Xpm_SetEvents(XPM_CNTRCFG11);
+	perf_count = 0;
+	perf_reported = 0;
+}
+
+// Xpm_GetEventCounters() leaves the counters stopped
+static void perf_read_events(u32 *events)
+{
+	Xpm_GetEventCounters(events);
+	Xpm_EnableEventCounters();
+}
+
+void perf_begin(perf_probe_t *probe)
+{
+	perf_read_events(probe->events);
+	XTime_GetTime(&probe->cycles);
+	probe->ticks = amp_time();
+}
+
+// Record a sample for the work since perf_begin(), and print a summary
+// every PERF_REPORT_INTERVAL samples
+void perf_end(perf_probe_t *probe, int region, Xuint32 pixels)
+{
+	perf_sample_t *sample = &perf_ring[perf_count % PERF_RING_SIZE];
+	u32 events[XPM_CTRCOUNT];
+	XTime cycles;
+	u64 ticks;
+
+	ticks = amp_time();
+	XTime_GetTime(&cycles);
+	perf_read_events(events);
+
+	sample->region = region;
+	sample->ticks = ticks - probe->ticks;
+	sample->cycles = cycles - probe->cycles;
+	sample->pixels = pixels;
+	sample->dcache_refills = events[PERF_EV_DCACHE_REFILL] - probe->events[PERF_EV_DCACHE_REFILL];
+	sample->dcache_accesses = events[PERF_EV_DCACHE_ACCESS] - probe->events[PERF_EV_DCACHE_ACCESS];
+	sample->data_stalls = events[PERF_EV_DATA_STALL] - probe->events[PERF_EV_DATA_STALL];
+	perf_count++;
+
+	if (perf_count - perf_reported >= PERF_REPORT_INTERVAL)
+		perf_summary();
+}
+
+// Averages per region over the samples since the last summary (at most
+// the last PERF_RING_SIZE of them)
+void perf_summary(void)
+{
+	Xuint32 n = perf_count - perf_reported;
+	u64 ticks, cycles, refills, accesses, stalls, pixels;
+	Xuint32 samples, max_ticks, us_per_tick;
+	perf_sample_t *sample;
+	int region;
+	Xuint32 i;
+
+	if (n > PERF_RING_SIZE)
+		n = PERF_RING_SIZE;
+	us_per_tick = AMP_GTIMER_HZ / 1000000;
+
+	for (region = 0; region < PERF_NUM_REGIONS; region++) {
+		ticks = cycles = refills = accesses = stalls = pixels = 0;
+		samples = max_ticks = 0;
+		for (i = perf_count - n; i != perf_count; i++) {
+			sample = &perf_ring[i % PERF_RING_SIZE];
+			if (sample->region != region)
+				continue;
+			samples++;
+			ticks += sample->ticks;
+			cycles += sample->cycles;
+			pixels += sample->pixels;
+			refills += sample->dcache_refills;
+			accesses += sample->dcache_accesses;
+			stalls += sample->data_stalls;
+			if (sample->ticks > max_ticks)
+				max_ticks = sample->ticks;
+		}
+		if (samples == 0)
+			continue;
+
+		xil_printf("%s: %d samples, %d.%03d ms avg, %d.%03d ms max",
+				perf_region_name[region], samples,
+				(Xuint32)(ticks / samples / us_per_tick / 1000), (Xuint32)(ticks / samples / us_per_tick % 1000),
+				max_ticks / us_per_tick / 1000, max_ticks / us_per_tick % 1000);
+		if (pixels)
+			xil_printf(", %d.%02d cycles/pixel", (Xuint32)(cycles / pixels), (Xuint32)(cycles * 100 / pixels % 100));
+		xil_printf("\r\n    core 0 per sample: %d D-cache misses (%d.%02d%% of accesses), %d stall cycles\r\n",
+				(Xuint32)(refills / samples),
+				accesses ? (Xuint32)(refills * 100 / accesses) : 0,
+				accesses ? (Xuint32)(refills * 10000 / accesses % 100) : 0,
+				(Xuint32)(stalls / samples));
+	}
+
+	perf_reported = perf_count;
+}
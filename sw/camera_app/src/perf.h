@@ -0,0 +1,69 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * perf.h - Per-frame instrumentation of the software hot paths.
+ *
+ *
+ * NOTES:
+ * A probe is started before a frame (or image copy) and ended after it.
+ * Each sample records wall time on the global timer, core 0 cycles from
+ * XTime_GetTime() (the PMU cycle counter in this BSP), and the XPM_CNTRCFG11
+ * event counters: D-cache refills, D-cache accesses and data stall
+ * cycles. Samples go into a ring buffer, and a summary per region is
+ * printed every PERF_REPORT_INTERVAL samples.
+ *
+ * The event counters belong to core 0; core 1's share of a frame shows up
+ * only in the wall time and cycle count.
+ *****************************************************************************/
+
+#ifndef __PERF_H__
+#define __PERF_H__
+
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "xpm_counter.h"
+#include "xtime_l.h"
+
+#define PERF_RING_SIZE       128
+#define PERF_REPORT_INTERVAL 100
+
+// Instrumented regions
+#define PERF_CAMERA_LOOP       0
+#define PERF_SAVE_IMAGE        1
+#define PERF_DISPLAY_RAW_IMAGE 2
+#define PERF_NUM_REGIONS       3
+
+// XPM_CNTRCFG11 counter assignment
+#define PERF_EV_DATA_STALL     0
+#define PERF_EV_DCACHE_REFILL  3
+#define PERF_EV_DCACHE_ACCESS  4
+
+struct struct_perf_probe_t {
+	u64 ticks;
+	XTime cycles;
+	u32 events[XPM_CTRCOUNT];
+}; typedef struct struct_perf_probe_t perf_probe_t;
+
+struct struct_perf_sample_t {
+	Xuint8 region;
+	Xuint32 ticks;                // global timer
+	Xuint32 cycles;
+	Xuint32 pixels;
+	Xuint32 dcache_refills;
+	Xuint32 dcache_accesses;
+	Xuint32 data_stalls;          // cycles
+}; typedef struct struct_perf_sample_t perf_sample_t;
+
+// Function prototypes (perf.c)
+void perf_init(void);
+void perf_begin(perf_probe_t *probe);
+void perf_end(perf_probe_t *probe, int region, Xuint32 pixels);
+void perf_summary(void);
+
+#endif // __PERF_H__
@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * raw10.c - Packing S2MM Bayer frames into RAW10 captures and unpacking
+ * them back into 16-bit words for the software ISP.
+ *****************************************************************************/
+
+#include "amp.h"
+#include "raw10.h"
+
+// Sample to and from its 10-bit stored form
+#define RAW10_SHIFT (RAW10_BITS - BAYER_BITS)
+
+void raw10_pack_line(const Xuint16 *src, Xuint8 *dst, int width)
+{
+	Xuint32 p0, p1, p2, p3;
+	int x;
+
+	for (x = 0; x < width; x += 4) {
+		p0 = BAYER_PIXEL(src[x])   << RAW10_SHIFT;
+		p1 = BAYER_PIXEL(src[x+1]) << RAW10_SHIFT;
+		p2 = BAYER_PIXEL(src[x+2]) << RAW10_SHIFT;
+		p3 = BAYER_PIXEL(src[x+3]) << RAW10_SHIFT;
+
+		dst[0] = p0 >> 2;
+		dst[1] = p1 >> 2;
+		dst[2] = p2 >> 2;
+		dst[3] = p3 >> 2;
+		dst[4] = (p0 & 3) | (p1 & 3) << 2 | (p2 & 3) << 4 | (p3 & 3) << 6;
+		dst += 5;
+	}
+}
+
+void raw10_unpack_line(const Xuint8 *src, Xuint16 *dst, int width)
+{
+	Xuint32 lsbs;
+	int x;
+
+	for (x = 0; x < width; x += 4) {
+		lsbs = src[4];
+		dst[x]   = (src[0] << 2 | (lsbs & 3)) >> RAW10_SHIFT;
+		dst[x+1] = (src[1] << 2 | ((lsbs >> 2) & 3)) >> RAW10_SHIFT;
+		dst[x+2] = (src[2] << 2 | ((lsbs >> 4) & 3)) >> RAW10_SHIFT;
+		dst[x+3] = (src[3] << 2 | (lsbs >> 6)) >> RAW10_SHIFT;
+		src += 5;
+	}
+}
+
+// Pack a frame the S2MM channel wrote (or the CPU, the source is cleaned
+// as well as invalidated)
+void raw10_pack_frame(const Xuint16 *src, Xuint8 *dst, int width, int height)
+{
+	int y;
+
+	amp_dcache_flush_range(src, width * height * sizeof(Xuint16));
+	for (y = 0; y < height; y++) {
+		raw10_pack_line(src + y * width, dst + y * RAW10_LINE_BYTES(width), width);
+	}
+}
+
+// Unpack a capture into a frame, and write it back to DDR for the VDMA
+// or the other core
+void raw10_unpack_frame(const Xuint8 *src, Xuint16 *dst, int width, int height)
+{
+	int y;
+
+	for (y = 0; y < height; y++) {
+		raw10_unpack_line(src + y * RAW10_LINE_BYTES(width), dst + y * width, width);
+	}
+	amp_dcache_flush_range(dst, width * height * sizeof(Xuint16));
+}
@@ -0,0 +1,41 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * raw10.h - Packed 10-bit storage for raw Bayer captures.
+ *
+ *
+ * NOTES:
+ * Four samples go into five bytes, laid out as MIPI CSI-2 RAW10: bytes 0-3
+ * hold the top 8 bits of samples 0-3, byte 4 their low 2 bits (sample 0
+ * in bits 1:0). A packed frame is 62.5% of the 16-bit S2MM frame, and
+ * bytes 0-3 of each group on their own are an 8-bit image.
+ *
+ * Samples are stored 10 bits deep whatever BAYER_BITS is (shifted up on
+ * packing and back down on unpacking), so a capture does not depend on
+ * the build that made it. Line widths must be a multiple of 4.
+ *****************************************************************************/
+
+#ifndef __RAW10_H__
+#define __RAW10_H__
+
+#include <xbasic_types.h>
+#include "demosaic.h"
+
+#define RAW10_BITS 10
+
+#define RAW10_LINE_BYTES(width)           ((width) / 4 * 5)
+#define RAW10_FRAME_BYTES(width, height)  (RAW10_LINE_BYTES(width) * (height))
+
+// Function prototypes (raw10.c)
+void raw10_pack_line(const Xuint16 *src, Xuint8 *dst, int width);
+void raw10_unpack_line(const Xuint8 *src, Xuint16 *dst, int width);
+void raw10_pack_frame(const Xuint16 *src, Xuint8 *dst, int width, int height);
+void raw10_unpack_frame(const Xuint8 *src, Xuint16 *dst, int width, int height);
+
+#endif // __RAW10_H__
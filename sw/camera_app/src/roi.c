@@ -0,0 +1,213 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * roi.c - Region-of-interest processing, with the rest of the frame passed
+ * through on the DMA controller.
+ *****************************************************************************/
+
+#include <string.h>
+#include "xil_printf.h"
+#include "xstatus.h"
+#include "roi.h"
+
+void roi_init(roi_set_t *rois, dma2d_t *dma)
+{
+	memset(rois, 0, sizeof(*rois));
+	rois->dma = dma;
+}
+
+// Add a rectangle of a width x height frame. Returns XST_FAILURE if it is
+// misaligned, too small, outside the frame or overlaps one already added.
+int roi_add(roi_set_t *rois, int x, int y, int w, int h, int width, int height)
+{
+	roi_rect_t *r;
+	int i;
+
+	if (rois->num_rects == ROI_MAX_RECTS)
+		return XST_FAILURE;
+	if ((x % ROI_ALIGN) || (w % ROI_ALIGN) || (y & 1) || (h & 1) || w < ROI_ALIGN || h < ROI_MIN_LINES)
+		return XST_FAILURE;
+	if (x < 0 || y < 0 || x + w > width || y + h > height)
+		return XST_FAILURE;
+
+	for (i = 0; i < rois->num_rects; i++) {
+		r = &rois->rect[i];
+		if (x < r->x + r->w && r->x < x + w && y < r->y + r->h && r->y < y + h)
+			return XST_FAILURE;
+	}
+
+	r = &rois->rect[rois->num_rects++];
+	r->x = x;
+	r->y = y;
+	r->w = w;
+	r->h = h;
+	return XST_SUCCESS;
+}
+
+// Cut the part of the frame outside the ROIs into rectangles: bands
+// between consecutive ROI top/bottom edges, then the gaps between the
+// ROIs crossing each band
+static int roi_pieces(roi_set_t *rois, roi_rect_t *piece, int width, int height)
+{
+	int edge[2 * ROI_MAX_RECTS + 2];
+	const roi_rect_t *row[ROI_MAX_RECTS];
+	const roi_rect_t *r;
+	int num_edges = 0, num_row, num_pieces = 0;
+	int i, j, b, x, top, bottom, e;
+
+	edge[num_edges++] = 0;
+	edge[num_edges++] = height;
+	for (i = 0; i < rois->num_rects; i++) {
+		edge[num_edges++] = rois->rect[i].y;
+		edge[num_edges++] = rois->rect[i].y + rois->rect[i].h;
+	}
+
+	// Sort, then drop duplicates
+	for (i = 1; i < num_edges; i++) {
+		e = edge[i];
+		for (j = i; j > 0 && edge[j-1] > e; j--)
+			edge[j] = edge[j-1];
+		edge[j] = e;
+	}
+	for (i = 1, j = 1; i < num_edges; i++) {
+		if (edge[i] != edge[j-1])
+			edge[j++] = edge[i];
+	}
+	num_edges = j;
+
+	for (b = 0; b + 1 < num_edges; b++) {
+		top = edge[b];
+		bottom = edge[b+1];
+
+		// ROIs crossing the band (they span it, as no edge lies inside
+		// it), in x order
+		num_row = 0;
+		for (i = 0; i < rois->num_rects; i++) {
+			r = &rois->rect[i];
+			if (r->y <= top && r->y + r->h >= bottom) {
+				for (j = num_row++; j > 0 && row[j-1]->x > r->x; j--)
+					row[j] = row[j-1];
+				row[j] = r;
+			}
+		}
+
+		x = 0;
+		for (i = 0; i <= num_row; i++) {
+			e = (i < num_row) ? row[i]->x : width;
+			if (e > x) {
+				piece[num_pieces].x = x;
+				piece[num_pieces].y = top;
+				piece[num_pieces].w = e - x;
+				piece[num_pieces].h = bottom - top;
+				num_pieces++;
+			}
+			if (i < num_row)
+				x = row[i]->x + row[i]->w;
+		}
+	}
+
+	return num_pieces;
+}
+
+// Copy a piece on the CPU, as amp_copy_rows() does
+static void roi_copy(const Xuint16 *src, Xuint16 *dst, const roi_rect_t *p, int width)
+{
+	int bytes = p->w * sizeof(Xuint16);
+	int l, offset;
+
+	for (l = p->y; l < p->y + p->h; l++) {
+		offset = l * width + p->x;
+		amp_dcache_flush_range(src + offset, bytes);
+		memcpy(dst + offset, src + offset, bytes);
+		amp_dcache_flush_range(dst + offset, bytes);
+	}
+}
+
+// Process the ROIs of a frame and pass the rest through (see roi.h). The
+// pipeline's pixel count becomes the ROI area. Returns the number of
+// reference mismatches, as amp_isp_frame() does.
+int roi_frame(roi_set_t *rois, isp_pipeline_t *pipe, const Xuint16 *src, Xuint16 *dst, int width, int height)
+{
+	roi_rect_t piece[ROI_MAX_PIECES];
+	Xuint8 on_dma[ROI_MAX_PIECES];
+	int num_pieces = 0, queued = 0, errors = 0, i, offset;
+	Xuint32 pixels = 0;
+	u64 t0, t1, t2;
+
+	t0 = amp_time();
+	if (src != dst) {
+		num_pieces = roi_pieces(rois, piece, width, height);
+		if (rois->dma)
+			dma2d_begin(rois->dma);
+		for (i = 0; i < num_pieces; i++) {
+			offset = piece[i].y * width + piece[i].x;
+			on_dma[i] = rois->dma && dma2d_add(rois->dma, src + offset, dst + offset,
+					piece[i].w * sizeof(Xuint16), piece[i].h,
+					width * sizeof(Xuint16), width * sizeof(Xuint16)) == XST_SUCCESS;
+			queued += on_dma[i];
+		}
+		if (queued && dma2d_start(rois->dma) != XST_SUCCESS) {
+			memset(on_dma, 0, sizeof(on_dma));
+			rois->dma_errors++;
+			queued = 0;
+		}
+	}
+
+	t1 = amp_time();
+	for (i = 0; i < rois->num_rects; i++) {
+		offset = rois->rect[i].y * width + rois->rect[i].x;
+		errors += amp_isp_region(pipe, src + offset, dst + offset, rois->rect[i].w, rois->rect[i].h, width);
+		pixels += (rois->rect[i].w / pipe->bin) * (rois->rect[i].h / pipe->bin);
+	}
+	t2 = amp_time();
+	rois->isp_ticks += t2 - t1;
+
+	// The CPU's share of the pass-through, then the DMA's
+	for (i = 0; i < num_pieces; i++) {
+		if (!on_dma[i])
+			roi_copy(src, dst, &piece[i], width);
+	}
+	if (queued && dma2d_wait(rois->dma) != XST_SUCCESS) {
+		rois->dma_errors++;
+		for (i = 0; i < num_pieces; i++) {
+			if (on_dma[i])
+				roi_copy(src, dst, &piece[i], width);
+		}
+		queued = 0;
+	}
+	rois->dma_pieces += queued;
+	rois->cpu_pieces += num_pieces - queued;
+	rois->copy_ticks += (t1 - t0) + (amp_time() - t2);
+
+	pipe->pixels = pixels;
+	pipe->frames++;
+	rois->frames++;
+	return errors;
+}
+
+void roi_report(roi_set_t *rois, int width, int height)
+{
+	Xuint32 us_per_tick_den = AMP_GTIMER_HZ / 1000000;
+	Xuint32 area = 0;
+	int i;
+
+	if (rois->frames == 0)
+		return;
+
+	for (i = 0; i < rois->num_rects; i++)
+		area += rois->rect[i].w * rois->rect[i].h;
+
+	xil_printf("ROI report: %d ROIs, %d%% of the frame, %d frames\r\n",
+			rois->num_rects, (Xuint32)((u64)area * 100 / (width * height)), rois->frames);
+	xil_printf("  ISP: %d us/frame, pass-through: %d us/frame\r\n",
+			(Xuint32)(rois->isp_ticks / rois->frames / us_per_tick_den),
+			(Xuint32)(rois->copy_ticks / rois->frames / us_per_tick_den));
+	xil_printf("  pieces: %d on the DMA, %d on the CPU, %d failed batches\r\n",
+			rois->dma_pieces, rois->cpu_pieces, rois->dma_errors);
+}
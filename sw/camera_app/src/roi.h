@@ -0,0 +1,71 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * roi.h - Region-of-interest processing: the ISP pipeline runs only on a
+ * few rectangles of the frame, so its CPU time scales with their area.
+ *
+ *
+ * NOTES:
+ * Each rectangle is a separate amp_isp_region() job (split between the
+ * cores like a frame), with its edges mirrored like frame edges.
+ *
+ * In place (src == dst) the rest of the frame is left alone, and the VDMA
+ * shows it as it came from the sensor. Otherwise the rest of the frame is
+ * copied to dst unprocessed: it is cut into rectangles (bands between the
+ * ROI top and bottom edges, then the gaps between ROIs in each band),
+ * which are queued as one PL330 batch and started before the ISP runs, so
+ * the copy overlaps the processing. Pieces the DMA cannot take (no
+ * controller, or a full program) are copied by the CPU, as is everything
+ * if the batch fails.
+ *
+ * ROI x and w are multiples of ROI_ALIGN pixels, so with a frame stride
+ * that is a whole number of cache lines no cache line holds both ROI
+ * pixels (written by the CPU) and pass-through pixels (written by the
+ * DMA). y and h are even, so ROIs cover whole quads.
+ *****************************************************************************/
+
+#ifndef __ROI_H__
+#define __ROI_H__
+
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "isp.h"
+#include "dma2d.h"
+
+#define ROI_MAX_RECTS      4
+#define ROI_ALIGN          16            // pixels: one 32-byte cache line
+#define ROI_MIN_LINES      8             // enough for the apron on both cores
+
+// Rest-of-frame pieces: at most 2 * ROI_MAX_RECTS + 1 bands, each with at
+// most ROI_MAX_RECTS + 1 gaps
+#define ROI_MAX_PIECES     ((2 * ROI_MAX_RECTS + 1) * (ROI_MAX_RECTS + 1))
+
+struct struct_roi_rect_t {
+	int x, y, w, h;
+}; typedef struct struct_roi_rect_t roi_rect_t;
+
+struct struct_roi_set_t {
+	roi_rect_t rect[ROI_MAX_RECTS];
+	int num_rects;
+	dma2d_t *dma;                   // NULL: the CPU copies the rest of the frame
+	Xuint32 frames;
+	Xuint32 dma_pieces;             // pass-through pieces copied by the DMA
+	Xuint32 cpu_pieces;             // ... and by the CPU
+	Xuint32 dma_errors;             // failed batches (copied again by the CPU)
+	u64 isp_ticks;                  // time in the ROI jobs
+	u64 copy_ticks;                 // time copying and waiting for the DMA
+}; typedef struct struct_roi_set_t roi_set_t;
+
+// Function prototypes (roi.c)
+void roi_init(roi_set_t *rois, dma2d_t *dma);
+int roi_add(roi_set_t *rois, int x, int y, int w, int h, int width, int height);
+int roi_frame(roi_set_t *rois, isp_pipeline_t *pipe, const Xuint16 *src, Xuint16 *dst, int width, int height);
+void roi_report(roi_set_t *rois, int width, int height);
+
+#endif // __ROI_H__
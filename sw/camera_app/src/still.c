@@ -0,0 +1,119 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * still.c - One-frame S2MM captures into image stores by retargeting a
+ * VDMA frame store (see still.h).
+ *****************************************************************************/
+
+#include "xil_printf.h"
+#include "xstatus.h"
+#include "still.h"
+
+// The S2MM frame store addresses and sizes of pWriteCfg (vfb_rx_setup())
+int still_init(still_t *still, XAxiVdma *pAxiVdma, const XAxiVdma_DmaSetup *pWriteCfg, int num_stores)
+{
+	int i;
+
+	if (num_stores < 3 || num_stores > XAXIVDMA_MAX_FRAMESTORE)
+		return XST_FAILURE;
+
+	still->vdma = pAxiVdma;
+	still->num_stores = num_stores;
+	for (i = 0; i < num_stores; i++) {
+		still->addr[i] = pWriteCfg->FrameStoreStartAddr[i];
+	}
+	still->vsize = pWriteCfg->VertSizeInput;
+	still->frame_bytes = pWriteCfg->VertSizeInput * pWriteCfg->Stride;
+	still->captures = 0;
+	still->timeouts = 0;
+	still->ticks = 0;
+
+	return XST_SUCCESS;
+}
+
+// New S2MM start addresses only take effect at a frame start after VSIZE
+// has been written
+static void still_set_addr(still_t *still, Xuint32 *addr)
+{
+	XAxiVdma_DmaSetBufferAddr(still->vdma, XAXIVDMA_WRITE, addr);
+	XAxiVdma_WriteReg(still->vdma->BaseAddr, XAXIVDMA_S2MM_ADDR_OFFSET + XAXIVDMA_VSIZE_OFFSET, still->vsize);
+}
+
+// Spin until S2MM is (on != 0) or is not (on == 0) on frame store index.
+// Returns XST_FAILURE after STILL_TIMEOUT.
+static int still_wait(still_t *still, int index, int on)
+{
+	u64 start = amp_time();
+
+	while (((int)XAxiVdma_CurrFrameStore(still->vdma, XAXIVDMA_WRITE) == index) != on) {
+		if (amp_time() - start > STILL_TIMEOUT)
+			return XST_FAILURE;
+	}
+	return XST_SUCCESS;
+}
+
+// Capture the next frame the sensor starts into dst. Returns XST_FAILURE
+// if the S2MM channel never started (or never finished) it; dst then
+// holds nothing usable.
+int still_capture(still_t *still, void *dst)
+{
+	Xuint32 addr[XAXIVDMA_MAX_FRAMESTORE];
+	u64 t0 = amp_time();
+	int s2mm, mm2s, slot, i;
+	int status;
+
+	// Freeze both channels where they are and take a store neither is on
+	s2mm = XAxiVdma_CurrFrameStore(still->vdma, XAXIVDMA_WRITE);
+	mm2s = XAxiVdma_CurrFrameStore(still->vdma, XAXIVDMA_READ);
+	XAxiVdma_StartParking(still->vdma, mm2s, XAXIVDMA_READ);
+	XAxiVdma_StartParking(still->vdma, s2mm, XAXIVDMA_WRITE);
+	for (slot = 0; slot == s2mm || slot == mm2s; slot++)
+		;
+
+	// No dirty line may be evicted on top of the frame
+	amp_dcache_invalidate_range(dst, still->frame_bytes);
+
+	for (i = 0; i < still->num_stores; i++) {
+		addr[i] = still->addr[i];
+	}
+	addr[slot] = (Xuint32)dst;
+	still_set_addr(still, addr);
+
+	// One frame into dst: as soon as S2MM has started on the slot, park
+	// it back, which takes effect at the next frame start
+	XAxiVdma_StartParking(still->vdma, slot, XAXIVDMA_WRITE);
+	status = still_wait(still, slot, 1);
+	XAxiVdma_StartParking(still->vdma, s2mm, XAXIVDMA_WRITE);
+	if (status == XST_SUCCESS)
+		status = still_wait(still, slot, 0);
+
+	still_set_addr(still, still->addr);
+
+	if (status != XST_SUCCESS) {
+		still->timeouts++;
+		return XST_FAILURE;
+	}
+
+	// Drop anything speculatively fetched while the frame came in
+	amp_dcache_invalidate_range(dst, still->frame_bytes);
+
+	still->captures++;
+	still->ticks += amp_time() - t0;
+	return XST_SUCCESS;
+}
+
+void still_report(still_t *still)
+{
+	if (still->captures == 0 && still->timeouts == 0)
+		return;
+
+	xil_printf("Still capture: %d captures, %d timeouts, %d us per capture (no CPU copy)\r\n",
+			still->captures, still->timeouts,
+			still->captures ? (Xuint32)(still->ticks / still->captures / (AMP_GTIMER_HZ / 1000000)) : 0);
+}
@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * still.h - Zero-copy still capture: the S2MM channel writes one frame
+ * straight into an image store.
+ *
+ *
+ * NOTES:
+ * still_capture() parks MM2S on the store it is showing and S2MM on the
+ * store it is writing. It then points a third S2MM frame store at the
+ * image store (XAxiVdma_DmaSetBufferAddr(), committed by rewriting VSIZE)
+ * and parks S2MM on it. When S2MM starts that frame, it is parked back on
+ * its old store, so exactly one frame goes into the image store. Once it
+ * has moved off, the frame store addresses are put back.
+ *
+ * The CPU copies nothing. It only writes a few registers and polls the
+ * park pointer register. The capture ends at the end of the first frame
+ * the sensor starts after the call, so it takes one frame period plus
+ * whatever was left of the frame in flight. Both channels are left
+ * parked; the caller restores circular mode.
+ *
+ * The image store must be as large as a frame store, 8-byte aligned, and
+ * must not be written by the CPU during the capture. Its cache lines are
+ * invalidated before and after.
+ *
+ * Needs three frame stores (XPAR_AXIVDMA_0_NUM_FSTORES): one for each
+ * channel and one to redirect.
+ *****************************************************************************/
+
+#ifndef __STILL_H__
+#define __STILL_H__
+
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "xaxivdma.h"
+#include "amp.h"
+
+// Longest wait for S2MM to start, or to finish, the captured frame
+// (global timer ticks; three frames at 60 Hz)
+#define STILL_TIMEOUT (AMP_GTIMER_HZ / 20)
+
+struct struct_still_t {
+	XAxiVdma *vdma;
+	Xuint32 addr[XAXIVDMA_MAX_FRAMESTORE];   // the S2MM frame stores
+	int num_stores;
+	Xuint32 vsize;
+	Xuint32 frame_bytes;
+	Xuint32 captures;
+	Xuint32 timeouts;
+	u64 ticks;                      // call to frame in the image store
+}; typedef struct struct_still_t still_t;
+
+// Function prototypes (still.c)
+int still_init(still_t *still, XAxiVdma *pAxiVdma, const XAxiVdma_DmaSetup *pWriteCfg, int num_stores);
+int still_capture(still_t *still, void *dst);
+void still_report(still_t *still);
+
+#endif // __STILL_H__
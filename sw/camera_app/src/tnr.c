@@ -0,0 +1,215 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * tnr.c - Temporal noise reduction stage (scalar and NEON). The NEON
+ * kernel filters 8 pixel pairs per iteration with the same integer
+ * arithmetic as the scalar one, so both give exactly the same words.
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "xil_printf.h"
+#include "tnr.h"
+
+#if TNR_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+// alpha_min is the weight of a still pixel's new value (Q8); the weight
+// rises linearly from noise to motion luma steps of difference, where it
+// reaches 256. An empty history.
+void tnr_init(tnr_t *tnr, Xuint16 *history, int alpha_min, int noise, int motion)
+{
+	int d;
+
+	if (motion <= noise)
+		motion = noise + 1;
+
+	tnr->history = history;
+	tnr->alpha_min = alpha_min;
+	tnr->noise = noise;
+	tnr->motion = motion;
+	tnr->slope = (TNR_ALPHA_ONE - alpha_min + motion - noise - 1) / (motion - noise);
+	for (d = 0; d < 256; d++) {
+		tnr->alpha[d] = tnr_alpha(tnr, d);
+	}
+	tnr_reset(tnr);
+}
+
+// Forget the history, and the counts
+void tnr_reset(tnr_t *tnr)
+{
+	int cpu;
+
+	tnr->frames = 0;
+	for (cpu = 0; cpu < AMP_NUM_CPUS; cpu++) {
+		tnr->moving[cpu] = 0;
+		tnr->pixels[cpu] = 0;
+	}
+}
+
+// Weight of the new value for a luma difference of diff
+int tnr_alpha(const tnr_t *tnr, int diff)
+{
+	int a;
+
+	if (diff > tnr->motion)
+		diff = tnr->motion;
+	a = tnr->alpha_min + ((diff > tnr->noise) ? (diff - tnr->noise) * tnr->slope : 0);
+	return (a < TNR_ALPHA_ONE) ? a : TNR_ALPHA_ONE;
+}
+
+static inline int tnr_blend(int cur, int hist, int a)
+{
+	return (cur * a + hist * (TNR_ALPHA_ONE - a) + 128) >> 8;
+}
+
+// Filter words [x_start, x_end) of a 4:2:2 line (x_start even) against
+// the history, writing the result to both
+void tnr_filter_line_ref(const tnr_t *tnr, Xuint16 *out, Xuint16 *hist, int x_start, int x_end, Xuint32 *moving)
+{
+	Xuint32 c, h;
+	int a0, a1, ac;
+	int x;
+
+	for (x = x_start; x < x_end; x += 2) {
+		c = *(csc_pair_t *)(out + x);
+		h = *(csc_pair_t *)(hist + x);
+
+		a0 = tnr->alpha[abs((int)(c & 0xFF) - (int)(h & 0xFF))];
+		a1 = tnr->alpha[abs((int)((c >> 16) & 0xFF) - (int)((h >> 16) & 0xFF))];
+		ac = (a0 > a1) ? a0 : a1;
+		*moving += (a0 == TNR_ALPHA_ONE) + (a1 == TNR_ALPHA_ONE);
+
+		c = csc_pack_pair(tnr_blend(c & 0xFF, h & 0xFF, a0),
+				tnr_blend((c >> 16) & 0xFF, (h >> 16) & 0xFF, a1),
+				tnr_blend((c >> 8) & 0xFF, (h >> 8) & 0xFF, ac),
+				tnr_blend(c >> 24, h >> 24, ac));
+		*(csc_pair_t *)(out + x) = c;
+		*(csc_pair_t *)(hist + x) = c;
+	}
+}
+
+#if TNR_HAVE_NEON
+
+// tnr_alpha() on 8 luma differences
+static inline uint16x8_t tnr_alpha_neon(const tnr_t *tnr, uint16x8_t diff)
+{
+	uint16x8_t steps = vminq_u16(vqsubq_u16(diff, vdupq_n_u16(tnr->noise)), vdupq_n_u16(tnr->motion - tnr->noise));
+	uint16x8_t a = vmlaq_n_u16(vdupq_n_u16(tnr->alpha_min), steps, tnr->slope);
+
+	return vminq_u16(a, vdupq_n_u16(TNR_ALPHA_ONE));
+}
+
+// tnr_blend() on 8 lanes; neither the products' sum nor the rounding
+// leaves 16 bits
+static inline uint16x8_t tnr_blend_neon(uint16x8_t cur, uint16x8_t hist, uint16x8_t a)
+{
+	uint16x8_t sum = vmulq_u16(cur, a);
+
+	sum = vmlaq_u16(sum, hist, vsubq_u16(vdupq_n_u16(TNR_ALPHA_ONE), a));
+	return vrshrq_n_u16(sum, 8);
+}
+
+void tnr_filter_line_neon(const tnr_t *tnr, Xuint16 *out, Xuint16 *hist, int width, Xuint32 *moving)
+{
+	const uint16x8_t low = vdupq_n_u16(0xFF);
+	uint16x8_t count = vdupq_n_u16(0);
+	uint16_t lanes[8];
+	int x, i;
+
+	// vld2 splits the line into its Cb/Y0 and Cr/Y1 words; at most 240
+	// moving pixels per lane for a 1920-word line, so the counts fit
+	for (x = 0; x + 16 <= width; x += 16) {
+		uint16x8x2_t c = vld2q_u16(out + x);
+		uint16x8x2_t h = vld2q_u16(hist + x);
+		uint16x8_t Y0c = vandq_u16(c.val[0], low), Y0h = vandq_u16(h.val[0], low);
+		uint16x8_t Y1c = vandq_u16(c.val[1], low), Y1h = vandq_u16(h.val[1], low);
+		uint16x8_t a0 = tnr_alpha_neon(tnr, vabdq_u16(Y0c, Y0h));
+		uint16x8_t a1 = tnr_alpha_neon(tnr, vabdq_u16(Y1c, Y1h));
+		uint16x8_t ac = vmaxq_u16(a0, a1);
+		uint16x8x2_t o;
+
+		// a >> 8 is 1 for a moving pixel (a = 256) and 0 otherwise
+		count = vaddq_u16(count, vaddq_u16(vshrq_n_u16(a0, 8), vshrq_n_u16(a1, 8)));
+
+		o.val[0] = vsliq_n_u16(tnr_blend_neon(Y0c, Y0h, a0),
+				tnr_blend_neon(vshrq_n_u16(c.val[0], 8), vshrq_n_u16(h.val[0], 8), ac), 8);
+		o.val[1] = vsliq_n_u16(tnr_blend_neon(Y1c, Y1h, a1),
+				tnr_blend_neon(vshrq_n_u16(c.val[1], 8), vshrq_n_u16(h.val[1], 8), ac), 8);
+		vst2q_u16(out + x, o);
+		vst2q_u16(hist + x, o);
+	}
+
+	vst1q_u16(lanes, count);
+	for (i = 0; i < 8; i++) {
+		*moving += lanes[i];
+	}
+
+	tnr_filter_line_ref(tnr, out, hist, x, width, moving);
+}
+
+#endif // TNR_HAVE_NEON
+
+// Fastest kernel available for this build
+void tnr_filter_line(const tnr_t *tnr, Xuint16 *out, Xuint16 *hist, int width, Xuint32 *moving)
+{
+#if TNR_HAVE_NEON
+	tnr_filter_line_neon(tnr, out, hist, width, moving);
+#else
+	tnr_filter_line_ref(tnr, out, hist, 0, width, moving);
+#endif
+}
+
+// Runs after the 4:2:2 output lines are complete; the history lines sit
+// at the same place in the history frame as the output lines in theirs.
+// On the first frame after tnr_reset() the output only seeds the history.
+int tnr_stage(void *ctx, isp_line_t *line)
+{
+	tnr_t *tnr = (tnr_t *)ctx;
+	Xuint16 *hist;
+	int l;
+
+	for (l = 0; l < line->out_lines; l++) {
+		hist = tnr->history + (line->out_y + l) * line->stride;
+		if (tnr->frames == 0) {
+			memcpy(hist, line->out[l], line->out_width * sizeof(Xuint16));
+		} else {
+			tnr_filter_line(tnr, line->out[l], hist, line->out_width, &tnr->moving[line->cpu]);
+			tnr->pixels[line->cpu] += line->out_width;
+		}
+	}
+
+	return 0;
+}
+
+// Core 0, between frames
+void tnr_frame_done(tnr_t *tnr)
+{
+	tnr->frames++;
+}
+
+void tnr_report(tnr_t *tnr)
+{
+	u64 moving = 0, pixels = 0;
+	int cpu;
+
+	for (cpu = 0; cpu < AMP_NUM_CPUS; cpu++) {
+		moving += tnr->moving[cpu];
+		pixels += tnr->pixels[cpu];
+	}
+
+	xil_printf("TNR: %d frames, still weight %d/256, noise %d, motion %d levels; ",
+			tnr->frames, tnr->alpha_min, tnr->noise, tnr->motion);
+	if (pixels)
+		xil_printf("%d.%d%% of the pixels moving\r\n", (Xuint32)(moving * 100 / pixels),
+				(Xuint32)(moving * 1000 / pixels % 10));
+	else
+		xil_printf("nothing filtered\r\n");
+}
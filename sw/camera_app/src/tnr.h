@@ -0,0 +1,85 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * tnr.h - Motion-adaptive temporal noise reduction stage for the software
+ * ISP.
+ *
+ *
+ * NOTES:
+ * A recursive filter on the 4:2:2 output: each pixel becomes
+ *    out = (a * cur + (256 - a) * hist + 128) >> 8
+ * where hist is the filtered pixel of the previous frame and a (Q8) the
+ * weight of the new one. a depends on how far the luma moved since the
+ * last frame:
+ *    |cur Y - hist Y| <= noise     a = alpha_min (strongest filtering)
+ *    rising by slope per level above that, up to
+ *    |cur Y - hist Y| >= motion    a = 256 (moving, passed through)
+ * so still areas average over several frames while anything that moves
+ * keeps no trail. The pair's Cb/Cr take the larger of its two weights.
+ *
+ * The history is a frame of 4:2:2 words at the output stride, kept in a
+ * buffer the CPU alone touches (a spare frame store past the ones the
+ * VDMA uses). The stage goes after the 4:2:2 (or fused) stage, and reads
+ * and writes only the two history lines of the current quad row, so the
+ * streaming pass touches one extra line set and never a whole frame.
+ * Each core keeps to its own half of the frame, and of the history.
+ *
+ * Call tnr_frame_done() after every frame, and tnr_reset() whenever the
+ * history no longer matches the picture (mode change, sensor reset): the
+ * next frame is then copied to the history unfiltered.
+ *
+ * Defaults are in 8-bit output levels; the ISP output is 8 bits whatever
+ * BAYER_BITS is.
+ *****************************************************************************/
+
+#ifndef __TNR_H__
+#define __TNR_H__
+
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "isp.h"
+#include "amp.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define TNR_HAVE_NEON 1
+#else
+#define TNR_HAVE_NEON 0
+#endif
+
+#define TNR_ALPHA_ONE      256          // a = 1.0
+#define TNR_ALPHA_MIN      64           // a quarter of each new still frame
+#define TNR_NOISE_LEVEL    4            // luma steps taken to be noise
+#define TNR_MOTION_LEVEL   20           // luma steps taken to be motion
+
+struct struct_tnr_t {
+	Xuint16 *history;               // filtered previous frame, 4:2:2
+	int alpha_min;
+	int noise;
+	int motion;
+	int slope;                      // a per luma step above noise
+	Xuint16 alpha[256];             // a for each luma difference (scalar kernel)
+	Xuint32 frames;                 // into the history since tnr_reset()
+	Xuint32 moving[AMP_NUM_CPUS];   // pixels passed through (a = 256)
+	Xuint32 pixels[AMP_NUM_CPUS];   // pixels filtered
+}; typedef struct struct_tnr_t tnr_t;
+
+// Function prototypes (tnr.c)
+void tnr_init(tnr_t *tnr, Xuint16 *history, int alpha_min, int noise, int motion);
+void tnr_reset(tnr_t *tnr);
+int tnr_alpha(const tnr_t *tnr, int diff);
+void tnr_filter_line_ref(const tnr_t *tnr, Xuint16 *out, Xuint16 *hist, int x_start, int x_end, Xuint32 *moving);
+#if TNR_HAVE_NEON
+void tnr_filter_line_neon(const tnr_t *tnr, Xuint16 *out, Xuint16 *hist, int width, Xuint32 *moving);
+#endif
+void tnr_filter_line(const tnr_t *tnr, Xuint16 *out, Xuint16 *hist, int width, Xuint32 *moving);
+int tnr_stage(void *ctx, isp_line_t *line);
+void tnr_frame_done(tnr_t *tnr);
+void tnr_report(tnr_t *tnr);
+
+#endif // __TNR_H__
@@ -0,0 +1,323 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * tone.c - Tone curve presets, the double-buffered LUT stage and the UART
+ * curve upload.
+ *
+ * The application is linked without libm, so the presets are built with
+ * small log2/exp2 approximations (relative error around 1e-5, far below
+ * one 8-bit output level).
+ *****************************************************************************/
+
+#include "xil_printf.h"
+#include "xstatus.h"
+#include "xuartps_hw.h"
+#include "bayer2ycbcr.h"
+#include "tone.h"
+
+static const char *tone_preset_names[TONE_NUM_PRESETS] = { "linear", "sRGB", "BT.709", "log" };
+
+union tone_float {
+	float f;
+	Xuint32 u;
+};
+
+// log2(x) for x > 0: exponent plus ln(m) / ln(2) from the atanh series
+static float tone_log2(float x)
+{
+	union tone_float v;
+	float t, t2, ln;
+	int e;
+
+	v.f = x;
+	e = (int)((v.u >> 23) & 0xFF) - 127;
+	v.u = (v.u & 0x7FFFFF) | 0x3F800000;            // mantissa, 1 .. 2
+	t = (v.f - 1.0f) / (v.f + 1.0f);
+	t2 = t * t;
+	ln = 2.0f * t * (1.0f + t2 * (1.0f / 3 + t2 * (1.0f / 5 + t2 * (1.0f / 7 + t2 / 9))));
+	return e + ln * 1.44269504f;
+}
+
+// 2^y: 2^floor(y) in the exponent, the rest from the Taylor series
+static float tone_exp2(float y)
+{
+	union tone_float v;
+	float f, r, term;
+	int i, n;
+
+	i = (int)y;
+	if (y < i)
+		i--;
+	if (i < -126)
+		return 0.0f;
+	f = (y - i) * 0.69314718f;
+	r = 1.0f;
+	term = 1.0f;
+	for (n = 1; n < 9; n++) {
+		term *= f / n;
+		r += term;
+	}
+	v.f = r;
+	v.u += (Xuint32)i << 23;
+	return v.f;
+}
+
+static float tone_pow(float x, float p)
+{
+	return (x <= 0.0f) ? 0.0f : tone_exp2(p * tone_log2(x));
+}
+
+// Output level (0..1) of a preset for linear light x (0..1)
+static float tone_curve(int preset, float x)
+{
+	switch (preset) {
+	case TONE_PRESET_SRGB:
+		return (x <= 0.0031308f) ? 12.92f * x : 1.055f * tone_pow(x, 1.0f / 2.4f) - 0.055f;
+	case TONE_PRESET_BT709:
+		return (x < 0.018f) ? 4.5f * x : 1.099f * tone_pow(x, 0.45f) - 0.099f;
+	case TONE_PRESET_LOG:
+		return tone_log2(1.0f + TONE_LOG_K * x) / tone_log2(1.0f + TONE_LOG_K);
+	default:
+		return x;
+	}
+}
+
+void tone_build_preset(isp_gamma_t *lut, int preset)
+{
+	int i, v;
+
+	if (preset == TONE_PRESET_LINEAR) {
+		isp_tone_linear(lut);
+		return;
+	}
+	for (i = 0; i < ISP_TONE_LUT_SIZE; i++) {
+		v = (int)(tone_curve(preset, (float)i / BAYER_MAX) * 255.0f + 0.5f);
+		lut->lut[i] = (v < 0) ? 0 : (v > 255) ? 255 : v;
+	}
+}
+
+// csc is the converter for tone_stage_bayer2ycbcr(), NULL if the tone
+// stage is used
+void tone_init(tone_t *tone, int preset, const csc_coef_t *csc)
+{
+	tone_build_preset(&tone->lut[0], preset);
+	tone->active = 0;
+	tone->pending = 0;
+	tone->preset = preset;
+	tone->csc = csc;
+	tone->swaps = 0;
+	tone->intc = NULL;
+	tone->rx_head = tone->rx_tail = 0;
+	tone->rx_lost = 0;
+	tone->rx_resyncs = 0;
+	tone->rx_state = TONE_RX_IDLE;
+}
+
+// The LUT that is not in use, to build a curve in
+isp_gamma_t *tone_back(tone_t *tone)
+{
+	return &tone->lut[!tone->active];
+}
+
+// The back LUT holds a complete curve: use it from the next frame on
+void tone_commit(tone_t *tone, int preset)
+{
+	tone->preset = preset;
+	tone->pending = 1;
+}
+
+int tone_load_preset(tone_t *tone, int preset)
+{
+	if (preset < 0 || preset >= TONE_NUM_PRESETS)
+		return XST_FAILURE;
+
+	tone->pending = 0;
+	tone_build_preset(tone_back(tone), preset);
+	tone_commit(tone, preset);
+	return XST_SUCCESS;
+}
+
+// Frame boundary (core 0, both cores idle): make a pending curve active.
+// Returns 1 if the curve changed.
+int tone_swap(tone_t *tone)
+{
+	if (!tone->pending)
+		return 0;
+
+	tone->active = !tone->active;
+	tone->pending = 0;
+	tone->swaps++;
+	return 1;
+}
+
+// Tone LUT on the RGB lines, ctx is the tone_t
+int tone_stage(void *ctx, isp_line_t *line)
+{
+	tone_t *tone = (tone_t *)ctx;
+
+	return isp_stage_gamma(&tone->lut[tone->active], line);
+}
+
+// Fused Bayer to 4:2:2 through the tone LUT, ctx is the tone_t
+int tone_stage_bayer2ycbcr(void *ctx, isp_line_t *line)
+{
+	tone_t *tone = (tone_t *)ctx;
+
+	isp_bayer2ycbcr_row(line, tone->csc, tone->lut[tone->active].lut);
+	return 0;
+}
+
+// As tone_stage_bayer2ycbcr, checked against the scalar reference
+int tone_stage_bayer2ycbcr_verify(void *ctx, isp_line_t *line)
+{
+	tone_t *tone = (tone_t *)ctx;
+
+	return bayer2ycbcr_quad_row_compare(tone->csc, tone->lut[tone->active].lut, line->above, line->even, line->odd, line->below,
+			line->out[0], line->out[1], line->width);
+}
+
+static void tone_rx_byte(tone_t *tone, Xuint8 c)
+{
+	isp_gamma_t *back = tone_back(tone);
+
+	switch (tone->rx_state) {
+	case TONE_RX_IDLE:
+		if (c == 'p') {
+			tone->rx_count = 0;
+			tone->rx_state = TONE_RX_PRESET;
+		} else if (c == 'U') {
+			// The back LUT is about to be overwritten
+			tone->pending = 0;
+			tone->rx_count = 0;
+			tone->rx_sum = 0;
+			tone->rx_state = TONE_RX_CURVE;
+		}
+		break;
+	case TONE_RX_PRESET:
+		if (tone_load_preset(tone, c - '0') == XST_SUCCESS)
+			xil_printf("Tone curve: %s\r\n", tone_preset_names[tone->preset]);
+		else
+			xil_printf("Tone curve: no preset %c\r\n", c);
+		tone->rx_state = TONE_RX_IDLE;
+		break;
+	case TONE_RX_CURVE:
+		back->lut[tone->rx_count++] = c;
+		tone->rx_sum += c;
+		if (tone->rx_count == ISP_TONE_LUT_SIZE)
+			tone->rx_state = TONE_RX_SUM;
+		break;
+	case TONE_RX_SUM:
+		if (c == tone->rx_sum) {
+			tone_commit(tone, -1);
+			xil_printf("Tone curve: uploaded, %d levels\r\n", ISP_TONE_LUT_SIZE);
+		} else {
+			xil_printf("Tone curve: checksum %02x, expected %02x, curve dropped\r\n", c, tone->rx_sum);
+		}
+		tone->rx_state = TONE_RX_IDLE;
+		break;
+	}
+}
+
+// Everything in the RX FIFO into the ring
+static void tone_uart_drain(tone_t *tone)
+{
+	Xuint8 c;
+
+	while (XUartPs_IsReceiveData(TONE_UART_BASE)) {
+		c = (Xuint8)XUartPs_ReadReg(TONE_UART_BASE, XUARTPS_FIFO_OFFSET);
+		if (tone->rx_tail - tone->rx_head == TONE_RX_RING_LEN) {
+			tone->rx_lost++;
+			continue;
+		}
+		tone->rx_ring[tone->rx_tail % TONE_RX_RING_LEN] = c;
+		tone->rx_tail++;
+	}
+}
+
+static void tone_uart_handler(void *CallBackRef)
+{
+	tone_t *tone = (tone_t *)CallBackRef;
+	Xuint32 isr;
+
+	isr = XUartPs_ReadReg(TONE_UART_BASE, XUARTPS_ISR_OFFSET) & XUartPs_ReadReg(TONE_UART_BASE, XUARTPS_IMR_OFFSET);
+	XUartPs_WriteReg(TONE_UART_BASE, XUARTPS_ISR_OFFSET, isr);
+	if (isr & XUARTPS_IXR_OVER)
+		tone->rx_lost++;
+
+	tone_uart_drain(tone);
+
+	// The timeout only counts again from the next byte
+	if (isr & XUARTPS_IXR_TOUT)
+		XUartPs_WriteReg(TONE_UART_BASE, XUARTPS_CR_OFFSET,
+				XUartPs_ReadReg(TONE_UART_BASE, XUARTPS_CR_OFFSET) | XUARTPS_CR_TORST);
+}
+
+// Receive from the RX interrupt. The GIC must have been set up
+// (intc_init()); with pIntc NULL the FIFO is left to tone_uart_poll().
+int tone_uart_init(tone_t *tone, XScuGic *pIntc)
+{
+	int Status;
+
+	tone->rx_last = amp_time();
+	if (!pIntc)
+		return XST_SUCCESS;
+
+	XUartPs_WriteReg(TONE_UART_BASE, XUARTPS_IDR_OFFSET, XUARTPS_IXR_MASK);
+	XUartPs_WriteReg(TONE_UART_BASE, XUARTPS_ISR_OFFSET, XUARTPS_IXR_MASK);
+	XUartPs_WriteReg(TONE_UART_BASE, XUARTPS_RXWM_OFFSET, TONE_RX_TRIGGER);
+	XUartPs_WriteReg(TONE_UART_BASE, XUARTPS_RXTOUT_OFFSET, TONE_RX_IDLE_BAUDS / 4);
+
+	Status = XScuGic_Connect(pIntc, TONE_UART_INTR_ID, (Xil_InterruptHandler)tone_uart_handler, tone);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Connecting the UART interrupt failed %d, curve uploads polled\r\n", Status);
+		return Status;
+	}
+	tone->intc = pIntc;
+	XScuGic_Enable(pIntc, TONE_UART_INTR_ID);
+
+	XUartPs_WriteReg(TONE_UART_BASE, XUARTPS_CR_OFFSET,
+			XUartPs_ReadReg(TONE_UART_BASE, XUARTPS_CR_OFFSET) | XUARTPS_CR_TORST);
+	XUartPs_WriteReg(TONE_UART_BASE, XUARTPS_IER_OFFSET, XUARTPS_IXR_RXOVR | XUARTPS_IXR_TOUT | XUARTPS_IXR_OVER);
+	return XST_SUCCESS;
+}
+
+// Parse whatever has been received since the last call, without waiting
+// for more. A command left unfinished for TONE_RX_TIMEOUT_MS is dropped.
+void tone_uart_poll(tone_t *tone)
+{
+	u64 now = amp_time();
+
+	if (!tone->intc)
+		tone_uart_drain(tone);
+
+	if (tone->rx_head == tone->rx_tail) {
+		if (tone->rx_state != TONE_RX_IDLE &&
+				now - tone->rx_last > (u64)TONE_RX_TIMEOUT_MS * (AMP_GTIMER_HZ / 1000)) {
+			xil_printf("Tone curve: nothing for %d ms after byte %d, command dropped\r\n",
+					TONE_RX_TIMEOUT_MS, tone->rx_count);
+			tone->rx_state = TONE_RX_IDLE;
+			tone->rx_resyncs++;
+		}
+		return;
+	}
+
+	while (tone->rx_head != tone->rx_tail) {
+		tone_rx_byte(tone, tone->rx_ring[tone->rx_head % TONE_RX_RING_LEN]);
+		tone->rx_head++;
+	}
+	tone->rx_last = now;
+}
+
+void tone_report(tone_t *tone)
+{
+	xil_printf("Tone curve: %s, %d swaps, %d-entry LUTs\r\n",
+			(tone->preset < 0) ? "uploaded" : tone_preset_names[tone->preset], tone->swaps, ISP_TONE_LUT_SIZE);
+	if (tone->rx_lost || tone->rx_resyncs)
+		xil_printf("Tone curve UART: %d bytes lost, %d commands dropped part way\r\n", tone->rx_lost, tone->rx_resyncs);
+}
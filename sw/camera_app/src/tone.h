@@ -0,0 +1,109 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * tone.h - Tone curve stage for the software ISP, with double-buffered
+ * LUTs that can be replaced while frames are being processed.
+ *
+ *
+ * NOTES:
+ * The stage maps sensor-depth RGB (ISP_TONE_LUT_SIZE levels, 1024 at 10
+ * bits) to the 8 bits the CSC takes, through the active one of two LUTs.
+ * A new curve is built in the other LUT, from a preset or uploaded over
+ * the UART, at any time, and marked pending; tone_swap(), called on core
+ * 0 between frames, makes it active. Neither core ever waits, and a frame
+ * is never processed with two curves.
+ *
+ * tone_stage_bayer2ycbcr() is the fused bayer2ycbcr stage with the active
+ * LUT between its demosaic and its CSC, for pipelines without RGB lines;
+ * the converter given to tone_init() takes 8-bit RGB. White balance gains
+ * set as that converter's input gains (awb.h) then come after the curve.
+ *
+ * UART upload:
+ *    'p' <digit>             load preset <digit> (TONE_PRESET_*)
+ *    'U' <N bytes> <sum>     load a curve: N = ISP_TONE_LUT_SIZE output
+ *                            levels, then the low byte of their sum
+ *
+ * A curve upload is longer than the 64-byte RX FIFO (5.6 ms at 115200
+ * baud), and the FIFO is only looked at once a frame, so the RX interrupt
+ * (FIFO trigger level or RX timeout) drains it into a ring that holds a
+ * whole upload; tone_uart_poll() parses the ring between frames. Without
+ * an interrupt controller the FIFO is drained from tone_uart_poll() and
+ * uploads need a frame rate of about 180 Hz to survive: use presets.
+ *
+ * A command that stops arriving for TONE_RX_TIMEOUT_MS is dropped and the
+ * parser goes back to waiting for 'p' or 'U', so a lost or extra byte
+ * costs one upload, not every one after it.
+ *****************************************************************************/
+
+#ifndef __TONE_H__
+#define __TONE_H__
+
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include <xparameters.h>
+#include "xscugic.h"
+#include "isp.h"
+
+#define TONE_PRESET_LINEAR 0
+#define TONE_PRESET_SRGB   1
+#define TONE_PRESET_BT709  2
+#define TONE_PRESET_LOG    3
+#define TONE_NUM_PRESETS   4
+
+// The log curve is log(1 + k x) / log(1 + k) for linear x in 0..1
+#define TONE_LOG_K 64
+
+#define TONE_UART_BASE      STDIN_BASEADDRESS
+#define TONE_UART_INTR_ID   XPAR_PS7_UART_1_INTR    // the one at STDIN_BASEADDRESS
+#define TONE_UART_FIFO      64          // RX FIFO depth
+#define TONE_RX_TRIGGER     32          // interrupt at this many bytes in the FIFO
+#define TONE_RX_IDLE_BAUDS  40          // or this many bit times after the last (x4)
+#define TONE_RX_RING_LEN    2048        // a power of two, above one upload
+#define TONE_RX_TIMEOUT_MS  200         // silence that drops a partial command
+
+// Upload parser states
+#define TONE_RX_IDLE   0
+#define TONE_RX_PRESET 1
+#define TONE_RX_CURVE  2
+#define TONE_RX_SUM    3
+
+struct struct_tone_t {
+	isp_gamma_t lut[2];
+	volatile int active;            // LUT the stage reads
+	volatile int pending;           // the other LUT holds a new curve
+	int preset;                     // of the pending/active curve, -1 if uploaded
+	const csc_coef_t *csc;          // converter of tone_stage_bayer2ycbcr()
+	Xuint32 swaps;
+	XScuGic *intc;                  // NULL: the FIFO is drained by tone_uart_poll()
+	Xuint8 rx_ring[TONE_RX_RING_LEN];
+	volatile Xuint32 rx_head;       // next byte to parse
+	volatile Xuint32 rx_tail;       // next free slot
+	volatile Xuint32 rx_lost;       // ring full or FIFO overrun
+	u64 rx_last;                    // global timer, last byte parsed
+	Xuint32 rx_resyncs;             // commands dropped part way
+	int rx_state;
+	int rx_count;
+	Xuint8 rx_sum;
+}; typedef struct struct_tone_t tone_t;
+
+// Function prototypes (tone.c)
+void tone_build_preset(isp_gamma_t *lut, int preset);
+void tone_init(tone_t *tone, int preset, const csc_coef_t *csc);
+isp_gamma_t *tone_back(tone_t *tone);
+void tone_commit(tone_t *tone, int preset);
+int tone_load_preset(tone_t *tone, int preset);
+int tone_swap(tone_t *tone);
+int tone_stage(void *ctx, isp_line_t *line);
+int tone_stage_bayer2ycbcr(void *ctx, isp_line_t *line);
+int tone_stage_bayer2ycbcr_verify(void *ctx, isp_line_t *line);
+int tone_uart_init(tone_t *tone, XScuGic *pIntc);
+void tone_uart_poll(tone_t *tone);
+void tone_report(tone_t *tone);
+
+#endif // __TONE_H__
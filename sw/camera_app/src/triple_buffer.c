@@ -0,0 +1,116 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * triple_buffer.c - Frame store rotation for the software processing loop,
+ * built on the VDMA park pointers.
+ *****************************************************************************/
+
+#include "xil_printf.h"
+#include "xstatus.h"
+#include "triple_buffer.h"
+
+// Spin until a channel is no longer working on frame store index
+static void tbuf_wait_off(tbuf_t *tbuf, int index, u16 Direction)
+{
+	u64 start = amp_time();
+
+	while (XAxiVdma_CurrFrameStore(tbuf->vdma, Direction) == index) {
+		if (amp_time() - start > TBUF_TIMEOUT) {
+			tbuf->timeouts++;
+			return;
+		}
+	}
+}
+
+// Park S2MM on store 0 and MM2S on store 1
+int tbuf_init(tbuf_t *tbuf, XAxiVdma *pAxiVdma, const XAxiVdma_DmaSetup *pWriteCfg)
+{
+	int i;
+
+	tbuf->vdma = pAxiVdma;
+	for (i = 0; i < TBUF_NUM_FRAMES; i++) {
+		tbuf->addr[i] = pWriteCfg->FrameStoreStartAddr[i];
+	}
+	tbuf->capture = 0;
+	tbuf->display = 1;
+	tbuf->work = 2;
+	tbuf->rotations = 0;
+	tbuf->timeouts = 0;
+	tbuf->rotate_ticks = 0;
+	tbuf->sync_ticks = 0;
+
+	if (XAxiVdma_StartParking(pAxiVdma, tbuf->capture, XAXIVDMA_WRITE) != XST_SUCCESS)
+		return XST_FAILURE;
+	if (XAxiVdma_StartParking(pAxiVdma, tbuf->display, XAXIVDMA_READ) != XST_SUCCESS)
+		return XST_FAILURE;
+
+	return XST_SUCCESS;
+}
+
+// Called once the capture store holds a complete frame: move S2MM on to
+// the free store and hand the completed one to the CPU. Returns a pointer
+// to the frame to convert (in place).
+Xuint16 *tbuf_acquire(tbuf_t *tbuf)
+{
+	int free_store = (0 + 1 + 2) - tbuf->capture - tbuf->display;
+	u64 t0, t1, t2;
+
+	// MM2S switches stores at its next frame start, so it may still be
+	// scanning out the store it was just moved off
+	t0 = amp_time();
+	tbuf_wait_off(tbuf, free_store, XAXIVDMA_READ);
+	t1 = amp_time();
+
+	tbuf->work = tbuf->capture;
+	tbuf->capture = free_store;
+	XAxiVdma_StartParking(tbuf->vdma, tbuf->capture, XAXIVDMA_WRITE);
+	t2 = amp_time();
+
+	// Likewise S2MM: once it has started on the new store, the completed
+	// one can no longer change under the CPU
+	tbuf_wait_off(tbuf, tbuf->work, XAXIVDMA_WRITE);
+
+	tbuf->rotate_ticks += t2 - t1;
+	tbuf->sync_ticks += (t1 - t0) + (amp_time() - t2);
+
+	return (Xuint16 *)tbuf->addr[tbuf->work];
+}
+
+// The converted frame is complete in memory: put it on screen
+void tbuf_present(tbuf_t *tbuf)
+{
+	u64 t0 = amp_time();
+
+	tbuf->display = tbuf->work;
+	XAxiVdma_StartParking(tbuf->vdma, tbuf->display, XAXIVDMA_READ);
+
+	tbuf->rotate_ticks += amp_time() - t0;
+	tbuf->rotations++;
+}
+
+// Back to circular mode on both channels
+void tbuf_stop(tbuf_t *tbuf)
+{
+	XAxiVdma_StopParking(tbuf->vdma, XAXIVDMA_WRITE);
+	XAxiVdma_StopParking(tbuf->vdma, XAXIVDMA_READ);
+}
+
+// Rotation cost per frame. The global timer ticks once every two CPU
+// cycles.
+void tbuf_report(tbuf_t *tbuf)
+{
+	if (tbuf->rotations == 0)
+		return;
+
+	xil_printf("Frame store rotation: %d rotations, %d CPU cycles each, %d us/frame waiting for the VDMA, %d timeouts\r\n",
+			tbuf->rotations,
+			(Xuint32)(tbuf->rotate_ticks * 2 / tbuf->rotations),
+			(Xuint32)(tbuf->sync_ticks / tbuf->rotations / (AMP_GTIMER_HZ / 1000000)),
+			tbuf->timeouts);
+}
@@ -0,0 +1,54 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * triple_buffer.h - Tear-free software mode on the three VDMA frame stores.
+ *
+ *
+ * NOTES:
+ * At any time one store is being captured into (S2MM parked on it), one
+ * is being converted in place by the CPU, and one is on screen (MM2S
+ * parked on it). When a capture completes, S2MM moves to the store that
+ * is neither being converted nor displayed; when the conversion is done,
+ * MM2S moves to the converted store. The S2MM and MM2S channels share the
+ * frame store addresses set up in vfb_rx_setup()/vfb_tx_setup().
+ *****************************************************************************/
+
+#ifndef __TRIPLE_BUFFER_H__
+#define __TRIPLE_BUFFER_H__
+
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "xaxivdma.h"
+#include "amp.h"
+
+#define TBUF_NUM_FRAMES 3
+
+// Longest wait for a channel to move off a frame store (global timer ticks)
+#define TBUF_TIMEOUT (AMP_GTIMER_HZ / 20)
+
+struct struct_tbuf_t {
+	XAxiVdma *vdma;
+	Xuint32 addr[TBUF_NUM_FRAMES];
+	int capture;                  // store S2MM is parked on
+	int work;                     // completed capture being converted
+	int display;                  // store MM2S is parked on
+	Xuint32 rotations;
+	Xuint32 timeouts;
+	u64 rotate_ticks;             // bookkeeping and park register updates
+	u64 sync_ticks;               // waiting for the channels to switch stores
+}; typedef struct struct_tbuf_t tbuf_t;
+
+// Function prototypes (triple_buffer.c)
+int tbuf_init(tbuf_t *tbuf, XAxiVdma *pAxiVdma, const XAxiVdma_DmaSetup *pWriteCfg);
+Xuint16 *tbuf_acquire(tbuf_t *tbuf);
+void tbuf_present(tbuf_t *tbuf);
+void tbuf_stop(tbuf_t *tbuf);
+void tbuf_report(tbuf_t *tbuf);
+
+#endif // __TRIPLE_BUFFER_H__
@@ -247,6 +247,45 @@ int vfb_tx_setup(XAxiVdma *pAxiVdma, XAxiVdma_DmaSetup *pReadCfg, Xuint32 uVideo
 	return XST_SUCCESS;
 }
 
+// Point every MM2S frame store at one window: uAddr is its top-left pixel
+// and uStride the bytes from one of its lines to the next. The line
+// length stays the video width, so the display timing does not change.
+// Takes effect at the next frame start.
+int vfb_tx_window(XAxiVdma *pAxiVdma, XAxiVdma_DmaSetup *pReadCfg, Xuint32 uAddr, Xuint32 uStride, Xuint32 uNumFrames )
+{
+	int i;
+	int Status;
+
+	pReadCfg->Stride = uStride;
+
+	Status = XAxiVdma_DmaConfig(pAxiVdma, XAXIVDMA_READ, pReadCfg);
+	if (Status != XST_SUCCESS) {
+			xdbg_printf(XDBG_DEBUG_ERROR,
+				"Read channel config failed %d\n\r", Status);
+
+			return XST_FAILURE;
+	}
+
+	for(i = 0; i < uNumFrames; i++)
+	{
+		pReadCfg->FrameStoreStartAddr[i] = uAddr;
+	}
+
+	Status = XAxiVdma_DmaSetBufferAddr(pAxiVdma, XAXIVDMA_READ,
+			pReadCfg->FrameStoreStartAddr);
+	if (Status != XST_SUCCESS) {
+			xdbg_printf(XDBG_DEBUG_ERROR,
+				"Read channel set buffer address failed %d\n\r", Status);
+
+			return XST_FAILURE;
+	}
+
+	// New addresses are only picked up after VSIZE has been written
+	XAxiVdma_WriteReg(pAxiVdma->BaseAddr, XAXIVDMA_MM2S_ADDR_OFFSET + XAXIVDMA_VSIZE_OFFSET, pReadCfg->VertSizeInput);
+
+	return XST_SUCCESS;
+}
+
 int vfb_rx_start(XAxiVdma *pAxiVdma)
 {
    int Status;
@@ -17,16 +17,12 @@
 
 #include "camera_app.h"
 
+// Built from VRES_MODE_LIST (video_resolution.h)
+#define VRES_TIMING(id, hav, hfp, hsw, hbp, hsp, vav, vfp, vsw, vbp, vsp) \
+   [VIDEO_RESOLUTION_##id] = { #id, vav, vfp, vsw, vbp, vsp, hav, hfp, hsw, hbp, hsp },
+
 vres_timing_t vres_resolutions[NUM_VIDEO_RESOLUTIONS] = {
-   // name     vav,  vfp,  vsw,  vbp,  vsp,  hav,  hfp,  hsw,  hbp,  hsp
-   { "VGA",    480,   10,    2,   33,    0,  640,   16,   96,   48,    0 }, // VIDEO_RESOLUTION_VGA
-   { "NTSC",   480,    9,    6,   30,    1,  720,   16,   62,   60,    1 }, // VIDEO_RESOLUTION_NTSC
-   { "SVGA",   600,    1,    4,   23,    1,  800,   40,  128,   88,    1 }, // VIDEO_RESOLUTION_SVGA
-   { "XGA",    768,    3,    6,   29,    0, 1024,   24,  136,  160,    0 }, // VIDEO_RESOLUTION_XGA
-   { "720P",   720,    5,    5,   20,    1, 1280,  110,   40,  220,    1 }, // VIDEO_RESOLUTION_720P
-   { "SXGA",  1024,    1,    3,   26,    0, 1280,   48,  184,  200,    0 }, // VIDEO_RESOLUTION_SXGA
-   { "1080P", 1080,    4,    5,   36,    1, 1920,   88,   44,  148,    1 }, // VIDEO_RESOLUTION_1080P
-   { "UXGA",  1200,    1,    3,   46,    0, 1600,   64,  192,  304,    0 }  // VIDEO_RESOLUTION_UXGA
+   VRES_MODE_LIST(VRES_TIMING)
 };
 
 char *vres_get_name(Xuint32 resolutionId)
@@ -0,0 +1,72 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * video_resolution.h - Video modes: ids, timings and lookup functions.
+ *
+ *
+ * NOTES:
+ * VRES_MODE_LIST is the one table of the video modes. video_resolution.c
+ * builds vres_resolutions[] from it, and the ISP row kernel modules build
+ * a copy of their kernel for each mode's active width from it (see
+ * isp_select_kernels()), so the two cannot drift apart. To add a mode,
+ * give it a VIDEO_RESOLUTION_* id and a line here; its width must be a
+ * multiple of 4 and no wider than DEMOSAIC_MAX_WIDTH (isp.c checks).
+ *****************************************************************************/
+
+#ifndef __VIDEO_RESOLUTION_H__
+#define __VIDEO_RESOLUTION_H__
+
+#include <xbasic_types.h>
+
+// Video resolution ids, indices into vres_resolutions[]
+#define VIDEO_RESOLUTION_VGA       0
+#define VIDEO_RESOLUTION_NTSC      1
+#define VIDEO_RESOLUTION_SVGA      2
+#define VIDEO_RESOLUTION_XGA       3
+#define VIDEO_RESOLUTION_720P      4
+#define VIDEO_RESOLUTION_SXGA      5
+#define VIDEO_RESOLUTION_1080P     6
+#define VIDEO_RESOLUTION_UXGA      7
+#define NUM_VIDEO_RESOLUTIONS      8
+
+// X(id, hav, hfp, hsw, hbp, hsp, vav, vfp, vsw, vbp, vsp) for mode
+// VIDEO_RESOLUTION_<id>, named "<id>". The active width comes first, so
+// that users of the widths alone can take (id, width, ...).
+#define VRES_MODE_LIST(X) \
+	X(VGA,    640,   16,   96,   48,    0,  480,   10,    2,   33,    0) \
+	X(NTSC,   720,   16,   62,   60,    1,  480,    9,    6,   30,    1) \
+	X(SVGA,   800,   40,  128,   88,    1,  600,    1,    4,   23,    1) \
+	X(XGA,   1024,   24,  136,  160,    0,  768,    3,    6,   29,    0) \
+	X(720P,  1280,  110,   40,  220,    1,  720,    5,    5,   20,    1) \
+	X(SXGA,  1280,   48,  184,  200,    0, 1024,    1,    3,   26,    0) \
+	X(1080P, 1920,   88,   44,  148,    1, 1080,    4,    5,   36,    1) \
+	X(UXGA,  1600,   64,  192,  304,    0, 1200,    1,    3,   46,    0)
+
+struct struct_vres_timing_t {
+	char *pName;
+	Xuint32 VActiveVideo;
+	Xuint32 VFrontPorch;
+	Xuint32 VSyncWidth;
+	Xuint32 VBackPorch;
+	Xuint32 VSyncPolarity;
+	Xuint32 HActiveVideo;
+	Xuint32 HFrontPorch;
+	Xuint32 HSyncWidth;
+	Xuint32 HBackPorch;
+	Xuint32 HSyncPolarity;
+}; typedef struct struct_vres_timing_t vres_timing_t;
+
+// Function prototypes (video_resolution.c)
+char * vres_get_name(Xuint32 resolutionId);
+Xuint32 vres_get_width(Xuint32 resolutionId);
+Xuint32 vres_get_height(Xuint32 resolutionId);
+Xuint32 vres_get_timing(Xuint32 resolutionId, vres_timing_t *pTiming);
+Xint32 vres_detect(Xuint32 width, Xuint32 height);
+
+#endif // __VIDEO_RESOLUTION_H__
@@ -0,0 +1,179 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * zoom.c - Zoom/pan windows and the line-cached canvas upscaler (see
+ * zoom.h).
+ *****************************************************************************/
+
+#include <string.h>
+#include "xil_printf.h"
+#include "xstatus.h"
+#include "zoom.h"
+
+static const Xuint32 zoom_factors[ZOOM_NUM_LEVELS] = ZOOM_FACTORS;
+
+static int zoom_clamp(int v, int lo, int hi)
+{
+	return (v < lo) ? lo : (v > hi) ? hi : v;
+}
+
+// The canvas must be at least the view, and every width even
+int zoom_init(zoom_t *z, Xuint16 *canvas, int canvas_width, int canvas_height, int view_width, int view_height)
+{
+	if (canvas_width > ZOOM_MAX_CANVAS || canvas_width < view_width || canvas_height < view_height ||
+			(canvas_width & 1) || (view_width & 1))
+		return XST_FAILURE;
+
+	memset(z, 0, sizeof(*z));
+	z->canvas = canvas;
+	z->canvas_width = canvas_width;
+	z->canvas_height = canvas_height;
+	z->view_width = view_width;
+	z->view_height = view_height;
+	z->factor = zoom_factors[0];
+	return XST_SUCCESS;
+}
+
+// A new frame to show (at least the view size), at 1x and centred. The
+// canvas no longer holds any of it.
+void zoom_set_source(zoom_t *z, const Xuint16 *src, int width, int height)
+{
+	z->src = src;
+	z->src_width = width;
+	z->src_height = height;
+	z->level = 0;
+	z->factor = zoom_factors[0];
+	z->cx = width / 2;
+	z->cy = height / 2;
+	z->canvas_factor = 0;
+}
+
+// About the same centre
+void zoom_set_level(zoom_t *z, int level)
+{
+	z->level = zoom_clamp(level, 0, ZOOM_NUM_LEVELS - 1);
+	z->factor = zoom_factors[z->level];
+}
+
+// Move the view by dx, dy steps of 1/ZOOM_PAN_STEPS of itself
+void zoom_pan(zoom_t *z, int dx, int dy)
+{
+	z->cx += dx * (int)(z->view_width / ZOOM_PAN_STEPS * 256 / z->factor);
+	z->cy += dy * (int)(z->view_height / ZOOM_PAN_STEPS * 256 / z->factor);
+	z->cx = zoom_clamp(z->cx, 0, z->src_width - 1);
+	z->cy = zoom_clamp(z->cy, 0, z->src_height - 1);
+}
+
+// One source line scaled to the canvas width
+static void zoom_scale_line(const zoom_t *z, const Xuint16 *src, Xuint16 *dst)
+{
+	const Xuint16 *xmap = z->xmap;
+	int i, pair;
+
+	// Y from the nearest pixel, Cb/Cr from the pair it is in
+	for (i = 0; i < z->cw; i += 2) {
+		pair = xmap[i] & ~1;
+		dst[i] = (src[xmap[i]] & 0x00FF) | (src[pair] & 0xFF00);
+		dst[i + 1] = (src[xmap[i + 1]] & 0x00FF) | (src[pair + 1] & 0xFF00);
+	}
+}
+
+// Canvas lines y_start to y_end - 1. A line from the same source line as
+// the one above is a copy of it.
+void zoom_render_rows(const zoom_t *z, int y_start, int y_end)
+{
+	Xuint16 *dst = z->canvas + y_start * z->canvas_width;
+	int bytes = z->cw * sizeof(Xuint16);
+	int y, sy, prev_sy = -1;
+
+	for (y = y_start; y < y_end; y++) {
+		sy = zoom_clamp(((z->oy + y) * 256 + 128) / z->factor, 0, z->src_height - 1);
+		if (sy == prev_sy)
+			memcpy(dst, dst - z->canvas_width, bytes);
+		else
+			zoom_scale_line(z, z->src + sy * z->src_width, dst);
+		prev_sy = sy;
+		dst += z->canvas_width;
+	}
+
+	amp_dcache_flush_range(z->canvas + y_start * z->canvas_width,
+			(y_end - y_start) * z->canvas_width * sizeof(Xuint16));
+}
+
+// Centre the canvas on the view, within the zoomed frame, and render it
+static void zoom_render(zoom_t *z, int zw, int zh)
+{
+	u64 t0 = amp_time();
+	int i;
+
+	z->cw = (zw < z->canvas_width ? zw : z->canvas_width) & ~1;
+	z->ch = zh < z->canvas_height ? zh : z->canvas_height;
+	z->ox = zoom_clamp(z->vx + z->view_width / 2 - z->cw / 2, 0, zw - z->cw) & ~1;
+	z->oy = zoom_clamp(z->vy + z->view_height / 2 - z->ch / 2, 0, zh - z->ch);
+	z->canvas_factor = z->factor;
+
+	for (i = 0; i < z->cw; i++) {
+		z->xmap[i] = zoom_clamp(((z->ox + i) * 256 + 128) / z->factor, 0, z->src_width - 1);
+	}
+
+	// Core 1 reads the map and the placement
+	amp_dcache_flush_range(z, sizeof(*z));
+	amp_zoom_render(z);
+
+	z->renders++;
+	z->render_ticks += amp_time() - t0;
+}
+
+// Work out the window for the current level and centre, rendering the
+// canvas if it does not hold the view. Returns 1 if it was rendered.
+int zoom_update(zoom_t *z)
+{
+	int zw = (z->src_width * z->factor / 256) & ~1;
+	int zh = z->src_height * z->factor / 256;
+	int vx = z->cx * z->factor / 256 - z->view_width / 2;
+	int vy = z->cy * z->factor / 256 - z->view_height / 2;
+	int rendered = 0;
+
+	// At an edge the view stops, and so does the centre
+	z->vx = zoom_clamp(vx, 0, zw > z->view_width ? zw - z->view_width : 0) & ~1;
+	z->vy = zoom_clamp(vy, 0, zh > z->view_height ? zh - z->view_height : 0);
+	if (z->vx != vx)
+		z->cx = (z->vx + z->view_width / 2) * 256 / z->factor;
+	if (z->vy != vy)
+		z->cy = (z->vy + z->view_height / 2) * 256 / z->factor;
+
+	if (z->level == 0) {
+		z->window = z->src + z->vy * z->src_width + z->vx;
+		z->window_stride = z->src_width;
+		return 0;
+	}
+
+	if (z->canvas_factor != z->factor ||
+			z->vx < z->ox || z->vx + z->view_width > z->ox + z->cw ||
+			z->vy < z->oy || z->vy + z->view_height > z->oy + z->ch) {
+		zoom_render(z, zw, zh);
+		rendered = 1;
+	} else {
+		z->moves++;
+	}
+
+	z->window = z->canvas + (z->vy - z->oy) * z->canvas_width + (z->vx - z->ox);
+	z->window_stride = z->canvas_width;
+	return rendered;
+}
+
+void zoom_report(zoom_t *z)
+{
+	if (z->renders == 0 && z->moves == 0)
+		return;
+
+	xil_printf("Zoom: %d canvas renders, %d us per render, %d pans without one\r\n",
+			z->renders, z->renders ? (Xuint32)(z->render_ticks / z->renders / (AMP_GTIMER_HZ / 1000000)) : 0,
+			z->moves);
+}
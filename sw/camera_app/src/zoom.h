@@ -0,0 +1,87 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * zoom.h - Playback zoom and pan of a 4:2:2 frame, shown through a window
+ * the MM2S channel reads (vfb_tx_window()).
+ *
+ *
+ * NOTES:
+ * The MM2S channel always sends a whole video frame (view_width x
+ * view_height words) to the display, but it can read it from anywhere:
+ * its start address and stride pick a view_width-wide window out of a
+ * wider image. zoom_update() works out that window, as zoom.window and
+ * zoom.window_stride (words).
+ *
+ * At 1x the window is the source frame itself; no pixel is copied.
+ * Zoomed in, the window is in the canvas, which holds a part of the
+ * zoomed source up to canvas_width x canvas_height (twice the view each
+ * way in part 7). The canvas is rendered only when the view leaves it or
+ * the zoom changes; panning within it just moves the window.
+ *
+ * Rendering is nearest neighbour, on both cores (amp_zoom_render()).
+ * Every source line is scaled once into the canvas; canvas lines that
+ * repeat it (all but one of every n at n x) are copies of the line
+ * above. Pixel pairs keep their Cb/Cr order.
+ *
+ * Widths and the source's position in the canvas are kept even, for the
+ * 4:2:2 pairs.
+ *****************************************************************************/
+
+#ifndef __ZOOM_H__
+#define __ZOOM_H__
+
+#include <xbasic_types.h>
+#include <xil_types.h>
+#include "amp.h"
+
+#define ZOOM_NUM_LEVELS      4
+#define ZOOM_MAX_CANVAS      3840       // canvas_width limit, words
+#define ZOOM_PAN_STEPS       8          // a pan moves the view by 1/8 of itself
+
+// Factor of each level, 8.8 fixed point
+#define ZOOM_FACTORS         { 256, 384, 512, 1024 }
+
+struct struct_zoom_t {
+	const Xuint16 *src;
+	int src_width;                  // also the stride, words
+	int src_height;
+	Xuint16 *canvas;
+	int canvas_width;               // also the stride, words
+	int canvas_height;
+	int view_width;
+	int view_height;
+	int level;
+	Xuint32 factor;                 // 8.8
+	int cx;                         // view centre, source pixels
+	int cy;
+	int vx;                         // view top-left, zoomed pixels
+	int vy;
+	Xuint32 canvas_factor;          // what the canvas holds, 0 if nothing
+	int ox;                         // its top-left, zoomed pixels
+	int oy;
+	int cw;
+	int ch;
+	Xuint16 xmap[ZOOM_MAX_CANVAS];  // source column of each canvas column
+	const Xuint16 *window;          // the MM2S window
+	int window_stride;
+	Xuint32 renders;
+	Xuint32 moves;                  // window moves without a render
+	u64 render_ticks;
+}; typedef struct struct_zoom_t zoom_t;
+
+// Function prototypes (zoom.c)
+int zoom_init(zoom_t *z, Xuint16 *canvas, int canvas_width, int canvas_height, int view_width, int view_height);
+void zoom_set_source(zoom_t *z, const Xuint16 *src, int width, int height);
+void zoom_set_level(zoom_t *z, int level);
+void zoom_pan(zoom_t *z, int dx, int dy);
+int zoom_update(zoom_t *z);
+void zoom_render_rows(const zoom_t *z, int y_start, int y_end);
+void zoom_report(zoom_t *z);
+
+#endif // __ZOOM_H__
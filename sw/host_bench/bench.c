@@ -0,0 +1,1646 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * bench.c - Host benchmark driver for the camera software paths.
+ *
+ *
+ * NOTES:
+ * Builds the processing code from ../camera_app/src against the mocks in
+ * mock/ and times each path on a Bayer frame:
+ *    demosaic       bilinear demosaic through the line buffer
+ *    demosaic_mhc   gradient-corrected 5x5 demosaic through the line buffer
+ *    csc            demosaicked RGB to 4:2:2 (csc_convert_line); its
+ *                   check holds the converter against a model of the
+ *                   rgb2ycrcb core's datapath, for every 8-bit RGB value
+ *    isp_fused      ISP pipeline, fused bayer2ycbcr stage through the
+ *                   linear tone curve (part 5 default)
+ *    isp_vres       the same with the kernel built for the frame width,
+ *                   if it is a video mode's (isp_select_kernels()); the
+ *                   mhc, fused_tone and bin pipelines use those kernels too
+ *    isp_staged     ISP pipeline, demosaic/wb/tone/csc/422 stages
+ *    isp_mhc        ISP pipeline, demosaic_mhc/csc/422 stages
+ *    isp_awb        ISP pipeline, awb stats/bayer2ycbcr stages, then
+ *                   awb_update(); the output is the statistics and gains
+ *    isp_aec        ISP pipeline, sparse exposure statistics stage only,
+ *                   then aec_update() and aec_apply() to the (mock) sensor;
+ *                   the output is the statistics and the new settings
+ *    isp_tnr        ISP pipeline, fused stage then temporal noise
+ *                   reduction, on a noisy copy of the frame with a block
+ *                   moved, against a history seeded with the clean
+ *                   frame (the timing includes seeding it, a frame copy)
+ *    isp_tone       ISP pipeline, demosaic/tone/csc/422 stages with the
+ *                   sRGB curve swapped in before the frame (its check
+ *                   also holds every preset LUT against libm)
+ *    isp_fused_tone ISP pipeline, fused bayer2ycbcr stage with the sRGB
+ *                   curve swapped in, against the same frame as isp_tone
+ *    isp_bin        ISP pipeline, 2x2 binning/tone/csc/422 stages: the
+ *                   part 5 preview, centred in a full-size frame
+ *    isp_roi        ISP pipeline, fused stage on two ROIs, the rest of the
+ *                   frame passed through on the (mock) PL330
+ *    capture_copy   save_image(): S2MM store to image store and MM2S
+ *    playback_copy  display_raw_image(): image store to MM2S
+ *    dma_copy       the S2MM frame copied through the DMA queue as its
+ *                   left and right halves (two strided copies, each
+ *                   with a callback) on the (mock) PL330
+ *    raw10          RAW10 capture: raw10_pack_frame() + raw10_unpack_frame()
+ *    capture_store  4:2:2 capture compressed into the capture store and
+ *                   decompressed for playback (the output is the
+ *                   compressed capture)
+ *    zoom           playback zoom: the frame at 1x, at 1.5x panned, and
+ *                   at 4x panned (the output is the last view window)
+ *
+ * The input is a synthetic test scene, or a recorded frame (-i) of raw
+ * 16-bit S2MM words with the sensor value in the low BAYER_BITS bits,
+ * e.g. one of the images saved in part 7 dumped from DDR. Build with
+ * "make BAYER_BITS=10" for the 10-bit path, and with "make NEON=1" for the
+ * NEON kernels on the intrinsics stand-in in mock/neon (checked against
+ * the scalar ones through the outputs below; timed meaninglessly).
+ *
+ * Outputs are checked against each other (the ISP pipelines must match
+ * demosaic + csc, the copies (on the CPU or the PL330), RAW10 and the capture store must give back
+ * their input, and the zoom view must be what its factor and position
+ * give), against golden CRCs
+ * (-c, written with -u) and optionally against golden images (-g, written
+ * with -o). The exit status is non-zero if any check fails.
+ *
+ * On the synthetic scene the two demosaic kernels are also scored against
+ * the scene itself (PSNR per channel), to weigh quality against speed.
+ *
+ * Timings are host timings; use them to compare versions of the code,
+ * not to predict ZedBoard frame rates.
+ *****************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "xaxivdma_hw.h"
+#include "amp.h"
+#include "isp.h"
+#include "awb.h"
+#include "aec.h"
+#include "raw10.h"
+#include "tone.h"
+#include "tnr.h"
+#include "roi.h"
+#include "capture_store.h"
+#include "dma_queue.h"
+#include "zoom.h"
+#include "mock.h"
+
+#define BENCH_DEFAULT_FRAMES 10
+#define BENCH_MAX_GOLDEN     64
+#define BENCH_CSTORE_POOL_MB 64         // part 7's CAPTURE_POOL_MB
+
+struct struct_bench_t {
+	int width;
+	int height;
+	int frames;
+	Xuint16 *bayer;
+	Xuint16 *noisy;                   // isp_tnr input
+	Xuint8 *truth[3];                 // synthetic scene before the mosaic, or NULL
+	uint16_t *rgb[3];                 // R/G/B planes, whole frame
+	uint16_t *mhc[3];                 // same, 5x5 demosaic
+	uint16_t *scratch[3];
+	Xuint16 *ycc;                     // demosaic + csc
+	Xuint16 *fused;
+	Xuint16 *vres_ycc;
+	Xuint16 *staged;
+	Xuint16 *mhc_ycc;
+	Xuint16 *awb_ycc;
+	Xuint16 *tone_ycc;
+	Xuint16 *fused_tone_ycc;
+	Xuint16 *tnr_ycc;
+	Xuint16 *noisy_ycc;               // isp_tnr input, fused stage only
+	Xuint16 *tnr_history;
+	Xuint16 *ref_ycc;                 // checks
+	Xuint16 *preview;                 // isp_bin, full-size frame
+	Xuint16 *roi_ycc;                 // isp_roi: 4:2:2 ROIs, Bayer elsewhere
+	Xuint16 *raw_image;               // part 7 image store
+	Xuint8 *raw10;                    // the same, packed
+	Xuint16 *unpacked;
+	Xuint8 *cstore_pool;              // room for two compressed frames
+	Xuint32 cstore_pool_bytes;
+	Xuint16 *decoded;
+	Xuint16 *dma_frame;               // dma_copy
+	int dma_done;                     // callbacks run
+	Xuint16 *zoom_canvas;             // twice the frame each way
+	Xuint16 *zoom_view;               // the window, as a frame
+	int zoom_ok;
+	csc_coef_t coef;                  // sensor-depth RGB in
+	csc_coef_t coef8;                 // 8-bit RGB in, after the tone LUT
+	long csc_off[3];                  // coef8 against the core's datapath
+	int csc_worst;
+	isp_pipeline_t fused_pipe;
+	isp_pipeline_t vres_pipe;
+	isp_pipeline_t staged_pipe;
+	isp_pipeline_t mhc_pipe;
+	isp_pipeline_t awb_pipe;
+	isp_pipeline_t aec_pipe;
+	isp_pipeline_t tnr_pipe;
+	isp_pipeline_t tone_pipe;
+	isp_pipeline_t fused_tone_pipe;
+	isp_pipeline_t bin_pipe;
+	isp_pipeline_t roi_pipe;
+	dma2d_t dma;
+	dma2d_t copy_dma;                 // the DMA queue's channel
+	dmaq_t copyq;
+	roi_set_t rois;
+	awb_t awb;
+	csc_coef_t awb_coef;
+	awb_stats_t awb_ref;
+	struct {
+		awb_stats_t stats;
+		uint16_t gain[4];
+	} awb_out;                        // isp_awb output, zero padded
+	aec_t aec;
+	fmc_imageon_vita_receiver_t vita;
+	struct {
+		aec_stats_t stats;
+		aec_setting_t setting;
+	} aec_out;                        // isp_aec output, zero padded
+	aec_stats_t aec_ref;
+	tnr_t tnr;
+	cstore_t cstore;
+	zoom_t zoom;
+	isp_wb_t wb;
+	tone_t tone;                      // linear, isp_fused and isp_staged
+	tone_t tone_srgb;                 // isp_tone and isp_fused_tone
+	line_buffer_t lbuf;
+}; typedef struct struct_bench_t bench_t;
+
+struct struct_bench_output_t {
+	const void *data[3];
+	int bytes;                        // per buffer
+}; typedef struct struct_bench_output_t bench_output_t;
+
+struct struct_bench_stage_t {
+	const char *name;
+	void (*run)(bench_t *b);
+	void (*output)(bench_t *b, bench_output_t *out);
+	const char *(*check)(bench_t *b, const bench_output_t *out);   // failure, or NULL
+}; typedef struct struct_bench_stage_t bench_stage_t;
+
+struct struct_bench_golden_t {
+	char name[32];
+	int width;
+	int height;
+	Xuint32 input_crc;
+	Xuint32 output_crc;
+}; typedef struct struct_bench_golden_t bench_golden_t;
+
+static Xuint32 crc_table[256];
+
+static void crc_init(void)
+{
+	Xuint32 c;
+	int n, k;
+
+	for (n = 0; n < 256; n++) {
+		c = n;
+		for (k = 0; k < 8; k++) {
+			c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+		}
+		crc_table[n] = c;
+	}
+}
+
+static Xuint32 crc_update(Xuint32 crc, const void *data, int bytes)
+{
+	const Xuint8 *p = (const Xuint8 *)data;
+	int i;
+
+	crc = ~crc & 0xFFFFFFFF;
+	for (i = 0; i < bytes; i++) {
+		crc = crc_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc & 0xFFFFFFFF;
+}
+
+static void *bench_alloc(int bytes)
+{
+	void *p = calloc(1, bytes);
+
+	if (!p) {
+		fprintf(stderr, "bench: out of memory\n");
+		exit(1);
+	}
+	mock_dma_region(p, bytes);
+	return p;
+}
+
+// Test scene: colour bars over the top half and a tinted zone plate (fine
+// detail at every angle, as in a natural scene with its channels
+// correlated) over the bottom half, with a little fixed pseudo-random
+// noise, sampled on an RGGB mosaic. Integer only, so every host builds the
+// same frame. Above 8 bits the extra low bits are noise as well.
+static void bench_synthetic_frame(bench_t *b)
+{
+	static const Xuint8 bars[8][3] = {
+		{235, 235, 235}, {235, 235, 16}, {16, 235, 235}, {16, 235, 16},
+		{235, 16, 235}, {235, 16, 16}, {16, 16, 235}, {16, 16, 16}
+	};
+	Xuint32 seed = 488;
+	int x, y, c, v, dx, dy, t;
+	int rgb[3];
+
+	for (y = 0; y < b->height; y++) {
+		for (x = 0; x < b->width; x++) {
+			if (y < b->height / 2) {
+				for (c = 0; c < 3; c++) {
+					rgb[c] = bars[x * 8 / b->width][c];
+				}
+			} else {
+				// Triangle wave in r^2 around the centre of the half
+				dx = x - b->width / 2;
+				dy = y - b->height * 3 / 4;
+				t = ((dx * dx + dy * dy) >> 6) & 511;
+				v = 16 + ((t < 256) ? t : 511 - t) * 219 / 255;
+				rgb[0] = v;
+				rgb[1] = v * 7 / 8 + 16;
+				rgb[2] = v * 3 / 4 + 32;
+			}
+			c = (y & 1) + (x & 1);            // 0 = R, 1 = G, 2 = B
+			seed = seed * 1103515245 + 12345;
+			v = rgb[c] + (int)((seed >> 16) & 7) - 4;
+			v = (v < 0) ? 0 : (v > 255) ? 255 : v;
+			b->bayer[y * b->width + x] = v << (BAYER_BITS - 8) | ((seed >> 24) & (BAYER_MAX >> 8));
+			for (v = 0; v < 3; v++) {
+				b->truth[v][y * b->width + x] = rgb[v];
+			}
+		}
+	}
+}
+
+// The next frame of a noisy scene: the input plus more pseudo-random
+// noise, with a block in the middle of the top half taken from 32 pixels
+// further right (something that moved)
+static void bench_noisy_frame(bench_t *b)
+{
+	Xuint32 seed = 1975;
+	int bx = b->width / 4 & ~1, by = b->height / 8 & ~1;
+	int bw = b->width / 8 & ~1, bh = b->height / 8 & ~1;
+	int x, y, v, sx;
+
+	for (y = 0; y < b->height; y++) {
+		for (x = 0; x < b->width; x++) {
+			sx = x;
+			if (x >= bx && x < bx + bw && y >= by && y < by + bh && x + 32 < b->width)
+				sx = x + 32;
+			seed = seed * 1103515245 + 12345;
+			v = BAYER_PIXEL(b->bayer[y * b->width + sx]) + (((int)((seed >> 16) & 15) - 8) << (BAYER_BITS - 8));
+			b->noisy[y * b->width + x] = (v < 0) ? 0 : (v > BAYER_MAX) ? BAYER_MAX : v;
+		}
+	}
+}
+
+static int bench_read_frame(bench_t *b, const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	size_t words = (size_t)b->width * b->height;
+
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	if (fread(b->bayer, sizeof(Xuint16), words, f) != words) {
+		fprintf(stderr, "%s: shorter than one %dx%d frame\n", path, b->width, b->height);
+		fclose(f);
+		return -1;
+	}
+	fclose(f);
+	return 0;
+}
+
+// The fixed-width kernels of the first video mode as wide as the frame,
+// if there is one
+static void bench_select_kernels(bench_t *b, isp_pipeline_t *pipe)
+{
+	Xuint32 r;
+
+	for (r = 0; r < NUM_VIDEO_RESOLUTIONS; r++) {
+		if (isp_select_kernels(pipe, r, b->width) == XST_SUCCESS)
+			return;
+	}
+}
+
+static void bench_init(bench_t *b)
+{
+	int frame_bytes = b->width * b->height * sizeof(Xuint16);
+	int c;
+
+	b->bayer = bench_alloc(frame_bytes);
+	for (c = 0; c < 3; c++) {
+		b->rgb[c] = bench_alloc(frame_bytes);
+		b->mhc[c] = bench_alloc(frame_bytes);
+		b->scratch[c] = bench_alloc(frame_bytes);
+	}
+	b->ycc = bench_alloc(frame_bytes);
+	b->fused = bench_alloc(frame_bytes);
+	b->vres_ycc = bench_alloc(frame_bytes);
+	b->staged = bench_alloc(frame_bytes);
+	b->mhc_ycc = bench_alloc(frame_bytes);
+	b->awb_ycc = bench_alloc(frame_bytes);
+	b->tone_ycc = bench_alloc(frame_bytes);
+	b->fused_tone_ycc = bench_alloc(frame_bytes);
+	b->noisy = bench_alloc(frame_bytes);
+	b->tnr_ycc = bench_alloc(frame_bytes);
+	b->noisy_ycc = bench_alloc(frame_bytes);
+	b->tnr_history = bench_alloc(frame_bytes);
+	b->ref_ycc = bench_alloc(frame_bytes);
+	b->preview = bench_alloc(frame_bytes);
+	b->roi_ycc = bench_alloc(frame_bytes);
+	b->raw_image = bench_alloc(frame_bytes);
+	b->raw10 = bench_alloc(RAW10_FRAME_BYTES(b->width, b->height));
+	b->unpacked = bench_alloc(frame_bytes);
+	b->cstore_pool_bytes = 2 * (CSTORE_NUM_SLICES(b->height) * sizeof(Xuint32)
+			+ b->height * CSTORE_LINE_BOUND(b->width)) + CSTORE_ALIGN + CSTORE_PAD;
+	b->cstore_pool = bench_alloc(b->cstore_pool_bytes);
+	b->decoded = bench_alloc(frame_bytes);
+	b->dma_frame = bench_alloc(frame_bytes);
+	b->zoom_canvas = bench_alloc(4 * frame_bytes);
+	b->zoom_view = bench_alloc(frame_bytes);
+
+	mock_vdma_init(XPAR_AXI_VDMA_0_BASEADDR, frame_bytes);
+
+	if (csc_coef_from_standard(&b->coef8, CSC_STANDARD, CSC_INPUT_RANGE) != 0)
+		csc_coef_default(&b->coef8);
+	csc_coef_scale_input(&b->coef, &b->coef8, BAYER_BITS);
+
+	// Unity gains and a linear tone curve, so at 8 bits both pipelines
+	// compute the same frame
+	for (c = 0; c < 3; c++) {
+		b->wb.gain[c] = 256;
+	}
+	tone_init(&b->tone, TONE_PRESET_LINEAR, &b->coef8);
+
+	isp_init(&b->fused_pipe);
+	isp_add_stage(&b->fused_pipe, "bayer2ycbcr", tone_stage_bayer2ycbcr, &b->tone);
+
+	isp_init(&b->vres_pipe);
+	isp_add_stage(&b->vres_pipe, "bayer2ycbcr", tone_stage_bayer2ycbcr, &b->tone);
+	bench_select_kernels(b, &b->vres_pipe);
+
+	isp_init(&b->staged_pipe);
+	isp_add_stage(&b->staged_pipe, "demosaic", isp_stage_demosaic, NULL);
+	isp_add_stage(&b->staged_pipe, "white_balance", isp_stage_white_balance, &b->wb);
+	isp_add_stage(&b->staged_pipe, "tone", tone_stage, &b->tone);
+	isp_add_stage(&b->staged_pipe, "csc", isp_stage_csc, &b->coef8);
+	isp_add_stage(&b->staged_pipe, "422", isp_stage_422, NULL);
+
+	isp_init(&b->mhc_pipe);
+	isp_add_stage(&b->mhc_pipe, "demosaic_mhc", isp_stage_demosaic_mhc, NULL);
+	isp_add_stage(&b->mhc_pipe, "csc", isp_stage_csc, &b->coef);
+	isp_add_stage(&b->mhc_pipe, "422", isp_stage_422, NULL);
+	bench_select_kernels(b, &b->mhc_pipe);
+
+	isp_init(&b->awb_pipe);
+	isp_add_stage(&b->awb_pipe, "awb_stats", awb_stage_stats, &b->awb);
+	isp_add_stage(&b->awb_pipe, "bayer2ycbcr", isp_stage_bayer2ycbcr, &b->awb_coef);
+
+	isp_init(&b->aec_pipe);
+	isp_add_stage(&b->aec_pipe, "aec_stats", aec_stage_stats, &b->aec);
+
+	isp_init(&b->tnr_pipe);
+	isp_add_stage(&b->tnr_pipe, "bayer2ycbcr", tone_stage_bayer2ycbcr, &b->tone);
+	isp_add_stage(&b->tnr_pipe, "tnr", tnr_stage, &b->tnr);
+	tnr_init(&b->tnr, b->tnr_history, TNR_ALPHA_MIN, TNR_NOISE_LEVEL, TNR_MOTION_LEVEL);
+
+	isp_init(&b->tone_pipe);
+	isp_add_stage(&b->tone_pipe, "demosaic", isp_stage_demosaic, NULL);
+	isp_add_stage(&b->tone_pipe, "tone", tone_stage, &b->tone_srgb);
+	isp_add_stage(&b->tone_pipe, "csc", isp_stage_csc, &b->coef8);
+	isp_add_stage(&b->tone_pipe, "422", isp_stage_422, NULL);
+
+	isp_init(&b->fused_tone_pipe);
+	isp_add_stage(&b->fused_tone_pipe, "bayer2ycbcr", tone_stage_bayer2ycbcr, &b->tone_srgb);
+	bench_select_kernels(b, &b->fused_tone_pipe);
+
+	isp_init(&b->bin_pipe);
+	isp_add_stage(&b->bin_pipe, "bin2", isp_stage_bin2, NULL);
+	isp_add_stage(&b->bin_pipe, "tone", tone_stage, &b->tone);
+	isp_add_stage(&b->bin_pipe, "csc", isp_stage_csc, &b->coef8);
+	isp_add_stage(&b->bin_pipe, "422", isp_stage_422, NULL);
+	bench_select_kernels(b, &b->bin_pipe);
+
+	// Two ROIs, about a sixteenth and a twelfth of the frame (none if the
+	// frame is too small to hold them)
+	isp_init(&b->roi_pipe);
+	isp_add_stage(&b->roi_pipe, "bayer2ycbcr", tone_stage_bayer2ycbcr, &b->tone);
+	dma2d_init(&b->dma, DMA2D_DEVICE_ID, DMA2D_CHANNEL);
+	roi_init(&b->rois, &b->dma);
+	dma2d_init(&b->copy_dma, DMA2D_DEVICE_ID, DMA2D_CHANNEL + 1);
+	dmaq_init(&b->copyq, &b->copy_dma);
+	b->zoom_ok = zoom_init(&b->zoom, b->zoom_canvas, 2 * b->width < ZOOM_MAX_CANVAS ? 2 * b->width : ZOOM_MAX_CANVAS,
+			2 * b->height, b->width, b->height) == XST_SUCCESS;
+	roi_add(&b->rois, b->width / 8 / ROI_ALIGN * ROI_ALIGN, b->height / 8 & ~1,
+			b->width / 4 / ROI_ALIGN * ROI_ALIGN, b->height / 4 & ~1, b->width, b->height);
+	roi_add(&b->rois, b->width / 2 / ROI_ALIGN * ROI_ALIGN, b->height / 2 & ~1,
+			b->width / 4 / ROI_ALIGN * ROI_ALIGN, b->height / 3 & ~1, b->width, b->height);
+}
+
+// The S2MM and MM2S frame pointers, read the way camera_app.c reads them
+static Xuint16 *bench_s2mm_frame(void)
+{
+	return (Xuint16 *)XAxiVdma_ReadReg(XPAR_AXI_VDMA_0_BASEADDR, XAXIVDMA_S2MM_ADDR_OFFSET+XAXIVDMA_START_ADDR_OFFSET);
+}
+
+static Xuint16 *bench_mm2s_frame(void)
+{
+	return (Xuint16 *)XAxiVdma_ReadReg(XPAR_AXI_VDMA_0_BASEADDR, XAXIVDMA_MM2S_ADDR_OFFSET+XAXIVDMA_START_ADDR_OFFSET+4);
+}
+
+// Point line[0..1] at lines y and y+1 of a set of planes
+static void bench_rgb_lines(bench_t *b, uint16_t **planes, int y, rgb_line_t *line)
+{
+	int l, offset;
+
+	for (l = 0; l < 2; l++) {
+		offset = (y + l) * b->width;
+		line[l].R = planes[0] + offset;
+		line[l].G = planes[1] + offset;
+		line[l].B = planes[2] + offset;
+	}
+}
+
+static void bench_run_demosaic(bench_t *b)
+{
+	const Xuint16 *above, *even, *odd, *below;
+	rgb_line_t line[2];
+	int y;
+
+	lbuf_init(&b->lbuf, b->bayer, b->width, b->height, b->width, 0, b->height, DEMOSAIC_BILINEAR_APRON, NULL, NULL);
+	for (y = 0; y < b->height; y += 2) {
+		bench_rgb_lines(b, b->rgb, y, line);
+		lbuf_quad_row(&b->lbuf, y, &above, &even, &odd, &below);
+		demosaic_bilinear_quad_row(above, even, odd, below, &line[0], &line[1], b->width);
+	}
+}
+
+// The 5x5 demosaic into planes, with the fastest kernel or the reference
+static void bench_demosaic_mhc(bench_t *b, uint16_t **planes, int ref)
+{
+	const Xuint16 *window[LBUF_MAX_LINES];
+	rgb_line_t line[2];
+	int y;
+
+	lbuf_init(&b->lbuf, b->bayer, b->width, b->height, b->width, 0, b->height, DEMOSAIC_MHC_APRON, NULL, NULL);
+	for (y = 0; y < b->height; y += 2) {
+		bench_rgb_lines(b, planes, y, line);
+		lbuf_window(&b->lbuf, y, window);
+		if (ref)
+			demosaic_mhc_quad_row_ref(window, &line[0], &line[1], b->width);
+		else
+			demosaic_mhc_quad_row(window, &line[0], &line[1], b->width);
+	}
+}
+
+static void bench_run_demosaic_mhc(bench_t *b)
+{
+	bench_demosaic_mhc(b, b->mhc, 0);
+}
+
+static void bench_run_csc(bench_t *b)
+{
+	rgb_line_t line;
+	int y, offset;
+
+	for (y = 0; y < b->height; y++) {
+		offset = y * b->width;
+		line.R = b->rgb[0] + offset;
+		line.G = b->rgb[1] + offset;
+		line.B = b->rgb[2] + offset;
+		csc_convert_line(&b->coef, &line, b->ycc + offset, 0, b->width);
+	}
+}
+
+static void bench_run_isp_fused(bench_t *b)
+{
+	amp_isp_frame(&b->fused_pipe, b->bayer, b->fused, b->width, b->height);
+}
+
+static void bench_run_isp_vres(bench_t *b)
+{
+	amp_isp_frame(&b->vres_pipe, b->bayer, b->vres_ycc, b->width, b->height);
+}
+
+static void bench_run_isp_staged(bench_t *b)
+{
+	amp_isp_frame(&b->staged_pipe, b->bayer, b->staged, b->width, b->height);
+}
+
+static void bench_run_isp_mhc(bench_t *b)
+{
+	amp_isp_frame(&b->mhc_pipe, b->bayer, b->mhc_ycc, b->width, b->height);
+}
+
+// One frame from unity gains, so the output does not depend on -n
+static void bench_run_isp_awb(bench_t *b)
+{
+	awb_init(&b->awb, AWB_MODE_GRAY_WORLD, &b->coef, &b->awb_coef, NULL);
+	amp_isp_frame(&b->awb_pipe, b->bayer, b->awb_ycc, b->width, b->height);
+	awb_update(&b->awb);
+}
+
+// From the bring-up settings (fmc_imageon_enable()) every frame, so the
+// output does not depend on the frame count. The stage writes nothing,
+// so dst is just somewhere to point the output lines.
+static void bench_run_isp_aec(bench_t *b)
+{
+	memset(&b->vita, 0, sizeof(b->vita));
+	aec_init(&b->aec, &b->vita, 90, 0, AEC_DGAIN_UNITY);
+	amp_isp_frame(&b->aec_pipe, b->bayer, b->ref_ycc, b->width, b->height);
+	aec_update(&b->aec);
+	aec_apply(&b->aec);
+}
+
+// Linear to sRGB at the frame boundary, the way camera_loop() takes a
+// curve from the UART; the timing includes building the curve
+static void bench_run_isp_tnr(bench_t *b)
+{
+	memcpy(b->tnr_history, b->ycc, b->width * b->height * sizeof(Xuint16));
+	tnr_reset(&b->tnr);
+	tnr_frame_done(&b->tnr);
+	amp_isp_frame(&b->tnr_pipe, b->noisy, b->tnr_ycc, b->width, b->height);
+	tnr_frame_done(&b->tnr);
+}
+
+static void bench_run_isp_tone(bench_t *b)
+{
+	tone_init(&b->tone_srgb, TONE_PRESET_LINEAR, &b->coef8);
+	tone_load_preset(&b->tone_srgb, TONE_PRESET_SRGB);
+	tone_swap(&b->tone_srgb);
+	amp_isp_frame(&b->tone_pipe, b->bayer, b->tone_ycc, b->width, b->height);
+}
+
+static void bench_run_isp_fused_tone(bench_t *b)
+{
+	tone_init(&b->tone_srgb, TONE_PRESET_LINEAR, &b->coef8);
+	tone_load_preset(&b->tone_srgb, TONE_PRESET_SRGB);
+	tone_swap(&b->tone_srgb);
+	amp_isp_frame(&b->fused_tone_pipe, b->bayer, b->fused_tone_ycc, b->width, b->height);
+}
+
+// Top-left pixel of the preview, centred as camera_preview_frame() does
+static int bench_preview_offset(bench_t *b)
+{
+	return (b->height - b->height / 2) / 2 * b->width + ((b->width - b->width / 2) / 2 & ~1);
+}
+
+// The binned lines are 4:2:2, so the width must be a multiple of 4 (every
+// vres width is)
+static void bench_run_isp_bin(bench_t *b)
+{
+	if (b->width & 3)
+		return;
+	amp_isp_frame(&b->bin_pipe, b->bayer, b->preview + bench_preview_offset(b), b->width, b->height);
+}
+
+static void bench_run_isp_roi(bench_t *b)
+{
+	roi_frame(&b->rois, &b->roi_pipe, b->bayer, b->roi_ycc, b->width, b->height);
+}
+
+static void bench_run_capture_copy(bench_t *b)
+{
+	amp_copy_frame(bench_s2mm_frame(), b->raw_image, bench_mm2s_frame(), b->width, b->height);
+}
+
+static void bench_run_playback_copy(bench_t *b)
+{
+	amp_copy_frame(b->raw_image, bench_mm2s_frame(), NULL, b->width, b->height);
+}
+
+static void bench_dma_done(void *ctx, int status)
+{
+	bench_t *b = ctx;
+
+	if (status == XST_SUCCESS)
+		b->dma_done++;
+}
+
+// Unless the halves are word aligned (width a multiple of 4), the queue
+// does them on the CPU
+static void bench_run_dma_copy(bench_t *b)
+{
+	int stride = b->width * sizeof(Xuint16);
+	int left = b->width / 2 * sizeof(Xuint16);
+
+	dmaq_copy(&b->copyq, bench_s2mm_frame(), b->dma_frame, left, b->height, stride, stride, bench_dma_done, b);
+	dmaq_copy(&b->copyq, (Xuint8 *)bench_s2mm_frame() + left, (Xuint8 *)b->dma_frame + left,
+			stride - left, b->height, stride, stride, bench_dma_done, b);
+	dmaq_wait(&b->copyq);
+}
+
+// RAW10 works on groups of four samples; every vres width is a multiple
+// of 4, but the bench also runs odd sizes for the kernels' tails
+static void bench_run_raw10(bench_t *b)
+{
+	if (b->width & 3)
+		return;
+	raw10_pack_frame(b->bayer, b->raw10, b->width, b->height);
+	raw10_unpack_frame(b->raw10, b->unpacked, b->width, b->height);
+}
+
+// The fused stage's frame in and out of the store, as save_image() and
+// display_raw_image() do (4:2:2 lines are multiples of 4 wide, as RAW10's)
+static void bench_run_capture_store(bench_t *b)
+{
+	if (b->width & 3)
+		return;
+	cstore_init(&b->cstore, b->cstore_pool, b->cstore_pool_bytes);
+	cstore_put_422(&b->cstore, b->ycc, b->width, b->height);
+	cstore_decode_frame(&b->cstore, 0, b->decoded);
+}
+
+// Each zoom change renders the canvas; each pan after it only moves the
+// window
+static void bench_run_zoom(bench_t *b)
+{
+	if (!b->zoom_ok)
+		return;
+	zoom_set_source(&b->zoom, b->ycc, b->width, b->height);
+	zoom_update(&b->zoom);
+	zoom_set_level(&b->zoom, 1);
+	zoom_update(&b->zoom);
+	zoom_pan(&b->zoom, 1, 1);
+	zoom_update(&b->zoom);
+	zoom_set_level(&b->zoom, 3);
+	zoom_update(&b->zoom);
+	zoom_pan(&b->zoom, -3, 0);
+	zoom_update(&b->zoom);
+}
+
+static void bench_frame_output(bench_output_t *out, const void *frame, int bytes)
+{
+	out->data[0] = frame;
+	out->data[1] = NULL;
+	out->data[2] = NULL;
+	out->bytes = bytes;
+}
+
+static void bench_planes_output(bench_t *b, bench_output_t *out, uint16_t **planes)
+{
+	int c;
+
+	for (c = 0; c < 3; c++) {
+		out->data[c] = planes[c];
+	}
+	out->bytes = b->width * b->height * sizeof(uint16_t);
+}
+
+static void bench_out_demosaic(bench_t *b, bench_output_t *out)
+{
+	bench_planes_output(b, out, b->rgb);
+}
+
+static void bench_out_demosaic_mhc(bench_t *b, bench_output_t *out)
+{
+	bench_planes_output(b, out, b->mhc);
+}
+
+static void bench_out_csc(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, b->ycc, b->width * b->height * sizeof(Xuint16));
+}
+
+static void bench_out_isp_fused(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, b->fused, b->width * b->height * sizeof(Xuint16));
+}
+
+static void bench_out_isp_vres(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, b->vres_ycc, b->width * b->height * sizeof(Xuint16));
+}
+
+static void bench_out_isp_staged(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, b->staged, b->width * b->height * sizeof(Xuint16));
+}
+
+static void bench_out_isp_mhc(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, b->mhc_ycc, b->width * b->height * sizeof(Xuint16));
+}
+
+static void bench_out_isp_awb(bench_t *b, bench_output_t *out)
+{
+	memset(&b->awb_out, 0, sizeof(b->awb_out));
+	b->awb_out.stats = b->awb.last;
+	memcpy(b->awb_out.gain, b->awb.gain, sizeof(b->awb.gain));
+	bench_frame_output(out, &b->awb_out, sizeof(b->awb_out));
+}
+
+static void bench_out_isp_aec(bench_t *b, bench_output_t *out)
+{
+	memset(&b->aec_out, 0, sizeof(b->aec_out));
+	b->aec_out.stats = b->aec.last;
+	b->aec_out.setting = b->aec.current;
+	bench_frame_output(out, &b->aec_out, sizeof(b->aec_out));
+}
+
+static void bench_out_isp_tnr(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, b->tnr_ycc, b->width * b->height * sizeof(Xuint16));
+}
+
+static void bench_out_isp_tone(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, b->tone_ycc, b->width * b->height * sizeof(Xuint16));
+}
+
+static void bench_out_isp_fused_tone(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, b->fused_tone_ycc, b->width * b->height * sizeof(Xuint16));
+}
+
+static void bench_out_isp_bin(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, b->preview, b->width * b->height * sizeof(Xuint16));
+}
+
+static void bench_out_isp_roi(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, b->roi_ycc, b->width * b->height * sizeof(Xuint16));
+}
+
+static void bench_out_capture_copy(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, b->raw_image, b->width * b->height * sizeof(Xuint16));
+}
+
+static void bench_out_playback_copy(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, bench_mm2s_frame(), b->width * b->height * sizeof(Xuint16));
+}
+
+static void bench_out_dma_copy(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, b->dma_frame, b->width * b->height * sizeof(Xuint16));
+}
+
+static void bench_out_raw10(bench_t *b, bench_output_t *out)
+{
+	bench_frame_output(out, b->raw10, RAW10_FRAME_BYTES(b->width, b->height));
+}
+
+static void bench_out_zoom(bench_t *b, bench_output_t *out)
+{
+	int y;
+
+	for (y = 0; b->zoom_ok && y < b->height; y++) {
+		memcpy(b->zoom_view + y * b->width, b->zoom.window + y * b->zoom.window_stride, b->width * sizeof(Xuint16));
+	}
+	bench_frame_output(out, b->zoom_view, b->zoom_ok ? b->width * b->height * sizeof(Xuint16) : 0);
+}
+
+static void bench_out_capture_store(bench_t *b, bench_output_t *out)
+{
+	const cstore_entry_t *entry = cstore_get(&b->cstore, 0);
+
+	bench_frame_output(out, entry ? entry->data : NULL, entry ? entry->bytes : 0);
+}
+
+static const char *bench_check_ycc(bench_t *b, const bench_output_t *out)
+{
+	return memcmp(out->data[0], b->ycc, out->bytes) ? "differs from demosaic + csc" : NULL;
+}
+
+// Every sample back, at the sensor depth
+static const char *bench_check_raw10(bench_t *b, const bench_output_t *out)
+{
+	int i;
+
+	if (b->width & 3)
+		return NULL;
+	for (i = 0; i < b->width * b->height; i++) {
+		if (b->unpacked[i] != BAYER_PIXEL(b->bayer[i]))
+			return "unpacked frame differs from the input";
+	}
+	return NULL;
+}
+
+static const char *bench_check_capture_store(bench_t *b, const bench_output_t *out)
+{
+	if (b->width & 3)
+		return NULL;
+	if (b->cstore.count != 1)
+		return "capture refused";
+	return memcmp(b->decoded, b->ycc, b->width * b->height * sizeof(Xuint16)) ? "decompressed frame differs" : NULL;
+}
+
+// Every view pixel straight from the source: nearest neighbour, Cb/Cr
+// from the pair it falls in
+static const char *bench_check_zoom(bench_t *b, const bench_output_t *out)
+{
+	const zoom_t *z = &b->zoom;
+	const Xuint16 *line;
+	int x, y, sx, sy, pair;
+	Xuint16 want;
+
+	if (!b->zoom_ok)
+		return NULL;
+	if (z->renders != 2 * b->frames || z->moves != 2 * b->frames)
+		return "pans rendered the canvas";
+	for (y = 0; y < b->height; y++) {
+		sy = ((z->vy + y) * 256 + 128) / z->factor;
+		line = b->ycc + (sy < b->height ? sy : b->height - 1) * b->width;
+		for (x = 0; x < b->width; x++) {
+			sx = ((z->vx + x) * 256 + 128) / z->factor;
+			pair = (((z->vx + x) & ~1) * 256 + 128) / z->factor;
+			sx = sx < b->width ? sx : b->width - 1;
+			pair = (pair < b->width ? pair : b->width - 1) & ~1;
+			want = (line[sx] & 0x00FF) | (line[pair + ((z->vx + x) & 1)] & 0xFF00);
+			if (b->zoom_view[y * b->width + x] != want)
+				return "view differs from the scaled source";
+		}
+	}
+	return NULL;
+}
+
+// The rgb2ycrcb core as its equations go: Q16 coefficients, Y rounded to
+// an integer before the chroma differences use it, each channel rounded,
+// offset and clipped
+static void bench_csc_core(const struct rgb_coef_outputs *core, int R, int G, int B, int out[3])
+{
+	int Y, Cb, Cr;
+
+	Y = (core->acoef * (R - G) + core->bcoef * (B - G) + (1 << 15)) >> 16;
+	Y += G;
+	Cr = ((core->ccoef * (R - Y) + (1 << 15)) >> 16) + core->croffset;
+	Cb = ((core->dcoef * (B - Y) + (1 << 15)) >> 16) + core->cboffset;
+	Y += core->yoffset;
+
+	out[CSC_Y] = (Y < core->ymin) ? core->ymin : (Y > core->ymax) ? core->ymax : Y;
+	out[CSC_CB] = (Cb < core->cbmin) ? core->cbmin : (Cb > core->cbmax) ? core->cbmax : Cb;
+	out[CSC_CR] = (Cr < core->crmin) ? core->crmin : (Cr > core->crmax) ? core->crmax : Cr;
+}
+
+// csc_component() with csc_coef_from_core()'s parameters against that
+// datapath, for every 8-bit RGB value: bit exact
+static const char *bench_check_csc(bench_t *b, const bench_output_t *out)
+{
+	struct rgb_coef_inputs core_in;
+	struct rgb_coef_outputs core;
+	int want[3], got, d, c, R, G, B;
+
+	RGB_select_standard(CSC_STANDARD, CSC_INPUT_RANGE, CSC_DATA_WIDTH, &core_in);
+	if (RGB_coefficient_translation(&core_in, &core, CSC_DATA_WIDTH) != 0)
+		return NULL;
+
+	memset(b->csc_off, 0, sizeof(b->csc_off));
+	b->csc_worst = 0;
+	for (R = 0; R < 256; R++) {
+		for (G = 0; G < 256; G++) {
+			for (B = 0; B < 256; B++) {
+				bench_csc_core(&core, R, G, B, want);
+				for (c = 0; c < 3; c++) {
+					got = csc_component(&b->coef8, c, R, G, B);
+					d = abs(got - want[c]);
+					if (d) {
+						b->csc_off[c]++;
+						b->csc_worst = (d > b->csc_worst) ? d : b->csc_worst;
+					}
+				}
+			}
+		}
+	}
+	return b->csc_worst ? "differs from the rgb2ycrcb datapath" : NULL;
+}
+
+static const char *bench_check_bayer(bench_t *b, const bench_output_t *out)
+{
+	return memcmp(out->data[0], b->bayer, out->bytes) ? "differs from the input frame" : NULL;
+}
+
+static const char *bench_check_dma_copy(bench_t *b, const bench_output_t *out)
+{
+	if (b->dma_done != 2 * b->frames)
+		return "callbacks missing";
+	return bench_check_bayer(b, out);
+}
+
+// The vector kernel against the scalar one, where there is one (on the
+// host, only in a NEON=1 build)
+static const char *bench_check_mhc(bench_t *b, const bench_output_t *out)
+{
+	int c;
+
+	if (!DEMOSAIC_HAVE_NEON)
+		return NULL;
+
+	bench_demosaic_mhc(b, b->scratch, 1);
+	for (c = 0; c < 3; c++) {
+		if (memcmp(out->data[c], b->scratch[c], out->bytes))
+			return "NEON differs from the reference kernel";
+	}
+	return NULL;
+}
+
+// The statistics against the scalar kernel on the same quad rows, and the
+// frame (converted before the gains changed) against demosaic + csc
+static const char *bench_check_awb(bench_t *b, const bench_output_t *out)
+{
+	const Xuint16 *above, *even, *odd, *below;
+	int y;
+
+	memset(&b->awb_ref, 0, sizeof(b->awb_ref));
+	lbuf_init(&b->lbuf, b->bayer, b->width, b->height, b->width, 0, b->height, DEMOSAIC_BILINEAR_APRON, NULL, NULL);
+	for (y = 0; y < b->height; y += 2) {
+		lbuf_quad_row(&b->lbuf, y, &above, &even, &odd, &below);
+		if ((y >> 1) % AWB_ROW_STEP == 0)
+			awb_stats_quad_row_ref(&b->awb_ref, even, odd, b->width);
+	}
+	if (memcmp(&b->awb.last, &b->awb_ref, sizeof(b->awb_ref)))
+		return "statistics differ from the reference kernel";
+	if (memcmp(b->awb_ycc, b->ycc, b->width * b->height * sizeof(Xuint16)))
+		return "frame differs from demosaic + csc";
+	return NULL;
+}
+
+// Level below which permille/1000 of the grid quads lie, as aec.h
+// describes it
+static Xuint32 bench_aec_level(const aec_stats_t *ref, Xuint32 permille)
+{
+	Xuint32 rank = ref->samples * permille / 1000, below = 0;
+	int bin;
+
+	for (bin = 0; bin < AEC_HIST_BINS - 1 && below + ref->hist[bin] <= rank; bin++)
+		below += ref->hist[bin];
+	return (bin << AEC_BIN_SHIFT) + (ref->hist[bin] ? ((rank - below) << AEC_BIN_SHIFT) / ref->hist[bin] : 0);
+}
+
+// The statistics against a plain walk over the grid, and the settings
+// against the metered median and highlights: moved the right way, and
+// written to the sensor
+static const char *bench_check_aec(bench_t *b, const bench_output_t *out)
+{
+	aec_setting_t start = { 90, 0, AEC_DGAIN_UNITY };
+	const Xuint16 *even, *odd;
+	Xuint32 median, bright, total, start_total = aec_total(&start);
+	int x, y, level, clip, c, up, down;
+	int s[4];
+
+	memset(&b->aec_ref, 0, sizeof(b->aec_ref));
+	for (y = 0; y < b->height; y += 2 * AEC_ROW_STEP) {
+		even = b->bayer + y * b->width;
+		odd = even + b->width;
+		for (x = 0; x + 1 < b->width; x += 2 * AEC_COL_STEP) {
+			s[0] = BAYER_PIXEL(even[x]);
+			s[1] = BAYER_PIXEL(even[x+1]);
+			s[2] = BAYER_PIXEL(odd[x]);
+			s[3] = BAYER_PIXEL(odd[x+1]);
+			level = 0;
+			clip = 0;
+			for (c = 0; c < 4; c++) {
+				level += s[c];
+				clip |= s[c] >= AEC_CLIP_LEVEL;
+			}
+			level >>= 2;
+			b->aec_ref.hist[level >> AEC_BIN_SHIFT]++;
+			b->aec_ref.sum += level;
+			b->aec_ref.samples++;
+			b->aec_ref.clipped += clip;
+		}
+	}
+	if (memcmp(&b->aec.last, &b->aec_ref, sizeof(b->aec_ref)))
+		return "statistics differ from the grid walk";
+	if (b->aec_ref.samples < AEC_MIN_SAMPLES)
+		return NULL;
+
+	median = bench_aec_level(&b->aec_ref, 500);
+	bright = bench_aec_level(&b->aec_ref, AEC_BRIGHT_PERMILLE);
+	down = median > AEC_TARGET_LEVEL || bright > AEC_BRIGHT_LEVEL ||
+			b->aec_ref.clipped * 1000 > AEC_CLIP_PERMILLE * b->aec_ref.samples;
+	up = !down && median < AEC_TARGET_LEVEL && bright < AEC_BRIGHT_LEVEL;
+	total = aec_total(&b->aec.current);
+	if (b->aec.updates != b->aec.batches)
+		return "new settings were not applied";
+	if ((b->aec.current.exposure != start.exposure && b->vita.uExposureTime != b->aec.current.exposure) ||
+			(b->aec.current.again != start.again && b->vita.uAnalogGain != b->aec.current.again) ||
+			(b->aec.current.dgain != start.dgain && b->vita.uDigitalGain != b->aec.current.dgain))
+		return "sensor does not have the new settings";
+	if ((up && total < start_total && b->aec.current.exposure < AEC_EXPOSURE_MAX) ||
+			(down && total > start_total))
+		return "exposure moved the wrong way";
+	return NULL;
+}
+
+// Straight from tnr.h, a pixel at a time, on the fused output of the
+// noisy frame and the clean frame as the history
+static int bench_tnr_alpha(int diff)
+{
+	int slope = (TNR_ALPHA_ONE - TNR_ALPHA_MIN + TNR_MOTION_LEVEL - TNR_NOISE_LEVEL - 1) / (TNR_MOTION_LEVEL - TNR_NOISE_LEVEL);
+	int a = TNR_ALPHA_MIN + ((diff > TNR_NOISE_LEVEL) ? (diff - TNR_NOISE_LEVEL) * slope : 0);
+
+	return (a < TNR_ALPHA_ONE) ? a : TNR_ALPHA_ONE;
+}
+
+static const char *bench_check_tnr(bench_t *b, const bench_output_t *out)
+{
+	const Xuint16 *tnr = out->data[0];
+	int n = b->width * b->height;
+	int i, k, a[2], ac, c, h, v;
+
+	amp_isp_frame(&b->fused_pipe, b->noisy, b->noisy_ycc, b->width, b->height);
+	for (i = 0; i < n; i += 2) {
+		for (k = 0; k < 2; k++) {
+			a[k] = bench_tnr_alpha(abs((b->noisy_ycc[i + k] & 0xFF) - (b->ycc[i + k] & 0xFF)));
+		}
+		ac = (a[0] > a[1]) ? a[0] : a[1];
+		for (k = 0; k < 2; k++) {
+			c = b->noisy_ycc[i + k];
+			h = b->ycc[i + k];
+			v = ((c & 0xFF) * a[k] + (h & 0xFF) * (TNR_ALPHA_ONE - a[k]) + 128) >> 8;
+			v |= (((c >> 8) * ac + (h >> 8) * (TNR_ALPHA_ONE - ac) + 128) >> 8) << 8;
+			if (tnr[i + k] != v)
+				return "differs from the filter applied a pixel at a time";
+		}
+	}
+
+	return memcmp(b->tnr_history, tnr, out->bytes) ? "history differs from the output" : NULL;
+}
+
+// Output level (0..255, unrounded) of a preset for LUT entry i, from libm
+static double bench_tone_level(int preset, int i)
+{
+	double x = (double)i / BAYER_MAX;
+
+	switch (preset) {
+	case TONE_PRESET_SRGB:
+		x = (x <= 0.0031308) ? 12.92 * x : 1.055 * pow(x, 1 / 2.4) - 0.055;
+		break;
+	case TONE_PRESET_BT709:
+		x = (x < 0.018) ? 4.5 * x : 1.099 * pow(x, 0.45) - 0.099;
+		break;
+	case TONE_PRESET_LOG:
+		x = log(1 + TONE_LOG_K * x) / log(1 + TONE_LOG_K);
+		break;
+	default:
+		// Not a curve: the sensor depth shifted down to 8 bits
+		return (double)i * 256 / (BAYER_MAX + 1);
+	}
+	return x * 255;
+}
+
+// Every entry of every preset the nearest level to the libm curve. The
+// float approximations in tone.c may round the other way only within
+// BENCH_TONE_SLACK of halfway.
+#define BENCH_TONE_SLACK 0.01
+
+static const char *bench_check_tone_presets(void)
+{
+	isp_gamma_t lut;
+	double want;
+	int preset, i;
+
+	for (preset = 0; preset < TONE_NUM_PRESETS; preset++) {
+		tone_build_preset(&lut, preset);
+		for (i = 0; i < ISP_TONE_LUT_SIZE; i++) {
+			want = bench_tone_level(preset, i);
+			want = (want > 255) ? 255 : want;
+			if (fabs(lut.lut[i] - want) > 0.5 + BENCH_TONE_SLACK)
+				return "a preset LUT is off the libm curve";
+		}
+	}
+	return NULL;
+}
+
+// The presets against libm, then the demosaicked planes through a freshly
+// built sRGB LUT and the converter, against the frame from the
+// swapped-in back LUT
+static const char *bench_check_tone(bench_t *b, const bench_output_t *out)
+{
+	isp_gamma_t lut;
+	rgb_line_t line;
+	const char *fail;
+	int c, i, y, offset;
+
+	if (b->tone_srgb.active != 1 || b->tone_srgb.pending)
+		return "sRGB curve was not swapped in";
+	fail = bench_check_tone_presets();
+	if (fail)
+		return fail;
+	tone_build_preset(&lut, TONE_PRESET_SRGB);
+	for (c = 0; c < 3; c++) {
+		for (i = 0; i < b->width * b->height; i++) {
+			b->scratch[c][i] = lut.lut[b->rgb[c][i] & BAYER_MAX];
+		}
+	}
+	for (y = 0; y < b->height; y++) {
+		offset = y * b->width;
+		line.R = b->scratch[0] + offset;
+		line.G = b->scratch[1] + offset;
+		line.B = b->scratch[2] + offset;
+		csc_convert_line(&b->coef8, &line, b->ref_ycc + offset, 0, b->width);
+	}
+	return memcmp(out->data[0], b->ref_ycc, out->bytes) ? "differs from demosaic + sRGB LUT + csc" : NULL;
+}
+
+// The scalar binning kernel, the LUT and the converter line by line,
+// against the whole frame (so nothing was written outside the preview)
+static const char *bench_check_bin(bench_t *b, const bench_output_t *out)
+{
+	int w = b->width / 2;
+	rgb_line_t line;
+	int c, x, y;
+
+	if (b->width & 3)
+		return NULL;
+	line.R = b->scratch[0];
+	line.G = b->scratch[1];
+	line.B = b->scratch[2];
+	memset(b->ref_ycc, 0, out->bytes);
+	for (y = 0; y < b->height; y += 2) {
+		demosaic_bin2_quad_row_ref(b->bayer + y * b->width, b->bayer + (y + 1) * b->width, &line, b->width);
+		for (c = 0; c < 3; c++) {
+			for (x = 0; x < w; x++) {
+				b->scratch[c][x] = b->tone.lut[0].lut[b->scratch[c][x]];
+			}
+		}
+		csc_convert_line(&b->coef8, &line, b->ref_ycc + bench_preview_offset(b) + y / 2 * b->width, 0, w);
+	}
+	return memcmp(out->data[0], b->ref_ycc, out->bytes) ? "differs from the scalar bin + LUT + csc" : NULL;
+}
+
+// Each ROI against the whole pipeline run on a copy of just that
+// rectangle, and everything else against the input
+static const char *bench_check_roi(bench_t *b, const bench_output_t *out)
+{
+	const roi_rect_t *r;
+	Xuint16 *crop = b->scratch[0];
+	Xuint16 *crop_ycc = b->scratch[1];
+	int i, x, y, offset;
+
+	if (b->rois.dma_pieces == 0 || b->rois.cpu_pieces || b->rois.dma_errors)
+		return "pass-through did not all go through the DMA";
+
+	memcpy(b->ref_ycc, b->bayer, out->bytes);
+	for (i = 0; i < b->rois.num_rects; i++) {
+		r = &b->rois.rect[i];
+		for (y = 0; y < r->h; y++) {
+			memcpy(crop + y * r->w, b->bayer + (r->y + y) * b->width + r->x, r->w * sizeof(Xuint16));
+		}
+		amp_isp_frame(&b->fused_pipe, crop, crop_ycc, r->w, r->h);
+		for (y = 0; y < r->h; y++) {
+			offset = (r->y + y) * b->width + r->x;
+			for (x = 0; x < r->w; x++) {
+				b->ref_ycc[offset + x] = crop_ycc[y * r->w + x];
+			}
+		}
+	}
+	return memcmp(out->data[0], b->ref_ycc, out->bytes) ? "differs from the ROIs processed alone + the input" : NULL;
+}
+
+static const bench_stage_t bench_stages[] = {
+	{ "demosaic",       bench_run_demosaic,       bench_out_demosaic,       NULL },
+	{ "demosaic_mhc",   bench_run_demosaic_mhc,   bench_out_demosaic_mhc,   bench_check_mhc },
+	{ "csc",            bench_run_csc,            bench_out_csc,            bench_check_csc },
+	{ "isp_fused",      bench_run_isp_fused,      bench_out_isp_fused,      bench_check_ycc },
+	{ "isp_vres",       bench_run_isp_vres,       bench_out_isp_vres,       bench_check_ycc },
+	{ "isp_staged",     bench_run_isp_staged,     bench_out_isp_staged,     bench_check_ycc },
+	{ "isp_mhc",        bench_run_isp_mhc,        bench_out_isp_mhc,        NULL },
+	{ "isp_awb",        bench_run_isp_awb,        bench_out_isp_awb,        bench_check_awb },
+	{ "isp_aec",        bench_run_isp_aec,        bench_out_isp_aec,        bench_check_aec },
+	{ "isp_tnr",        bench_run_isp_tnr,        bench_out_isp_tnr,        bench_check_tnr },
+	{ "isp_tone",       bench_run_isp_tone,       bench_out_isp_tone,       bench_check_tone },
+	{ "isp_fused_tone", bench_run_isp_fused_tone, bench_out_isp_fused_tone, bench_check_tone },
+	{ "isp_bin",        bench_run_isp_bin,        bench_out_isp_bin,        bench_check_bin },
+	{ "isp_roi",        bench_run_isp_roi,        bench_out_isp_roi,        bench_check_roi },
+	{ "capture_copy",   bench_run_capture_copy,   bench_out_capture_copy,   bench_check_bayer },
+	{ "playback_copy",  bench_run_playback_copy,  bench_out_playback_copy,  bench_check_bayer },
+	{ "dma_copy",       bench_run_dma_copy,       bench_out_dma_copy,       bench_check_dma_copy },
+	{ "raw10",          bench_run_raw10,          bench_out_raw10,          bench_check_raw10 },
+	{ "capture_store",  bench_run_capture_store,  bench_out_capture_store,  bench_check_capture_store },
+	{ "zoom",           bench_run_zoom,           bench_out_zoom,           bench_check_zoom },
+};
+
+#define BENCH_NUM_STAGES (int)(sizeof(bench_stages) / sizeof(bench_stages[0]))
+
+static Xuint32 bench_output_crc(const bench_output_t *out)
+{
+	Xuint32 crc = 0;
+	int i;
+
+	for (i = 0; i < 3 && out->data[i]; i++) {
+		crc = crc_update(crc, out->data[i], out->bytes);
+	}
+	return crc;
+}
+
+// Write or compare dir/<stage>.raw
+static int bench_write_image(const char *dir, const char *name, const bench_output_t *out)
+{
+	char path[512];
+	FILE *f;
+	int i;
+
+	snprintf(path, sizeof(path), "%s/%s.raw", dir, name);
+	f = fopen(path, "wb");
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+	for (i = 0; i < 3 && out->data[i]; i++) {
+		fwrite(out->data[i], 1, out->bytes, f);
+	}
+	fclose(f);
+	return 0;
+}
+
+// Number of 16-bit words that differ from dir/<stage>.raw, or -1
+static long bench_compare_image(const char *dir, const char *name, const bench_output_t *out)
+{
+	char path[512];
+	Xuint16 *golden;
+	long mismatches = 0;
+	long first = -1;
+	int words = out->bytes / sizeof(Xuint16);
+	const Xuint16 *p;
+	FILE *f;
+	int i, w;
+
+	snprintf(path, sizeof(path), "%s/%s.raw", dir, name);
+	f = fopen(path, "rb");
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+
+	golden = bench_alloc(out->bytes);
+	for (i = 0; i < 3 && out->data[i]; i++) {
+		if (fread(golden, 1, out->bytes, f) != (size_t)out->bytes) {
+			fprintf(stderr, "%s: too short\n", path);
+			mismatches = -1;
+			break;
+		}
+		p = (const Xuint16 *)out->data[i];
+		for (w = 0; w < words; w++) {
+			if (p[w] != golden[w]) {
+				if (first < 0)
+					first = (long)i * words + w;
+				mismatches++;
+			}
+		}
+	}
+	free(golden);
+	fclose(f);
+
+	if (first >= 0)
+		printf("    %s: first difference at word %ld\n", path, first);
+	return mismatches;
+}
+
+static int bench_load_golden(const char *path, bench_golden_t *golden)
+{
+	FILE *f = fopen(path, "r");
+	char line[256];
+	int n = 0;
+
+	if (!f)
+		return 0;
+	while (n < BENCH_MAX_GOLDEN && fgets(line, sizeof(line), f)) {
+		if (line[0] == '#')
+			continue;
+		if (sscanf(line, "%31s %dx%d %lx %lx", golden[n].name, &golden[n].width, &golden[n].height,
+				&golden[n].input_crc, &golden[n].output_crc) == 5)
+			n++;
+	}
+	fclose(f);
+	return n;
+}
+
+static const bench_golden_t *bench_find_golden(const bench_golden_t *golden, int n, const bench_golden_t *key)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (!strcmp(golden[i].name, key->name) && golden[i].width == key->width && golden[i].height == key->height
+				&& golden[i].input_crc == key->input_crc)
+			return &golden[i];
+	}
+	return NULL;
+}
+
+// PSNR of lines [y_start, y_end) of a demosaicked plane against the
+// scene, in dB
+static double bench_psnr(bench_t *b, const uint16_t *plane, const Xuint8 *truth, int y_start, int y_end)
+{
+	int n = (y_end - y_start) * b->width;
+	double sse = 0, d;
+	int i;
+
+	plane += y_start * b->width;
+	truth += y_start * b->width;
+	for (i = 0; i < n; i++) {
+		d = (double)plane[i] / (1 << (BAYER_BITS - 8)) - truth[i];
+		sse += d * d;
+	}
+	return (sse == 0) ? 99.0 : 10 * log10(255.0 * 255.0 * n / sse);
+}
+
+// Scored separately on the two halves of the scene: the gradient
+// correction assumes the colour channels move together, which holds for
+// the zone plate (and most real scenes) but not at the edges between
+// saturated colour bars
+static void bench_quality(bench_t *b)
+{
+	static const char *names[2] = { "demosaic", "demosaic_mhc" };
+	uint16_t **planes[2] = { b->rgb, b->mhc };
+	int half[3] = { 0, b->height / 2, b->height };
+	int k, h, c;
+
+	printf("Demosaic quality against the scene, PSNR dB (R G B):\n");
+	printf("  %-14s %-22s %s\n", "", "colour bars", "zone plate");
+	for (k = 0; k < 2; k++) {
+		printf("  %-14s", names[k]);
+		for (h = 0; h < 2; h++) {
+			for (c = 0; c < 3; c++) {
+				printf(" %6.2f", bench_psnr(b, planes[k][c], b->truth[c], half[h], half[h + 1]));
+			}
+			printf("  ");
+		}
+		printf("\n");
+	}
+}
+
+// What the temporal filter costs on top of the fused stage (from the
+// stages' own timers, so without seeding the history) and how much of the
+// added noise it takes out
+static void bench_tnr_report(bench_t *b)
+{
+	isp_pipeline_t *pipe = &b->tnr_pipe;
+	u64 t[2] = { 0, 0 };
+	double err[2] = { 0, 0 };
+	int n = b->width * b->height;
+	int s, cpu, i;
+
+	if (pipe->frames == 0)
+		return;
+	for (s = 0; s < 2; s++) {
+		for (cpu = 0; cpu < AMP_NUM_CPUS; cpu++) {
+			t[s] += pipe->stage[s].cycles[cpu];
+		}
+	}
+	for (i = 0; i < n; i++) {
+		err[0] += abs((b->noisy_ycc[i] & 0xFF) - (b->ycc[i] & 0xFF));
+		err[1] += abs((b->tnr_ycc[i] & 0xFF) - (b->ycc[i] & 0xFF));
+	}
+
+	printf("TNR at %dx%d: %.3f ms/frame on top of %.3f ms/frame for the fused stage (+%.0f%%)\n",
+			b->width, b->height, t[1] / 1e6 / pipe->frames, t[0] / 1e6 / pipe->frames, 100.0 * t[1] / t[0]);
+	printf("  mean |Y error| against the clean frame: %.2f unfiltered, %.2f filtered\n", err[0] / n, err[1] / n);
+}
+
+// How much the store saves on the clean frame and on the noisy one (closer
+// to a real sensor's), and what playback costs
+static void bench_cstore_report(bench_t *b)
+{
+	static cstore_t store;
+	Xuint16 *frames[2] = { b->ycc, b->noisy_ycc };
+	double ratio[2], ms = 0;
+	Xuint8 *pool;
+	int count[2];
+	u64 t0;
+	int i;
+
+	if (b->width & 3)
+		return;
+	cstore_init(&b->cstore, b->cstore_pool, b->cstore_pool_bytes);
+	for (i = 0; i < 2; i++) {
+		cstore_put_422(&b->cstore, frames[i], b->width, b->height);
+		ratio[i] = (double)b->width * b->height * sizeof(Xuint16) / b->cstore.entry[i].bytes;
+		t0 = mock_ns();
+		cstore_decode_frame(&b->cstore, i, b->decoded);
+		ms += (mock_ns() - t0) / 1e6;
+		if (memcmp(b->decoded, frames[i], b->width * b->height * sizeof(Xuint16)) != 0)
+			printf("Capture store: frame %d does not decompress to itself\n", i);
+	}
+	printf("Capture store at %dx%d: %.2fx on the clean frame, %.2fx on the noisy one, %.3f ms to decompress\n",
+			b->width, b->height, ratio[0], ratio[1], ms / 2);
+
+	// Filled for real, as the refusal needs the worst case free (the CPU
+	// alone writes it, so not bench_alloc())
+	pool = malloc(BENCH_CSTORE_POOL_MB << 20);
+	if (!pool)
+		return;
+	for (i = 0; i < 2; i++) {
+		cstore_init(&store, pool, BENCH_CSTORE_POOL_MB << 20);
+		while (cstore_put_422(&store, frames[i], b->width, b->height) >= 0)
+			;
+		count[i] = store.count;
+	}
+	free(pool);
+	printf("  a %d MB pool (part 7's) holds %d clean or %d noisy captures\n", BENCH_CSTORE_POOL_MB, count[0], count[1]);
+}
+
+// The CPU's share of a frame copy each way: amp_copy_frame() (on one core
+// here, on both on the board) against the DMA queue part 7 uses, where
+// the PL330 does the copy. The mock PL330 copies on the host CPU, so its
+// time is taken out of the queue's and shown on its own.
+static void bench_copy_report(bench_t *b)
+{
+	static dmaq_t q;
+	u64 copy_ns = 0, queue_ns = 0, engine_ns;
+	u64 t0;
+	int i;
+
+	dmaq_init(&q, &b->copy_dma);
+	engine_ns = mock_stats.dma_ns;
+	for (i = 0; i < b->frames; i++) {
+		t0 = mock_ns();
+		amp_copy_frame(bench_s2mm_frame(), b->dma_frame, NULL, b->width, b->height);
+		copy_ns += mock_ns() - t0;
+
+		t0 = mock_ns();
+		dmaq_copy_frame(&q, bench_s2mm_frame(), b->dma_frame, b->width, b->height, NULL, NULL);
+		dmaq_wait(&q);
+		queue_ns += mock_ns() - t0;
+	}
+	engine_ns = mock_stats.dma_ns - engine_ns;
+
+	printf("Frame copy at %dx%d, CPU ms/copy: %.3f amp_copy_frame, %.3f DMA queue (%d of %d copies on the CPU)\n",
+			b->width, b->height, copy_ns / 1e6 / b->frames, (queue_ns - engine_ns) / 1e6 / b->frames,
+			(int)q.cpu_copies, (int)q.copies);
+	printf("  and %.3f ms/copy in the mock PL330, which the board does off the CPU\n", engine_ns / 1e6 / b->frames);
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: bench [-s WIDTHxHEIGHT] [-n frames] [-i bayer.raw] [-c golden.txt] [-u] [-o dir] [-g dir]\n"
+		"  -s  frame size (default 1920x1080)\n"
+		"  -n  frames timed per path (default %d)\n"
+		"  -i  recorded Bayer frame instead of the synthetic scene\n"
+		"  -c  check output CRCs against a golden file\n"
+		"  -u  with -c: rewrite the golden file from this run instead\n"
+		"  -o  write each path's output to dir/<path>.raw\n"
+		"  -g  compare each path's output with dir/<path>.raw\n",
+		BENCH_DEFAULT_FRAMES);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	static bench_t bench;
+	bench_t *b = &bench;
+	bench_golden_t golden[BENCH_MAX_GOLDEN];
+	bench_golden_t result[BENCH_NUM_STAGES];
+	const bench_golden_t *ref;
+	const bench_stage_t *stage;
+	const char *input = NULL, *golden_file = NULL, *out_dir = NULL, *golden_dir = NULL;
+	bench_output_t out;
+	const char *problem;
+	int update = 0, failures = 0, num_golden = 0;
+	Xuint32 input_crc;
+	u64 t0, ns;
+	long diff;
+	int opt, s, f;
+	FILE *gf;
+
+	b->width = 1920;
+	b->height = 1080;
+	b->frames = BENCH_DEFAULT_FRAMES;
+
+	while ((opt = getopt(argc, argv, "s:n:i:c:uo:g:")) != -1) {
+		switch (opt) {
+		case 's':
+			if (sscanf(optarg, "%dx%d", &b->width, &b->height) != 2)
+				usage();
+			break;
+		case 'n': b->frames = atoi(optarg); break;
+		case 'i': input = optarg; break;
+		case 'c': golden_file = optarg; break;
+		case 'u': update = 1; break;
+		case 'o': out_dir = optarg; break;
+		case 'g': golden_dir = optarg; break;
+		default: usage();
+		}
+	}
+	if (b->width < 4 || b->width > DEMOSAIC_MAX_WIDTH || (b->width & 1) || b->height < 2 || (b->height & 1)
+			|| b->frames < 1 || (update && !golden_file)) {
+		usage();
+	}
+
+	crc_init();
+	bench_init(b);
+	if (input) {
+		if (bench_read_frame(b, input) != 0)
+			return 1;
+	} else {
+		for (s = 0; s < 3; s++) {
+			b->truth[s] = bench_alloc(b->width * b->height);
+		}
+		bench_synthetic_frame(b);
+	}
+	input_crc = crc_update(0, b->bayer, b->width * b->height * sizeof(Xuint16));
+	bench_noisy_frame(b);
+
+	// The frame the S2MM channel "wrote"
+	memcpy(bench_s2mm_frame(), b->bayer, b->width * b->height * sizeof(Xuint16));
+
+	if (golden_file && !update)
+		num_golden = bench_load_golden(golden_file, golden);
+
+	printf("%dx%d %s frame (crc %08lx), %d frames per path\n", b->width, b->height,
+			input ? input : "synthetic", input_crc, b->frames);
+	printf("%-16s %10s %10s %14s  %s\n", "path", "ms/frame", "MPix/s", "flush KB/frame", "check");
+
+	for (s = 0; s < BENCH_NUM_STAGES; s++) {
+		stage = &bench_stages[s];
+		mock_reset_stats();
+
+		t0 = mock_ns();
+		for (f = 0; f < b->frames; f++) {
+			stage->run(b);
+		}
+		ns = mock_ns() - t0;
+
+		printf("%-16s %10.3f %10.1f %14lu  ", stage->name, ns / 1e6 / b->frames,
+				(double)b->width * b->height * b->frames * 1e3 / ns,
+				(unsigned long)(mock_stats.flush_bytes / b->frames / 1024));
+
+		stage->output(b, &out);
+		strcpy(result[s].name, stage->name);
+		result[s].width = b->width;
+		result[s].height = b->height;
+		result[s].input_crc = input_crc;
+		result[s].output_crc = bench_output_crc(&out);
+
+		if (stage->check && (problem = stage->check(b, &out)) != NULL) {
+			printf("FAIL (%s) ", problem);
+			failures++;
+		}
+		if (golden_file && !update) {
+			ref = bench_find_golden(golden, num_golden, &result[s]);
+			if (!ref) {
+				printf("no golden CRC ");
+			} else if (ref->output_crc != result[s].output_crc) {
+				printf("FAIL (crc %08lx, golden %08lx) ", result[s].output_crc, ref->output_crc);
+				failures++;
+			} else {
+				printf("crc ok ");
+			}
+		}
+		printf("\n");
+
+		if (out_dir && bench_write_image(out_dir, stage->name, &out) != 0)
+			failures++;
+		if (golden_dir) {
+			diff = bench_compare_image(golden_dir, stage->name, &out);
+			if (diff != 0) {
+				printf("    %s: %ld words differ from the golden image\n", stage->name, diff);
+				failures++;
+			}
+		}
+	}
+
+	if (b->truth[0])
+		bench_quality(b);
+	printf("RAW10 capture: %d KB per frame, %d KB as S2MM words\n", RAW10_FRAME_BYTES(b->width, b->height) / 1024,
+			(int)(b->width * b->height * sizeof(Xuint16) / 1024));
+	printf("CSC against the rgb2ycrcb datapath, every 8-bit RGB: Y %.2f%%, Cb %.2f%%, Cr %.2f%% off by %d\n",
+			100.0 * b->csc_off[CSC_Y] / (1 << 24), 100.0 * b->csc_off[CSC_CB] / (1 << 24),
+			100.0 * b->csc_off[CSC_CR] / (1 << 24), b->csc_worst);
+	bench_tnr_report(b);
+	bench_cstore_report(b);
+	bench_copy_report(b);
+	isp_report(&b->vres_pipe);
+	isp_time_kernels(&b->vres_pipe);
+	isp_report(&b->staged_pipe);
+	isp_report(&b->mhc_pipe);
+	isp_report(&b->awb_pipe);
+	awb_report(&b->awb);
+	aec_report(&b->aec);
+	roi_report(&b->rois, b->width, b->height);
+	dma2d_report(&b->dma);
+	dmaq_report(&b->copyq);
+	zoom_report(&b->zoom);
+
+	if (update) {
+		gf = fopen(golden_file, "w");
+		if (!gf) {
+			perror(golden_file);
+			return 1;
+		}
+		fprintf(gf, "# path WIDTHxHEIGHT input-crc output-crc, written by bench -u\n");
+		for (s = 0; s < BENCH_NUM_STAGES; s++) {
+			fprintf(gf, "%s %dx%d %08lx %08lx\n", result[s].name, result[s].width, result[s].height,
+					result[s].input_crc, result[s].output_crc);
+		}
+		fclose(gf);
+		printf("Wrote %s\n", golden_file);
+	}
+
+	if (failures)
+		printf("%d check(s) failed\n", failures);
+	return failures ? 1 : 0;
+}
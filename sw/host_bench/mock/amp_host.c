@@ -0,0 +1,151 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * amp_host.c - Host build of amp.c. There is no core 1, OCM mailbox or
+ * event signalling on the host, so every job runs on "core 0" exactly as
+ * amp.c runs it when core 1 is offline: one band covering the whole frame.
+ *****************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "xil_io.h"
+#include "xil_cache.h"
+#include "xil_printf.h"
+#include "xstatus.h"
+#include "amp.h"
+#include "isp.h"
+#include "capture_store.h"
+#include "zoom.h"
+
+static line_buffer_t amp_lbuf;
+
+static u64 amp_busy_ticks;
+static Xuint32 amp_jobs;
+
+int amp_cpu1_online(void)
+{
+	return 0;
+}
+
+int amp_cpu_id(void)
+{
+	return 0;
+}
+
+u64 amp_time(void)
+{
+	Xuint32 hi, lo;
+
+	do {
+		hi = Xil_In32(AMP_GTIMER_BASE + 0x4);
+		lo = Xil_In32(AMP_GTIMER_BASE + 0x0);
+	} while (hi != Xil_In32(AMP_GTIMER_BASE + 0x4));
+
+	return ((u64)hi << 32) | lo;
+}
+
+void amp_pmu_enable(void)
+{
+}
+
+// One core, so no L2 lock
+void amp_dcache_flush_range(const void *adr, int bytes)
+{
+	Xil_DCacheFlushRange((unsigned int)(uintptr_t)adr, bytes);
+}
+
+void amp_dcache_invalidate_range(const void *adr, int bytes)
+{
+	Xil_DCacheInvalidateRange((unsigned int)(uintptr_t)adr, bytes);
+}
+
+int amp_isp_region(isp_pipeline_t *pipe, const Xuint16 *src, Xuint16 *dst, int width, int height, int stride)
+{
+	u64 t0 = amp_time();
+	int errors;
+
+	lbuf_init(&amp_lbuf, src, width, height, stride, 0, height, pipe->apron, NULL, NULL);
+	errors = isp_run_rows(pipe, &amp_lbuf, dst, 0, height);
+
+	amp_busy_ticks += amp_time() - t0;
+	amp_jobs++;
+	return errors;
+}
+
+int amp_isp_frame(isp_pipeline_t *pipe, const Xuint16 *src, Xuint16 *dst, int width, int height)
+{
+	int errors = amp_isp_region(pipe, src, dst, width, height, width);
+
+	pipe->pixels = (width / pipe->bin) * (height / pipe->bin);
+	pipe->frames++;
+	return errors;
+}
+
+// As amp_copy_rows() over the whole frame
+void amp_copy_frame(const Xuint16 *src, Xuint16 *dst, Xuint16 *dst2, int width, int height)
+{
+	int bytes = width * height * sizeof(Xuint16);
+	u64 t0 = amp_time();
+
+	amp_dcache_invalidate_range(src, bytes);
+	memcpy(dst, src, bytes);
+	amp_dcache_flush_range(dst, bytes);
+	if (dst2) {
+		memcpy(dst2, dst, bytes);
+		amp_dcache_flush_range(dst2, bytes);
+	}
+
+	amp_busy_ticks += amp_time() - t0;
+	amp_jobs++;
+}
+
+void amp_decode_frame(const cstore_entry_t *capture, Xuint16 *dst, int width, int height)
+{
+	u64 t0 = amp_time();
+
+	cstore_decode_rows(capture, dst, width, 0, height);
+
+	amp_busy_ticks += amp_time() - t0;
+	amp_jobs++;
+}
+
+void amp_zoom_render(const zoom_t *zoom)
+{
+	u64 t0 = amp_time();
+
+	zoom_render_rows(zoom, 0, zoom->ch);
+
+	amp_busy_ticks += amp_time() - t0;
+	amp_jobs++;
+}
+
+void amp_report_reset(void)
+{
+	amp_busy_ticks = 0;
+	amp_jobs = 0;
+}
+
+void amp_report(void)
+{
+	if (amp_jobs == 0)
+		return;
+
+	xil_printf("AMP report: %d jobs, host build (core 0 only)\r\n", amp_jobs);
+	xil_printf("  core 0: %d us/job busy\r\n", (Xuint32)(amp_busy_ticks / amp_jobs / (AMP_GTIMER_HZ / 1000000)));
+}
+
+int amp_init(void)
+{
+	xil_printf("Host build, processing on core 0 only\r\n");
+	return XST_FAILURE;
+}
+
+void amp_cpu1_main(void)
+{
+}
@@ -0,0 +1,243 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * dmaps_host.c - Host build of the XDmaPs driver calls dma2d.c makes, with
+ * a PL330 that runs a channel program synchronously when it is started.
+ *
+ * The program holds 32-bit addresses, which cannot hold a host pointer.
+ * Buffers a program may touch are registered with mock_dma_region(), and
+ * an address resolves to the registered buffer whose low 32 bits match;
+ * anything else faults the channel, as an unmapped address would.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "xdmaps.h"
+#include "xstatus.h"
+#include "mock.h"
+
+#define MOCK_DMA_REGIONS   64
+#define MOCK_DMA_FIFO      (16 * 8)
+#define MOCK_CS_STOPPED    0x00
+#define MOCK_CS_FAULTING   0x0F
+
+struct struct_mock_region_t {
+	Xuint8 *base;
+	size_t bytes;
+}; typedef struct struct_mock_region_t mock_region_t;
+
+static mock_region_t mock_dma_regions[MOCK_DMA_REGIONS];
+static int mock_dma_next;
+
+static XDmaPs_Config mock_dmac_config = { XPAR_XDMAPS_1_DEVICE_ID, XPAR_XDMAPS_1_BASEADDR };
+static Xuint32 mock_dmac_intstatus;
+static Xuint32 mock_dmac_cs[XDMAPS_CHANNELS_PER_DEV];
+
+// Make a buffer reachable by DMA programs (the oldest registration is
+// dropped when the table is full)
+void mock_dma_region(void *ptr, size_t bytes)
+{
+	mock_dma_regions[mock_dma_next].base = ptr;
+	mock_dma_regions[mock_dma_next].bytes = bytes;
+	mock_dma_next = (mock_dma_next + 1) % MOCK_DMA_REGIONS;
+}
+
+// Host pointer for bytes bytes at a bus address, or NULL. The latest
+// registration wins, so a freed and reallocated buffer resolves correctly.
+static Xuint8 *mock_dma_ptr(Xuint32 addr, int bytes)
+{
+	mock_region_t *r;
+	Xuint8 *p;
+	int i;
+
+	for (i = 1; i <= MOCK_DMA_REGIONS; i++) {
+		r = &mock_dma_regions[(mock_dma_next + MOCK_DMA_REGIONS - i) % MOCK_DMA_REGIONS];
+		if (!r->base)
+			continue;
+		p = (Xuint8 *)((((size_t)r->base) & ~(size_t)0xFFFFFFFF) | addr);
+		if (p >= r->base && p + bytes <= r->base + r->bytes)
+			return p;
+	}
+	return NULL;
+}
+
+static Xuint32 mock_imm32(const Xuint8 *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((Xuint32)p[3] << 24);
+}
+
+// Run a channel program to DMAEND. Returns 0, or -1 on a fault (an
+// unknown instruction or an address outside every registered region).
+static int mock_dmac_run(const Xuint8 *pc)
+{
+	Xuint32 reg[3] = { 0, 0, 0 };           // SAR, CCR, DAR
+	Xuint8 fifo[MOCK_DMA_FIFO];
+	int lc[2] = { 0, 0 };
+	int beats, size, bytes, n;
+	Xuint8 *p;
+
+	for (;;) {
+		switch (pc[0]) {
+		case 0xBC:                      // DMAMOV
+			if (pc[1] > 2)
+				return -1;
+			reg[pc[1]] = mock_imm32(pc + 2);
+			pc += 6;
+			break;
+		case 0x20: case 0x22:           // DMALP
+			lc[(pc[0] >> 1) & 1] = pc[1];
+			pc += 2;
+			break;
+		case 0x38: case 0x3C:           // DMALPEND
+			n = (pc[0] >> 2) & 1;
+			if (lc[n]) {
+				lc[n]--;
+				pc -= pc[1];
+			} else {
+				pc += 2;
+			}
+			break;
+		case 0x04: case 0x08:           // DMALD, DMAST
+			if (pc[0] == 0x04) {
+				beats = ((reg[1] >> 4) & 0xF) + 1;
+				size = 1 << ((reg[1] >> 1) & 7);
+			} else {
+				beats = ((reg[1] >> 18) & 0xF) + 1;
+				size = 1 << ((reg[1] >> 15) & 7);
+			}
+			bytes = beats * size;
+			if (bytes > MOCK_DMA_FIFO)
+				return -1;
+			p = mock_dma_ptr(reg[(pc[0] == 0x04) ? 0 : 2], bytes);
+			if (!p)
+				return -1;
+			if (pc[0] == 0x04) {
+				memcpy(fifo, p, bytes);
+				reg[0] += (reg[1] & 1) ? bytes : 0;
+			} else {
+				memcpy(p, fifo, bytes);
+				reg[2] += (reg[1] & (1 << 14)) ? bytes : 0;
+			}
+			pc++;
+			break;
+		case 0x54: case 0x56:           // DMAADDH
+			reg[(pc[0] & 2) ? 2 : 0] += pc[1] | (pc[2] << 8);
+			pc += 3;
+			break;
+		case 0x13:                      // DMAWMB
+			pc++;
+			break;
+		case 0x34:                      // DMASEV
+			mock_dmac_intstatus |= 1 << (pc[1] >> 3);
+			pc += 2;
+			break;
+		case 0x00:                      // DMAEND
+			return 0;
+		default:
+			return -1;
+		}
+	}
+}
+
+Xuint32 mock_dmac_read(Xuint32 offset)
+{
+	if (offset == XDMAPS_INTSTATUS_OFFSET)
+		return mock_dmac_intstatus;
+	if (offset >= XDmaPs_CSn_OFFSET(0) && offset < XDmaPs_CSn_OFFSET(XDMAPS_CHANNELS_PER_DEV))
+		return mock_dmac_cs[(offset - XDmaPs_CSn_OFFSET(0)) / 8];
+	return 0;
+}
+
+void mock_dmac_write(Xuint32 offset, Xuint32 value)
+{
+	if (offset == XDMAPS_INTCLR_OFFSET)
+		mock_dmac_intstatus &= ~value;
+}
+
+XDmaPs_Config *XDmaPs_LookupConfig(u16 DeviceId)
+{
+	return (DeviceId == mock_dmac_config.DeviceId) ? &mock_dmac_config : NULL;
+}
+
+int XDmaPs_CfgInitialize(XDmaPs *InstPtr, XDmaPs_Config *Config, u32 EffectiveAddr)
+{
+	unsigned channel;
+
+	memset(InstPtr, 0, sizeof(*InstPtr));
+	InstPtr->Config.DeviceId = Config->DeviceId;
+	InstPtr->Config.BaseAddress = EffectiveAddr;
+	for (channel = 0; channel < XDMAPS_CHANNELS_PER_DEV; channel++) {
+		InstPtr->Chans[channel].ChanId = channel;
+		InstPtr->Chans[channel].DevId = Config->DeviceId;
+	}
+	mock_dmac_intstatus = 0;
+	memset(mock_dmac_cs, 0, sizeof(mock_dmac_cs));
+	InstPtr->IsReady = 1;
+	return XST_SUCCESS;
+}
+
+int XDmaPs_IsActive(XDmaPs *InstPtr, unsigned int Channel)
+{
+	return InstPtr->Chans[Channel].DmaCmdToHw != NULL;
+}
+
+// Only user programs (the one kind dma2d.c starts)
+int XDmaPs_Start(XDmaPs *InstPtr, unsigned int Channel, XDmaPs_Cmd *Cmd, int HoldDmaProg)
+{
+	u64 t0;
+
+	Cmd->DmaStatus = XST_FAILURE;
+	if (XDmaPs_IsActive(InstPtr, Channel))
+		return XST_DEVICE_BUSY;
+	if (!Cmd->UserDmaProg)
+		return XST_FAILURE;
+
+	InstPtr->Chans[Channel].DmaCmdToHw = Cmd;
+	t0 = mock_ns();
+	mock_dmac_cs[Channel] = mock_dmac_run(Cmd->UserDmaProg) ? MOCK_CS_FAULTING : MOCK_CS_STOPPED;
+	mock_stats.dma_ns += mock_ns() - t0;
+	return XST_SUCCESS;
+}
+
+int XDmaPs_ResetChannel(XDmaPs *InstPtr, unsigned int Channel)
+{
+	mock_dmac_cs[Channel] = MOCK_CS_STOPPED;
+	return XST_SUCCESS;
+}
+
+int XDmaPs_SetDoneHandler(XDmaPs *InstPtr, unsigned Channel, XDmaPsDoneHandler DoneHandler, void *CallbackRef)
+{
+	InstPtr->Chans[Channel].DoneHandler = DoneHandler;
+	InstPtr->Chans[Channel].DoneRef = CallbackRef;
+	return XST_SUCCESS;
+}
+
+static void mock_dmac_done(XDmaPs *InstPtr, unsigned Channel)
+{
+	XDmaPs_ChannelData *chan = &InstPtr->Chans[Channel];
+	XDmaPs_Cmd *cmd = chan->DmaCmdToHw;
+
+	mock_dmac_intstatus &= ~(1 << Channel);
+	if (cmd) {
+		cmd->DmaStatus = 0;
+		chan->DmaCmdToHw = NULL;
+		chan->DmaCmdFromHw = cmd;
+		if (chan->DoneHandler)
+			chan->DoneHandler(Channel, cmd, chan->DoneRef);
+	}
+}
+
+void XDmaPs_DoneISR_0(XDmaPs *InstPtr) { mock_dmac_done(InstPtr, 0); }
+void XDmaPs_DoneISR_1(XDmaPs *InstPtr) { mock_dmac_done(InstPtr, 1); }
+void XDmaPs_DoneISR_2(XDmaPs *InstPtr) { mock_dmac_done(InstPtr, 2); }
+void XDmaPs_DoneISR_3(XDmaPs *InstPtr) { mock_dmac_done(InstPtr, 3); }
+void XDmaPs_DoneISR_4(XDmaPs *InstPtr) { mock_dmac_done(InstPtr, 4); }
+void XDmaPs_DoneISR_5(XDmaPs *InstPtr) { mock_dmac_done(InstPtr, 5); }
+void XDmaPs_DoneISR_6(XDmaPs *InstPtr) { mock_dmac_done(InstPtr, 6); }
+void XDmaPs_DoneISR_7(XDmaPs *InstPtr) { mock_dmac_done(InstPtr, 7); }
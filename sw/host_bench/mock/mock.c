@@ -0,0 +1,167 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * mock.c - Host implementations of the Xilinx BSP calls the camera
+ * processing code makes: register access, cache maintenance, MMU setup,
+ * the VITA-2000 exposure controls and xil_printf.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include "xil_io.h"
+#include "xil_cache.h"
+#include "xil_mmu.h"
+#include "xil_printf.h"
+#include "xaxivdma_hw.h"
+#include "xscugic.h"
+#include "fmc_imageon_vita_receiver.h"
+#include "amp.h"
+#include "mock.h"
+
+mock_stats_t mock_stats;
+
+static Xuint32 mock_vdma_base;
+static u32 mock_vdma_reg[MOCK_VDMA_REGS / 4];
+static Xuint16 *mock_vdma_store[MOCK_VDMA_NUM_FRAMES];
+
+u64 mock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Host stand-in for the PMU cycle counter, one count per nanosecond
+Xuint32 mock_cycles(void)
+{
+	return (Xuint32)mock_ns();
+}
+
+// Global timer count at the board's rate
+static u64 mock_gtimer(void)
+{
+	u64 ns = mock_ns();
+
+	return (ns / 1000000000ULL) * AMP_GTIMER_HZ + (ns % 1000000000ULL) * AMP_GTIMER_HZ / 1000000000ULL;
+}
+
+// Allocate the frame stores and load their addresses into both channels'
+// start address registers, as camera_config_init()/fmc_imageon_enable() do
+void mock_vdma_init(Xuint32 base_addr, int frame_bytes)
+{
+	int i;
+
+	mock_vdma_base = base_addr;
+	memset(mock_vdma_reg, 0, sizeof(mock_vdma_reg));
+	for (i = 0; i < MOCK_VDMA_NUM_FRAMES; i++) {
+		free(mock_vdma_store[i]);
+		mock_vdma_store[i] = calloc(1, frame_bytes);
+		if (!mock_vdma_store[i]) {
+			fprintf(stderr, "mock: out of memory for frame store %d\n", i);
+			exit(1);
+		}
+		mock_dma_region(mock_vdma_store[i], frame_bytes);
+		mock_vdma_reg[(XAXIVDMA_MM2S_ADDR_OFFSET + XAXIVDMA_START_ADDR_OFFSET) / 4 + i] = (u32)mock_vdma_store[i];
+		mock_vdma_reg[(XAXIVDMA_S2MM_ADDR_OFFSET + XAXIVDMA_START_ADDR_OFFSET) / 4 + i] = (u32)mock_vdma_store[i];
+	}
+}
+
+Xuint16 *mock_vdma_frame(int index)
+{
+	return mock_vdma_store[index];
+}
+
+void mock_reset_stats(void)
+{
+	memset(&mock_stats, 0, sizeof(mock_stats));
+}
+
+u32 Xil_In32(u32 Addr)
+{
+	if (Addr == AMP_GTIMER_BASE + 0x0)
+		return (Xuint32)mock_gtimer();
+	if (Addr == AMP_GTIMER_BASE + 0x4)
+		return (Xuint32)(mock_gtimer() >> 32);
+	if (Addr >= mock_vdma_base && Addr < mock_vdma_base + MOCK_VDMA_REGS)
+		return mock_vdma_reg[(Addr - mock_vdma_base) / 4];
+	if (Addr >= XPAR_XDMAPS_1_BASEADDR && Addr <= XPAR_XDMAPS_1_HIGHADDR)
+		return mock_dmac_read(Addr - XPAR_XDMAPS_1_BASEADDR);
+
+	return 0;
+}
+
+void Xil_Out32(u32 Addr, u32 Value)
+{
+	if (Addr >= mock_vdma_base && Addr < mock_vdma_base + MOCK_VDMA_REGS)
+		mock_vdma_reg[(Addr - mock_vdma_base) / 4] = Value;
+	else if (Addr >= XPAR_XDMAPS_1_BASEADDR && Addr <= XPAR_XDMAPS_1_HIGHADDR)
+		mock_dmac_write(Addr - XPAR_XDMAPS_1_BASEADDR, Value);
+}
+
+void Xil_DCacheFlush(void)
+{
+	mock_stats.full_flushes++;
+}
+
+void Xil_DCacheFlushRange(unsigned int adr, unsigned len)
+{
+	mock_stats.flush_bytes += len;
+}
+
+void Xil_DCacheInvalidateRange(unsigned int adr, unsigned len)
+{
+	mock_stats.invalidate_bytes += len;
+}
+
+void Xil_SetTlbAttributes(u32 addr, u32 attrib)
+{
+}
+
+// No interrupts on the host: nothing is ever connected
+int XScuGic_Connect(XScuGic *InstancePtr, u32 Int_Id, Xil_InterruptHandler Handler, void *CallBackRef)
+{
+	return XST_FAILURE;
+}
+
+void XScuGic_Enable(XScuGic *InstancePtr, u32 Int_Id)
+{
+}
+
+// VITA-2000 controls: the settings are kept in the receiver context, as
+// the real driver does for the gains
+int fmc_imageon_vita_receiver_set_exposure_time(fmc_imageon_vita_receiver_t *pContext, Xuint32 exposureTime, int bVerbose)
+{
+	pContext->uExposureTime = exposureTime;
+	return 0;
+}
+
+int fmc_imageon_vita_receiver_set_analog_gain(fmc_imageon_vita_receiver_t *pContext, Xuint32 uAnalogGain, int bVerbose)
+{
+	pContext->uAnalogGain = (uAnalogGain > 10) ? 10 : uAnalogGain;
+	return 0;
+}
+
+int fmc_imageon_vita_receiver_set_digital_gain(fmc_imageon_vita_receiver_t *pContext, Xuint32 uDigitalGain, int bVerbose)
+{
+	pContext->uDigitalGain = (uDigitalGain > 4095) ? 4095 : uDigitalGain;
+	return 0;
+}
+
+void xil_printf(const char *ctrl1, ...)
+{
+	va_list args;
+
+	va_start(args, ctrl1);
+	vprintf(ctrl1, args);
+	va_end(args);
+}
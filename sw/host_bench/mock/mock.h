@@ -0,0 +1,57 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * mock.h - Fake Zynq peripherals for the host build of the camera code.
+ *
+ *
+ * NOTES:
+ * Xil_In32()/Xil_Out32() (and so XAxiVdma_ReadReg()/WriteReg()) go to a
+ * register file for the HDMI VDMA and to the Cortex-A9 global timer,
+ * which counts host time at the board's rate. Frame stores are host
+ * buffers whose addresses sit in the VDMA start address registers, as
+ * on the board. The cache maintenance calls only count bytes. The PS DMA
+ * controller's registers go to dmaps_host.c.
+ *****************************************************************************/
+
+#ifndef __MOCK_H__
+#define __MOCK_H__
+
+#include <stddef.h>
+#include <xbasic_types.h>
+#include <xil_types.h>
+
+#define MOCK_VDMA_NUM_FRAMES 3
+#define MOCK_VDMA_REGS       0x100
+
+struct struct_mock_stats_t {
+	u64 flush_bytes;
+	u64 invalidate_bytes;
+	Xuint32 full_flushes;
+	u64 dma_ns;                     // running PL330 channel programs
+}; typedef struct struct_mock_stats_t mock_stats_t;
+
+extern mock_stats_t mock_stats;
+
+// The BSP's xil_printf.h, for the vendored sources that call it without
+// including it
+void xil_printf(const char *ctrl1, ...);
+
+// Function prototypes (mock.c)
+u64 mock_ns(void);
+Xuint32 mock_cycles(void);
+void mock_vdma_init(Xuint32 base_addr, int frame_bytes);
+Xuint16 *mock_vdma_frame(int index);
+void mock_reset_stats(void);
+
+// Function prototypes (dmaps_host.c)
+void mock_dma_region(void *ptr, size_t bytes);
+Xuint32 mock_dmac_read(Xuint32 offset);
+void mock_dmac_write(Xuint32 offset, Xuint32 value);
+
+#endif // __MOCK_H__
@@ -0,0 +1,489 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * arm_neon.h - Host stand-in for the NEON intrinsics the camera kernels use.
+ *
+ *
+ * NOTES:
+ * "make NEON=1" puts this directory on the include path and defines
+ * __ARM_NEON, so the kernels build their NEON paths on the host and the
+ * bench checks them against the scalar references. Every vector is a
+ * struct of lanes and every intrinsic a loop over them, following the
+ * ARM definitions (widths, saturation, rounding); only the intrinsics the
+ * kernels call are here. It checks what the kernels compute, not how fast
+ * they are: the timings of a NEON=1 build mean nothing.
+ *****************************************************************************/
+
+#ifndef __MOCK_ARM_NEON_H__
+#define __MOCK_ARM_NEON_H__
+
+#include <stdint.h>
+
+typedef struct { uint8_t v[8]; } uint8x8_t;
+typedef struct { uint8_t v[16]; } uint8x16_t;
+typedef struct { int16_t v[4]; } int16x4_t;
+typedef struct { int16_t v[8]; } int16x8_t;
+typedef struct { uint16_t v[4]; } uint16x4_t;
+typedef struct { uint16_t v[8]; } uint16x8_t;
+typedef struct { int32_t v[4]; } int32x4_t;
+typedef struct { uint32_t v[4]; } uint32x4_t;
+typedef struct { uint16x8_t val[2]; } uint16x8x2_t;
+
+#define NEON_LANES(n) for (int i = 0; i < (n); i++)
+
+static inline int32_t neon_sat(int32_t x, int32_t lo, int32_t hi)
+{
+	return x < lo ? lo : x > hi ? hi : x;
+}
+
+// Loads, stores, duplicates
+static inline uint8x16_t vld1q_u8(const uint8_t *p)
+{
+	uint8x16_t r;
+	NEON_LANES(16) r.v[i] = p[i];
+	return r;
+}
+
+static inline uint16x8_t vld1q_u16(const uint16_t *p)
+{
+	uint16x8_t r;
+	NEON_LANES(8) r.v[i] = p[i];
+	return r;
+}
+
+static inline int32x4_t vld1q_s32(const int32_t *p)
+{
+	int32x4_t r;
+	NEON_LANES(4) r.v[i] = p[i];
+	return r;
+}
+
+static inline void vst1q_u8(uint8_t *p, uint8x16_t a)
+{
+	NEON_LANES(16) p[i] = a.v[i];
+}
+
+static inline void vst1q_u16(uint16_t *p, uint16x8_t a)
+{
+	NEON_LANES(8) p[i] = a.v[i];
+}
+
+static inline uint16x8x2_t vld2q_u16(const uint16_t *p)
+{
+	uint16x8x2_t r;
+	NEON_LANES(8) {
+		r.val[0].v[i] = p[2 * i];
+		r.val[1].v[i] = p[2 * i + 1];
+	}
+	return r;
+}
+
+static inline void vst2q_u16(uint16_t *p, uint16x8x2_t a)
+{
+	NEON_LANES(8) {
+		p[2 * i] = a.val[0].v[i];
+		p[2 * i + 1] = a.val[1].v[i];
+	}
+}
+
+static inline uint8x8_t vdup_n_u8(uint8_t x)
+{
+	uint8x8_t r;
+	NEON_LANES(8) r.v[i] = x;
+	return r;
+}
+
+static inline uint8x16_t vdupq_n_u8(uint8_t x)
+{
+	uint8x16_t r;
+	NEON_LANES(16) r.v[i] = x;
+	return r;
+}
+
+static inline int16x8_t vdupq_n_s16(int16_t x)
+{
+	int16x8_t r;
+	NEON_LANES(8) r.v[i] = x;
+	return r;
+}
+
+static inline uint16x8_t vdupq_n_u16(uint16_t x)
+{
+	uint16x8_t r;
+	NEON_LANES(8) r.v[i] = x;
+	return r;
+}
+
+static inline int32x4_t vdupq_n_s32(int32_t x)
+{
+	int32x4_t r;
+	NEON_LANES(4) r.v[i] = x;
+	return r;
+}
+
+static inline uint32x4_t vdupq_n_u32(uint32_t x)
+{
+	uint32x4_t r;
+	NEON_LANES(4) r.v[i] = x;
+	return r;
+}
+
+#define vgetq_lane_u32(a, n) ((a).v[n])
+
+// Halves, widening, narrowing, reinterpreting
+static inline int16x4_t vget_low_s16(int16x8_t a)
+{
+	int16x4_t r;
+	NEON_LANES(4) r.v[i] = a.v[i];
+	return r;
+}
+
+static inline int16x4_t vget_high_s16(int16x8_t a)
+{
+	int16x4_t r;
+	NEON_LANES(4) r.v[i] = a.v[i + 4];
+	return r;
+}
+
+static inline uint16x4_t vget_low_u16(uint16x8_t a)
+{
+	uint16x4_t r;
+	NEON_LANES(4) r.v[i] = a.v[i];
+	return r;
+}
+
+static inline uint16x4_t vget_high_u16(uint16x8_t a)
+{
+	uint16x4_t r;
+	NEON_LANES(4) r.v[i] = a.v[i + 4];
+	return r;
+}
+
+static inline uint8x16_t vcombine_u8(uint8x8_t a, uint8x8_t b)
+{
+	uint8x16_t r;
+	NEON_LANES(8) {
+		r.v[i] = a.v[i];
+		r.v[i + 8] = b.v[i];
+	}
+	return r;
+}
+
+static inline uint16x8_t vcombine_u16(uint16x4_t a, uint16x4_t b)
+{
+	uint16x8_t r;
+	NEON_LANES(4) {
+		r.v[i] = a.v[i];
+		r.v[i + 4] = b.v[i];
+	}
+	return r;
+}
+
+static inline uint16x8_t vmovl_u8(uint8x8_t a)
+{
+	uint16x8_t r;
+	NEON_LANES(8) r.v[i] = a.v[i];
+	return r;
+}
+
+static inline uint32x4_t vmovl_u16(uint16x4_t a)
+{
+	uint32x4_t r;
+	NEON_LANES(4) r.v[i] = a.v[i];
+	return r;
+}
+
+static inline uint8x8_t vmovn_u16(uint16x8_t a)
+{
+	uint8x8_t r;
+	NEON_LANES(8) r.v[i] = (uint8_t)a.v[i];
+	return r;
+}
+
+static inline uint16x4_t vmovn_u32(uint32x4_t a)
+{
+	uint16x4_t r;
+	NEON_LANES(4) r.v[i] = (uint16_t)a.v[i];
+	return r;
+}
+
+static inline uint8x8_t vqmovun_s16(int16x8_t a)
+{
+	uint8x8_t r;
+	NEON_LANES(8) r.v[i] = neon_sat(a.v[i], 0, 255);
+	return r;
+}
+
+static inline uint16x4_t vqmovun_s32(int32x4_t a)
+{
+	uint16x4_t r;
+	NEON_LANES(4) r.v[i] = neon_sat(a.v[i], 0, 65535);
+	return r;
+}
+
+static inline int16x8_t vreinterpretq_s16_u16(uint16x8_t a)
+{
+	int16x8_t r;
+	NEON_LANES(8) r.v[i] = (int16_t)a.v[i];
+	return r;
+}
+
+static inline uint16x8_t vreinterpretq_u16_s16(int16x8_t a)
+{
+	uint16x8_t r;
+	NEON_LANES(8) r.v[i] = (uint16_t)a.v[i];
+	return r;
+}
+
+static inline int32x4_t vreinterpretq_s32_u32(uint32x4_t a)
+{
+	int32x4_t r;
+	NEON_LANES(4) r.v[i] = (int32_t)a.v[i];
+	return r;
+}
+
+// Arithmetic and logic
+static inline uint8x16_t vaddq_u8(uint8x16_t a, uint8x16_t b)
+{
+	NEON_LANES(16) a.v[i] += b.v[i];
+	return a;
+}
+
+static inline uint8x16_t vsubq_u8(uint8x16_t a, uint8x16_t b)
+{
+	NEON_LANES(16) a.v[i] -= b.v[i];
+	return a;
+}
+
+static inline uint8x16_t vandq_u8(uint8x16_t a, uint8x16_t b)
+{
+	NEON_LANES(16) a.v[i] &= b.v[i];
+	return a;
+}
+
+static inline uint8x16_t veorq_u8(uint8x16_t a, uint8x16_t b)
+{
+	NEON_LANES(16) a.v[i] ^= b.v[i];
+	return a;
+}
+
+static inline int16x8_t vaddq_s16(int16x8_t a, int16x8_t b)
+{
+	NEON_LANES(8) a.v[i] += b.v[i];
+	return a;
+}
+
+static inline int16x8_t vmaxq_s16(int16x8_t a, int16x8_t b)
+{
+	NEON_LANES(8) a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+	return a;
+}
+
+static inline int16x8_t vmulq_n_s16(int16x8_t a, int16_t b)
+{
+	NEON_LANES(8) a.v[i] *= b;
+	return a;
+}
+
+static inline int16x8_t vmlaq_n_s16(int16x8_t acc, int16x8_t a, int16_t b)
+{
+	NEON_LANES(8) acc.v[i] += a.v[i] * b;
+	return acc;
+}
+
+static inline uint16x8_t vaddq_u16(uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) a.v[i] += b.v[i];
+	return a;
+}
+
+static inline uint16x8_t vsubq_u16(uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) a.v[i] -= b.v[i];
+	return a;
+}
+
+static inline uint16x8_t vqsubq_u16(uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) a.v[i] = a.v[i] > b.v[i] ? a.v[i] - b.v[i] : 0;
+	return a;
+}
+
+static inline uint16x8_t vabdq_u16(uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) a.v[i] = a.v[i] > b.v[i] ? a.v[i] - b.v[i] : b.v[i] - a.v[i];
+	return a;
+}
+
+static inline uint16x8_t vhaddq_u16(uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) a.v[i] = ((uint32_t)a.v[i] + b.v[i]) >> 1;
+	return a;
+}
+
+static inline uint16x8_t vrhaddq_u16(uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) a.v[i] = ((uint32_t)a.v[i] + b.v[i] + 1) >> 1;
+	return a;
+}
+
+static inline uint16x8_t vmaxq_u16(uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+	return a;
+}
+
+static inline uint16x8_t vminq_u16(uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+	return a;
+}
+
+static inline uint16x8_t vmulq_u16(uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) a.v[i] = (uint16_t)(a.v[i] * b.v[i]);
+	return a;
+}
+
+static inline uint16x8_t vmlaq_u16(uint16x8_t acc, uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) acc.v[i] = (uint16_t)(acc.v[i] + a.v[i] * b.v[i]);
+	return acc;
+}
+
+static inline uint16x8_t vmlaq_n_u16(uint16x8_t acc, uint16x8_t a, uint16_t b)
+{
+	NEON_LANES(8) acc.v[i] = (uint16_t)(acc.v[i] + a.v[i] * b);
+	return acc;
+}
+
+static inline uint16x8_t vandq_u16(uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) a.v[i] &= b.v[i];
+	return a;
+}
+
+static inline uint16x8_t vorrq_u16(uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) a.v[i] |= b.v[i];
+	return a;
+}
+
+static inline uint16x8_t vbicq_u16(uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) a.v[i] &= ~b.v[i];
+	return a;
+}
+
+static inline uint16x8_t vcgeq_u16(uint16x8_t a, uint16x8_t b)
+{
+	NEON_LANES(8) a.v[i] = a.v[i] >= b.v[i] ? 0xFFFF : 0;
+	return a;
+}
+
+static inline int32x4_t vaddq_s32(int32x4_t a, int32x4_t b)
+{
+	NEON_LANES(4) a.v[i] += b.v[i];
+	return a;
+}
+
+static inline int32x4_t vsubq_s32(int32x4_t a, int32x4_t b)
+{
+	NEON_LANES(4) a.v[i] -= b.v[i];
+	return a;
+}
+
+static inline int32x4_t vminq_s32(int32x4_t a, int32x4_t b)
+{
+	NEON_LANES(4) a.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+	return a;
+}
+
+static inline int32x4_t vmulq_n_s32(int32x4_t a, int32_t b)
+{
+	NEON_LANES(4) a.v[i] *= b;
+	return a;
+}
+
+static inline int32x4_t vmlaq_n_s32(int32x4_t acc, int32x4_t a, int32_t b)
+{
+	NEON_LANES(4) acc.v[i] += a.v[i] * b;
+	return acc;
+}
+
+static inline int32x4_t vmlal_n_s16(int32x4_t acc, int16x4_t a, int16_t b)
+{
+	NEON_LANES(4) acc.v[i] += (int32_t)a.v[i] * b;
+	return acc;
+}
+
+static inline uint32x4_t vpadalq_u16(uint32x4_t acc, uint16x8_t a)
+{
+	NEON_LANES(4) acc.v[i] += (uint32_t)a.v[2 * i] + a.v[2 * i + 1];
+	return acc;
+}
+
+// Shifts by a register: negative is right, 32 or more clears the lane
+static inline uint32x4_t vshlq_u32(uint32x4_t a, int32x4_t s)
+{
+	NEON_LANES(4) {
+		if (s.v[i] >= 0)
+			a.v[i] = s.v[i] >= 32 ? 0 : a.v[i] << s.v[i];
+		else
+			a.v[i] = -s.v[i] >= 32 ? 0 : a.v[i] >> -s.v[i];
+	}
+	return a;
+}
+
+static inline int32x4_t vshlq_s32(int32x4_t a, int32x4_t s)
+{
+	NEON_LANES(4) {
+		if (s.v[i] >= 0)
+			a.v[i] = s.v[i] >= 32 ? 0 : (int32_t)((uint32_t)a.v[i] << s.v[i]);
+		else
+			a.v[i] = -s.v[i] >= 32 ? (a.v[i] >> 31) : a.v[i] >> -s.v[i];
+	}
+	return a;
+}
+
+// Shifts by an immediate (macros, as the immediates must be constants)
+#define NEON_SHIFT(type, lanes, a, expr) \
+	({ \
+		type _r = (a); \
+		NEON_LANES(lanes) { _r.v[i] = (expr); } \
+		_r; \
+	})
+
+#define vshrq_n_u8(a, n)   NEON_SHIFT(uint8x16_t, 16, a, _r.v[i] >> (n))
+#define vshrq_n_u16(a, n)  NEON_SHIFT(uint16x8_t, 8, a, _r.v[i] >> (n))
+#define vshlq_n_u16(a, n)  NEON_SHIFT(uint16x8_t, 8, a, (uint16_t)(_r.v[i] << (n)))
+#define vshlq_n_s16(a, n)  NEON_SHIFT(int16x8_t, 8, a, (int16_t)(_r.v[i] << (n)))
+#define vshrq_n_s32(a, n)  NEON_SHIFT(int32x4_t, 4, a, _r.v[i] >> (n))
+#define vrshrq_n_u16(a, n) NEON_SHIFT(uint16x8_t, 8, a, (uint16_t)(((uint32_t)_r.v[i] + (1u << ((n) - 1))) >> (n)))
+#define vrshrq_n_s16(a, n) NEON_SHIFT(int16x8_t, 8, a, (int16_t)(((int32_t)_r.v[i] + (1 << ((n) - 1))) >> (n)))
+#define vrshrq_n_s32(a, n) NEON_SHIFT(int32x4_t, 4, a, (int32_t)(((int64_t)_r.v[i] + (1 << ((n) - 1))) >> (n)))
+
+// Shift right, saturating to unsigned and narrowing
+#define vqshrun_n_s32(a, n) \
+	({ \
+		int32x4_t _a = (a); \
+		uint16x4_t _r; \
+		NEON_LANES(4) { _r.v[i] = neon_sat(_a.v[i] >> (n), 0, 65535); } \
+		_r; \
+	})
+
+// Shift b left and insert it, keeping the low n bits of a
+#define vsliq_n_u16(a, b, n) \
+	({ \
+		uint16x8_t _a = (a), _b = (b); \
+		NEON_LANES(8) { _a.v[i] = (uint16_t)((_b.v[i] << (n)) | (_a.v[i] & ((1u << (n)) - 1))); } \
+		_a; \
+	})
+
+#endif // __MOCK_ARM_NEON_H__
@@ -0,0 +1,20 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * rgb2ycrcb_host.c - Host build of the BSP's rgb2ycrcb.c, which csc.c
+ * takes its coefficient tables from.
+ *
+ * The driver is vendored and not changed here. Its tables are
+ * initialised flat, which -Wall warns about, so that one warning is
+ * turned off for it alone; the rest of the bench builds with -Wall as is.
+ *****************************************************************************/
+
+#pragma GCC diagnostic ignored "-Wmissing-braces"
+
+#include "../../system_bsp/ps7_cortexa9_0/libsrc/rgb2ycrcb_v5_00_a/src/rgb2ycrcb.c"
@@ -0,0 +1,37 @@
+/*****************************************************************************
+ * Joseph Zambreno
+ * Phillip Jones
+ *
+ * Department of Electrical and Computer Engineering
+ * Iowa State University
+ *****************************************************************************/
+
+/*****************************************************************************
+ * xpseudo_asm.h - Host stand-in for the BSP's CP15 and barrier macros.
+ *
+ *
+ * NOTES:
+ * The Makefile force-includes this file ahead of everything else, so the
+ * BSP's xpseudo_asm_gcc.h (ARM inline assembly) is skipped by its include
+ * guard. Every CP15 register reads back as a free-running host cycle
+ * count (nanoseconds); writes are ignored.
+ *****************************************************************************/
+
+#ifndef __MOCK_XPSEUDO_ASM_H__
+#define __MOCK_XPSEUDO_ASM_H__
+
+#define XPSEUDO_ASM_GCC_H
+
+#include "xreg_cortexa9.h"
+#include "mock.h"
+
+#define mfcp(rn)        mock_cycles()
+#define mtcp(rn, v)     ((void)(v))
+#define mfcpsr()        0
+#define mtcpsr(v)       ((void)(v))
+
+#define isb()
+#define dsb()
+#define dmb()
+
+#endif // __MOCK_XPSEUDO_ASM_H__
@@ -181,7 +181,7 @@
 #define XPAR_BTNS_5BITS_BASEADDR 0x41200000
 #define XPAR_BTNS_5BITS_HIGHADDR 0x4120FFFF
 #define XPAR_BTNS_5BITS_DEVICE_ID 0
-#define XPAR_BTNS_5BITS_INTERRUPT_PRESENT 0
+#define XPAR_BTNS_5BITS_INTERRUPT_PRESENT 1
 #define XPAR_BTNS_5BITS_IS_DUAL 0
 
 
@@ -189,7 +189,7 @@
 #define XPAR_SWS_8BITS_BASEADDR 0x41240000
 #define XPAR_SWS_8BITS_HIGHADDR 0x4124FFFF
 #define XPAR_SWS_8BITS_DEVICE_ID 1
-#define XPAR_SWS_8BITS_INTERRUPT_PRESENT 0
+#define XPAR_SWS_8BITS_INTERRUPT_PRESENT 1
 #define XPAR_SWS_8BITS_IS_DUAL 0
 
 
@@ -199,14 +199,14 @@
 #define XPAR_GPIO_0_BASEADDR 0x41200000
 #define XPAR_GPIO_0_HIGHADDR 0x4120FFFF
 #define XPAR_GPIO_0_DEVICE_ID XPAR_BTNS_5BITS_DEVICE_ID
-#define XPAR_GPIO_0_INTERRUPT_PRESENT 0
+#define XPAR_GPIO_0_INTERRUPT_PRESENT 1
 #define XPAR_GPIO_0_IS_DUAL 0
 
 /* Canonical definitions for peripheral SWS_8BITS */
 #define XPAR_GPIO_1_BASEADDR 0x41240000
 #define XPAR_GPIO_1_HIGHADDR 0x4124FFFF
 #define XPAR_GPIO_1_DEVICE_ID XPAR_SWS_8BITS_DEVICE_ID
-#define XPAR_GPIO_1_INTERRUPT_PRESENT 0
+#define XPAR_GPIO_1_INTERRUPT_PRESENT 1
 #define XPAR_GPIO_1_IS_DUAL 0
 
 
@@ -384,10 +384,16 @@
 /******************************************************************/
 
 /* Definitions for Fabric interrupts connected to ps7_scugic_0 */
+#define XPAR_FABRIC_AXI_VDMA_0_S2MM_INTROUT_INTR 61
+#define XPAR_FABRIC_BTNS_5BITS_IP2INTC_IRPT_INTR 62
+#define XPAR_FABRIC_SWS_8BITS_IP2INTC_IRPT_INTR 63
 
 /******************************************************************/
 
 /* Canonical definitions for Fabric interrupts connected to ps7_scugic_0 */
+#define XPAR_FABRIC_AXIVDMA_0_S2MM_INTROUT_VEC_ID XPAR_FABRIC_AXI_VDMA_0_S2MM_INTROUT_INTR
+#define XPAR_FABRIC_GPIO_0_VEC_ID XPAR_FABRIC_BTNS_5BITS_IP2INTC_IRPT_INTR
+#define XPAR_FABRIC_GPIO_1_VEC_ID XPAR_FABRIC_SWS_8BITS_IP2INTC_IRPT_INTR
 
 /******************************************************************/
 